@@ -0,0 +1,239 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <omp.h>
+#include <boost/program_options.hpp>
+
+#include "pq_flash_index.h"
+#include "linux_aligned_file_reader.h"
+#include "percentile_stats.h"
+#include "filter_utils.h"
+#include "utils.h"
+#include "program_options_utils.hpp"
+
+namespace po = boost::program_options;
+
+// Runs the same disk search workload once per I/O backend and beam width and
+// reports throughput and tail latency, so backends can be compared directly.
+template <typename T>
+int benchmark_disk_io(diskann::Metric &metric, const std::string &index_path_prefix, const std::string &query_file,
+                      const std::vector<std::string> &io_backends, const std::vector<uint32_t> &beam_widths,
+                      const uint32_t num_threads, const uint32_t recall_at, const uint32_t L,
+                      const uint32_t num_nodes_to_cache, const bool pipelined, const std::string &warmup_query_file,
+                      const std::string &warmup_filters_file, const uint32_t cache_budget_mb,
+                      const bool adaptive_beam_width, const float io_budget_factor)
+{
+    T *query = nullptr;
+    size_t query_num, query_dim, query_aligned_dim;
+    diskann::load_aligned_bin<T>(query_file, query, query_num, query_dim, query_aligned_dim);
+
+    std::vector<uint64_t> query_result_ids(recall_at * query_num);
+    std::vector<float> query_result_dists(recall_at * query_num);
+
+    std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    std::cout.precision(2);
+    std::cout << std::setw(16) << "Backend" << std::setw(6) << "BW" << std::setw(12) << "QPS" << std::setw(14)
+              << "Mean Lat(us)" << std::setw(14) << "P99 Lat(us)" << std::setw(12) << "Mean IOs" << std::setw(14)
+              << "Mean IO(us)" << std::setw(14) << "Cache hits" << std::setw(10) << "Mean BW" << std::endl;
+
+    for (const auto &io_backend : io_backends)
+    {
+        std::shared_ptr<AlignedFileReader> reader = create_linux_aligned_file_reader(io_backend);
+        std::unique_ptr<diskann::PQFlashIndex<T>> index(new diskann::PQFlashIndex<T>(reader, metric));
+        if (index->load(num_threads, index_path_prefix.c_str()) != 0)
+        {
+            diskann::cerr << "Unable to load index with I/O backend " << io_backend << std::endl;
+            diskann::aligned_free(query);
+            return -1;
+        }
+
+        index->set_pipelined_search(pipelined);
+        index->set_adaptive_search(adaptive_beam_width, io_budget_factor);
+
+        std::vector<uint32_t> node_list;
+        if (!warmup_query_file.empty() && cache_budget_mb > 0)
+        {
+            std::vector<std::vector<std::string>> warmup_filters;
+            if (!warmup_filters_file.empty())
+                load_sparse_matrix(warmup_filters_file, warmup_filters);
+            index->generate_cache_list_from_filtered_sample_queries(warmup_query_file, warmup_filters, 15, 4,
+                                                                    (uint64_t)cache_budget_mb * 1024 * 1024,
+                                                                    num_threads, node_list);
+        }
+        else
+        {
+            index->cache_bfs_levels(num_nodes_to_cache, node_list);
+        }
+        index->load_cache_list(node_list);
+
+        omp_set_num_threads(num_threads);
+        for (const auto beam_width : beam_widths)
+        {
+            std::vector<diskann::QueryStats> stats(query_num);
+            auto start = std::chrono::high_resolution_clock::now();
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int64_t i = 0; i < (int64_t)query_num; i++)
+            {
+                index->cached_beam_search(query + i * query_aligned_dim, recall_at, L,
+                                          query_result_ids.data() + i * recall_at,
+                                          query_result_dists.data() + i * recall_at, beam_width, false, &stats[i]);
+            }
+            std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+
+            double qps = query_num / diff.count();
+            double mean_latency = diskann::get_mean_stats<float>(
+                stats.data(), query_num, [](const diskann::QueryStats &s) { return s.total_us; });
+            float p99_latency = diskann::get_percentile_stats<float>(
+                stats.data(), query_num, 0.99f, [](const diskann::QueryStats &s) { return s.total_us; });
+            double mean_ios = diskann::get_mean_stats<uint32_t>(
+                stats.data(), query_num, [](const diskann::QueryStats &s) { return s.n_ios; });
+            double mean_io_us = diskann::get_mean_stats<float>(stats.data(), query_num,
+                                                               [](const diskann::QueryStats &s) { return s.io_us; });
+            double mean_cache_hits = diskann::get_mean_stats<uint32_t>(
+                stats.data(), query_num, [](const diskann::QueryStats &s) { return s.n_cache_hits; });
+            double mean_beam_width = diskann::get_mean_stats<float>(
+                stats.data(), query_num, [](const diskann::QueryStats &s) { return s.mean_beam_width; });
+
+            std::cout << std::setw(16) << io_backend << std::setw(6) << beam_width << std::setw(12) << qps
+                      << std::setw(14) << mean_latency << std::setw(14) << p99_latency << std::setw(12) << mean_ios
+                      << std::setw(14) << mean_io_us << std::setw(14) << mean_cache_hits << std::setw(10)
+                      << mean_beam_width << std::endl;
+        }
+    }
+
+    diskann::aligned_free(query);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_type, dist_fn, index_path_prefix, query_file;
+    std::string warmup_query_file, warmup_filters_file;
+    uint32_t num_threads, K, L, num_nodes_to_cache, cache_budget_mb;
+    bool pipelined = false, adaptive_beam_width = false;
+    float io_budget_factor;
+    std::vector<uint32_t> beam_widths;
+    std::vector<std::string> io_backends;
+
+    po::options_description desc{program_options_utils::make_program_description(
+        "benchmark_disk_io", "Compares disk index search throughput and latency across I/O backends")};
+    try
+    {
+        desc.add_options()("help,h", "Print this information on arguments");
+
+        // Required parameters
+        po::options_description required_configs("Required");
+        required_configs.add_options()("index_path_prefix", po::value<std::string>(&index_path_prefix)->required(),
+                                       program_options_utils::INDEX_PATH_PREFIX_DESCRIPTION);
+        required_configs.add_options()("query_file", po::value<std::string>(&query_file)->required(),
+                                       program_options_utils::QUERY_FILE_DESCRIPTION);
+
+        // Optional parameters
+        po::options_description optional_configs("Optional");
+        optional_configs.add_options()("data_type", po::value<std::string>(&data_type)->default_value("uint8"),
+                                       program_options_utils::DATA_TYPE_DESCRIPTION);
+        optional_configs.add_options()("dist_fn", po::value<std::string>(&dist_fn)->default_value("l2"),
+                                       program_options_utils::DISTANCE_FUNCTION_DESCRIPTION);
+        optional_configs.add_options()("io_backends",
+                                       po::value<std::vector<std::string>>(&io_backends)
+                                           ->multitoken()
+                                           ->default_value(std::vector<std::string>{"aio"}, "aio"),
+                                       "I/O backends to compare, any of {aio, io_uring, io_uring_sqpoll}");
+        optional_configs.add_options()("beam_widths,W",
+                                       po::value<std::vector<uint32_t>>(&beam_widths)
+                                           ->multitoken()
+                                           ->default_value(std::vector<uint32_t>{2, 4, 8}, "2 4 8"),
+                                       "Beam widths to run for every backend");
+        optional_configs.add_options()("recall_at,K", po::value<uint32_t>(&K)->default_value(10),
+                                       program_options_utils::NUMBER_OF_RESULTS_DESCRIPTION);
+        optional_configs.add_options()("search_list,L", po::value<uint32_t>(&L)->default_value(100),
+                                       program_options_utils::SEARCH_LIST_DESCRIPTION);
+        optional_configs.add_options()("num_nodes_to_cache", po::value<uint32_t>(&num_nodes_to_cache)->default_value(0),
+                                       program_options_utils::NUMBER_OF_NODES_TO_CACHE);
+        optional_configs.add_options()("warmup_query_file",
+                                       po::value<std::string>(&warmup_query_file)->default_value(""),
+                                       "Sample queries used to plan the node cache instead of a BFS from the medoids");
+        optional_configs.add_options()("warmup_filters_file",
+                                       po::value<std::string>(&warmup_filters_file)->default_value(""),
+                                       "Labels of the sample queries, in the format of query_filters_file");
+        optional_configs.add_options()("cache_budget_mb", po::value<uint32_t>(&cache_budget_mb)->default_value(0),
+                                       "Memory budget of the node cache planned from warmup_query_file");
+        optional_configs.add_options()("num_threads,T",
+                                       po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
+                                       program_options_utils::NUMBER_THREADS_DESCRIPTION);
+        optional_configs.add_options()("pipelined", po::bool_switch(&pipelined)->default_value(false),
+                                       "Keep beam reads in flight while expanding completed nodes");
+        optional_configs.add_options()("adaptive_beam_width",
+                                       po::bool_switch(&adaptive_beam_width)->default_value(false),
+                                       "Narrow the beam once the best candidates stop changing; W is the widest beam");
+        optional_configs.add_options()("io_budget_factor", po::value<float>(&io_budget_factor)->default_value(0.0f),
+                                       "If non-zero, limit every query to this many reads per search_list entry");
+        desc.add(required_configs).add(optional_configs);
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    diskann::Metric metric;
+    if (dist_fn == std::string("l2"))
+        metric = diskann::Metric::L2;
+    else if (dist_fn == std::string("mips"))
+        metric = diskann::Metric::INNER_PRODUCT;
+    else if (dist_fn == std::string("cosine"))
+        metric = diskann::Metric::COSINE;
+    else
+    {
+        std::cout << "Unsupported distance function. Currently only l2/ cosine/ mips are supported." << std::endl;
+        return -1;
+    }
+
+    if (L < K)
+    {
+        std::cout << "search_list (" << L << ") must be at least recall_at (" << K << ")" << std::endl;
+        return -1;
+    }
+
+    try
+    {
+        if (data_type == std::string("float"))
+            return benchmark_disk_io<float>(metric, index_path_prefix, query_file, io_backends, beam_widths,
+                                            num_threads, K, L, num_nodes_to_cache, pipelined, warmup_query_file,
+                                            warmup_filters_file, cache_budget_mb, adaptive_beam_width,
+                                            io_budget_factor);
+        else if (data_type == std::string("int8"))
+            return benchmark_disk_io<int8_t>(metric, index_path_prefix, query_file, io_backends, beam_widths,
+                                             num_threads, K, L, num_nodes_to_cache, pipelined, warmup_query_file,
+                                             warmup_filters_file, cache_budget_mb, adaptive_beam_width,
+                                             io_budget_factor);
+        else if (data_type == std::string("uint8"))
+            return benchmark_disk_io<uint8_t>(metric, index_path_prefix, query_file, io_backends, beam_widths,
+                                              num_threads, K, L, num_nodes_to_cache, pipelined, warmup_query_file,
+                                              warmup_filters_file, cache_budget_mb, adaptive_beam_width,
+                                              io_budget_factor);
+        else
+        {
+            std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cout << std::string(e.what()) << std::endl;
+        diskann::cerr << "Disk I/O benchmark failed." << std::endl;
+        return -1;
+    }
+}
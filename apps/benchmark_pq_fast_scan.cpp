@@ -0,0 +1,261 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <numeric>
+#include <omp.h>
+#include <boost/program_options.hpp>
+
+#include "pq.h"
+#include "pq_fast_scan.h"
+#include "utils.h"
+#include "program_options_utils.hpp"
+
+namespace po = boost::program_options;
+
+struct PQVariant
+{
+    std::string name;
+    uint32_t num_chunks;
+    uint32_t num_centers;
+};
+
+// Compares 8-bit PQ with table lookups against 4-bit PQ with fast scan
+// lookups at the same code size: num_pq_bytes chunks of 8 bits against twice
+// as many chunks of 4 bits. Every query scans the whole base in batches of
+// batch_size ids, the size of a neighbor list, and reports the time per
+// distance and the recall of the PQ ranking against brute force.
+template <typename T>
+int benchmark_pq_fast_scan(const std::string &data_file, const std::string &query_file, const std::string &pq_prefix,
+                           const uint32_t num_pq_bytes, const uint32_t recall_at, const uint32_t rerank_depth,
+                           const uint32_t batch_size, const uint32_t num_queries)
+{
+    T *base = nullptr, *query = nullptr;
+    size_t npts, dim, query_num, query_dim;
+    diskann::load_bin<T>(data_file, base, npts, dim);
+    diskann::load_bin<T>(query_file, query, query_num, query_dim);
+    if (query_dim != dim || npts < recall_at)
+    {
+        diskann::cerr << "Query dimension " << query_dim << " does not match data dimension " << dim
+                      << " or fewer than " << recall_at << " points" << std::endl;
+        delete[] base;
+        delete[] query;
+        return -1;
+    }
+    query_num = std::min<size_t>(query_num, num_queries);
+    const uint32_t depth = (uint32_t)std::min<size_t>(rerank_depth, npts);
+
+    // brute force ground truth
+    std::vector<uint32_t> gt(query_num * recall_at);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int64_t q = 0; q < (int64_t)query_num; q++)
+    {
+        std::vector<std::pair<float, uint32_t>> dists(npts);
+        for (size_t i = 0; i < npts; i++)
+        {
+            float dist = 0;
+            for (size_t d = 0; d < dim; d++)
+            {
+                float diff = (float)query[q * dim + d] - (float)base[i * dim + d];
+                dist += diff * diff;
+            }
+            dists[i] = std::make_pair(dist, (uint32_t)i);
+        }
+        std::partial_sort(dists.begin(), dists.begin() + recall_at, dists.end());
+        for (uint32_t k = 0; k < recall_at; k++)
+            gt[q * recall_at + k] = dists[k].second;
+    }
+    delete[] base;
+
+    std::vector<PQVariant> variants = {{"pq8", num_pq_bytes, NUM_PQ_CENTROIDS},
+                                       {"pq4_fast_scan", 2 * num_pq_bytes, NUM_PQ4_CENTROIDS}};
+    const double p_val = std::min(1.0, ((double)MAX_PQ_TRAINING_SET_SIZE / (double)npts));
+
+    std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    std::cout.precision(3);
+    std::cout << std::setw(16) << "Variant" << std::setw(10) << "Chunks" << std::setw(12) << "Bytes/vec"
+              << std::setw(14) << "Recall" << std::setw(14) << "ns/dist" << std::setw(10) << "Speedup" << std::endl;
+
+    double base_ns_per_dist = 0;
+    for (const auto &variant : variants)
+    {
+        const std::string prefix = pq_prefix + "_" + variant.name + "_" + std::to_string(variant.num_chunks);
+        const std::string pivots_file = prefix + "_pivots.bin";
+        const std::string compressed_file = prefix + "_compressed.bin";
+        if (!file_exists(pivots_file) || !file_exists(compressed_file))
+            diskann::generate_quantized_data<T>(data_file, pivots_file, compressed_file, diskann::Metric::L2, p_val,
+                                                variant.num_chunks, false, "", variant.num_centers);
+
+        diskann::FixedChunkPQTable pq_table;
+        pq_table.load_pq_centroid_bin(pivots_file.c_str(), variant.num_chunks);
+        uint8_t *codes = nullptr;
+        size_t code_npts, code_chunks;
+        diskann::load_bin<uint8_t>(compressed_file, codes, code_npts, code_chunks);
+        if (code_npts != npts || code_chunks != variant.num_chunks || pq_table.get_num_centers() != variant.num_centers)
+        {
+            diskann::cerr << "PQ files " << prefix << "_* do not match the data, remove them to regenerate"
+                          << std::endl;
+            delete[] codes;
+            delete[] query;
+            return -1;
+        }
+        const bool fast_scan = variant.num_centers == NUM_PQ4_CENTROIDS;
+        const size_t code_bytes = fast_scan ? diskann::pq4_code_bytes(code_chunks) : code_chunks;
+        if (fast_scan)
+        {
+            uint8_t *packed = new uint8_t[npts * code_bytes];
+            diskann::pack_pq4_codes(codes, npts, code_chunks, packed);
+            delete[] codes;
+            codes = packed;
+        }
+
+        diskann::PQScratch<T> scratch(batch_size, ROUND_UP(dim, 8));
+        float *pq_dists = scratch.aligned_pqtable_dist_scratch;
+        std::vector<float> dists(npts);
+        std::vector<uint32_t> ids(batch_size);
+        std::vector<uint32_t> order(npts);
+        double scan_ns = 0, recall = 0;
+        for (size_t q = 0; q < query_num; q++)
+        {
+            scratch.set(dim, query + q * dim);
+            pq_table.preprocess_query(scratch.rotated_query);
+            pq_table.populate_chunk_distances(scratch.rotated_query, pq_dists);
+
+            auto start = std::chrono::high_resolution_clock::now();
+            float scale = 1.0f, bias = 0;
+            if (fast_scan)
+                diskann::quantize_fast_scan_lut(pq_dists, code_chunks, scratch.aligned_fast_scan_lut, scale, bias);
+            for (size_t begin = 0; begin < npts; begin += batch_size)
+            {
+                const size_t n_ids = std::min<size_t>(batch_size, npts - begin);
+                std::iota(ids.begin(), ids.begin() + n_ids, (uint32_t)begin);
+                if (fast_scan)
+                {
+                    diskann::aggregate_fast_scan_codes(ids.data(), n_ids, codes, code_chunks,
+                                                       scratch.aligned_pq_coord_scratch);
+                    diskann::fast_scan_dist_lookup(scratch.aligned_pq_coord_scratch, n_ids, code_chunks,
+                                                   scratch.aligned_fast_scan_lut, scale, bias, dists.data() + begin);
+                }
+                else
+                {
+                    diskann::aggregate_coords(ids.data(), n_ids, codes, code_chunks,
+                                              scratch.aligned_pq_coord_scratch);
+                    diskann::pq_dist_lookup(scratch.aligned_pq_coord_scratch, n_ids, code_chunks, pq_dists,
+                                            dists.data() + begin);
+                }
+            }
+            scan_ns += std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start)
+                           .count();
+
+            std::iota(order.begin(), order.end(), 0);
+            std::partial_sort(order.begin(), order.begin() + depth, order.end(),
+                              [&dists](uint32_t a, uint32_t b) { return dists[a] < dists[b]; });
+            std::vector<uint32_t> top(order.begin(), order.begin() + depth);
+            std::sort(top.begin(), top.end());
+            for (uint32_t k = 0; k < recall_at; k++)
+                recall += std::binary_search(top.begin(), top.end(), gt[q * recall_at + k]) ? 1 : 0;
+        }
+        delete[] codes;
+
+        const double ns_per_dist = scan_ns / ((double)query_num * npts);
+        if (base_ns_per_dist == 0)
+            base_ns_per_dist = ns_per_dist;
+        std::cout << std::setw(16) << variant.name << std::setw(10) << code_chunks << std::setw(12) << code_bytes
+                  << std::setw(14) << recall / ((double)query_num * recall_at) << std::setw(14) << ns_per_dist
+                  << std::setw(10) << base_ns_per_dist / ns_per_dist << std::endl;
+    }
+    std::cout << "Recall is " << recall_at << "@" << depth << " of the PQ ranking against brute force." << std::endl;
+
+    delete[] query;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_type, data_file, query_file, pq_prefix;
+    uint32_t num_pq_bytes, K, rerank_depth, batch_size, num_queries;
+
+    po::options_description desc{program_options_utils::make_program_description(
+        "benchmark_pq_fast_scan", "Compares 8-bit PQ lookups with 4-bit fast scan PQ at the same code size")};
+    try
+    {
+        desc.add_options()("help,h", "Print this information on arguments");
+
+        // Required parameters
+        po::options_description required_configs("Required");
+        required_configs.add_options()("data_type", po::value<std::string>(&data_type)->required(),
+                                       program_options_utils::DATA_TYPE_DESCRIPTION);
+        required_configs.add_options()("data_path", po::value<std::string>(&data_file)->required(),
+                                       program_options_utils::INPUT_DATA_PATH);
+        required_configs.add_options()("query_file", po::value<std::string>(&query_file)->required(),
+                                       program_options_utils::QUERY_FILE_DESCRIPTION);
+        required_configs.add_options()("pq_prefix", po::value<std::string>(&pq_prefix)->required(),
+                                       "Prefix of the PQ pivots and codes, generated if missing");
+        required_configs.add_options()("num_pq_bytes", po::value<uint32_t>(&num_pq_bytes)->required(),
+                                       "Bytes per vector of both variants: chunks of 8-bit PQ, half the chunks "
+                                       "of 4-bit PQ");
+
+        // Optional parameters
+        po::options_description optional_configs("Optional");
+        optional_configs.add_options()("recall_at,K", po::value<uint32_t>(&K)->default_value(10),
+                                       program_options_utils::NUMBER_OF_RESULTS_DESCRIPTION);
+        optional_configs.add_options()("rerank_depth", po::value<uint32_t>(&rerank_depth)->default_value(100),
+                                       "Number of PQ nearest points searched for the true K nearest");
+        optional_configs.add_options()("batch_size", po::value<uint32_t>(&batch_size)->default_value(64),
+                                       "Ids per distance batch, the size of a neighbor list");
+        optional_configs.add_options()("num_queries", po::value<uint32_t>(&num_queries)->default_value(100),
+                                       "Number of queries to run from query_file");
+        desc.add(required_configs).add(optional_configs);
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    if (num_pq_bytes == 0 || 2 * num_pq_bytes > MAX_PQ_CHUNKS)
+    {
+        std::cout << "num_pq_bytes must be in [1, " << MAX_PQ_CHUNKS / 2 << "]" << std::endl;
+        return -1;
+    }
+    if (rerank_depth < K || batch_size == 0)
+    {
+        std::cout << "rerank_depth must be at least recall_at and batch_size non-zero" << std::endl;
+        return -1;
+    }
+
+    try
+    {
+        if (data_type == std::string("float"))
+            return benchmark_pq_fast_scan<float>(data_file, query_file, pq_prefix, num_pq_bytes, K, rerank_depth,
+                                                 batch_size, num_queries);
+        else if (data_type == std::string("int8"))
+            return benchmark_pq_fast_scan<int8_t>(data_file, query_file, pq_prefix, num_pq_bytes, K, rerank_depth,
+                                                  batch_size, num_queries);
+        else if (data_type == std::string("uint8"))
+            return benchmark_pq_fast_scan<uint8_t>(data_file, query_file, pq_prefix, num_pq_bytes, K, rerank_depth,
+                                                   batch_size, num_queries);
+        else
+        {
+            std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cout << std::string(e.what()) << std::endl;
+        diskann::cerr << "PQ fast scan benchmark failed." << std::endl;
+        return -1;
+    }
+}
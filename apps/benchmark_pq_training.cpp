@@ -0,0 +1,200 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <cstdio>
+#include <iomanip>
+#include <omp.h>
+#include <boost/program_options.hpp>
+
+#include "partition.h"
+#include "pq.h"
+#include "timer.h"
+#include "utils.h"
+#include "program_options_utils.hpp"
+
+namespace po = boost::program_options;
+
+// Mean squared quantization error of eval_data under the pivots in
+// pivots_file, computed as the sum over chunks of the distance to the
+// closest pivot.
+static double quantization_error(const std::string &pivots_file, const float *eval_data, const size_t eval_size,
+                                 const size_t dim, const uint32_t num_pq_chunks)
+{
+    diskann::FixedChunkPQTable pq_table;
+    pq_table.load_pq_centroid_bin(pivots_file.c_str(), num_pq_chunks);
+    const uint32_t num_centers = pq_table.get_num_centers();
+
+    double error = 0;
+#pragma omp parallel for schedule(dynamic, 64) reduction(+ : error)
+    for (int64_t i = 0; i < (int64_t)eval_size; i++)
+    {
+        std::vector<float> point(eval_data + i * dim, eval_data + (i + 1) * dim);
+        std::vector<float> chunk_dists((size_t)num_centers * num_pq_chunks);
+        pq_table.preprocess_query(point.data());
+        pq_table.populate_chunk_distances(point.data(), chunk_dists.data());
+        for (uint32_t c = 0; c < num_pq_chunks; c++)
+            error += *std::min_element(chunk_dists.begin() + (size_t)c * num_centers,
+                                       chunk_dists.begin() + (size_t)(c + 1) * num_centers);
+    }
+    return eval_size > 0 ? error / eval_size : 0;
+}
+
+// Times PQ (or OPQ) pivot generation for every training sample size and
+// k-means batch size (0 runs Lloyds on the whole sample), and reports the
+// quantization error of the pivots on a separate sample of the data.
+template <typename T>
+int benchmark_pq_training(const std::string &data_file, const std::string &pq_prefix, const uint32_t num_pq_chunks,
+                          const uint32_t num_centers, const bool use_opq, const std::vector<size_t> &sample_sizes,
+                          const std::vector<size_t> &kmeans_batch_sizes, const size_t eval_size)
+{
+    size_t npts, dim;
+    diskann::get_bin_metadata(data_file, npts, dim);
+    if (num_pq_chunks == 0 || num_pq_chunks > dim)
+    {
+        diskann::cerr << "num_pq_chunks must be in [1, " << dim << "]" << std::endl;
+        return -1;
+    }
+
+    float *eval_data = nullptr;
+    size_t eval_num, eval_dim;
+    gen_random_slice<T>(data_file, std::min(1.0, (double)eval_size / (double)npts), eval_data, eval_num, eval_dim);
+
+    const std::string pivots_file = pq_prefix + "_benchmark_pivots.bin";
+    const std::string rotmat_file = pivots_file + "_rotation_matrix.bin";
+    const bool make_zero_mean = !use_opq;
+
+    std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    std::cout.precision(3);
+    std::cout << std::setw(12) << "Samples" << std::setw(12) << "Batch" << std::setw(14) << "Time(s)"
+              << std::setw(18) << "Quant. error" << std::endl;
+
+    for (const auto sample_size : sample_sizes)
+    {
+        float *train_data = nullptr;
+        size_t train_size, train_dim;
+        gen_random_slice<T>(data_file, std::min(1.0, (double)sample_size / (double)npts), train_data, train_size,
+                            train_dim);
+
+        for (const auto kmeans_batch_size : kmeans_batch_sizes)
+        {
+            // existing pivots are not regenerated
+            std::remove(pivots_file.c_str());
+            std::remove(rotmat_file.c_str());
+
+            diskann::Timer timer;
+            if (use_opq)
+                diskann::generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, num_centers, num_pq_chunks,
+                                             pivots_file, make_zero_mean, kmeans_batch_size);
+            else
+                diskann::generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, num_centers, num_pq_chunks,
+                                            NUM_KMEANS_REPS_PQ, pivots_file, make_zero_mean, kmeans_batch_size);
+            float train_seconds = timer.elapsed_seconds();
+
+            double error = quantization_error(pivots_file, eval_data, eval_num, eval_dim, num_pq_chunks);
+            std::cout << std::setw(12) << train_size << std::setw(12) << kmeans_batch_size << std::setw(14)
+                      << train_seconds << std::setw(18) << error << std::endl;
+        }
+        delete[] train_data;
+    }
+
+    std::remove(pivots_file.c_str());
+    std::remove(rotmat_file.c_str());
+    delete[] eval_data;
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    std::string data_type, data_file, pq_prefix;
+    uint32_t num_pq_chunks, num_threads, num_centers;
+    size_t eval_size;
+    bool use_opq = false;
+    std::vector<size_t> sample_sizes, kmeans_batch_sizes;
+
+    po::options_description desc{program_options_utils::make_program_description(
+        "benchmark_pq_training", "Times PQ pivot generation at different training sample and k-means batch sizes")};
+    try
+    {
+        desc.add_options()("help,h", "Print this information on arguments");
+
+        // Required parameters
+        po::options_description required_configs("Required");
+        required_configs.add_options()("data_type", po::value<std::string>(&data_type)->required(),
+                                       program_options_utils::DATA_TYPE_DESCRIPTION);
+        required_configs.add_options()("data_path", po::value<std::string>(&data_file)->required(),
+                                       program_options_utils::INPUT_DATA_PATH);
+        required_configs.add_options()("pq_prefix", po::value<std::string>(&pq_prefix)->required(),
+                                       "Prefix of the pivot files written while benchmarking");
+        required_configs.add_options()("num_pq_chunks", po::value<uint32_t>(&num_pq_chunks)->required(),
+                                       "Number of PQ chunks");
+
+        // Optional parameters
+        po::options_description optional_configs("Optional");
+        optional_configs.add_options()("num_centers", po::value<uint32_t>(&num_centers)->default_value(256),
+                                       "Centroids per chunk, 256 or 16");
+        optional_configs.add_options()("use_opq", po::bool_switch(&use_opq)->default_value(false),
+                                       "Train OPQ instead of PQ pivots");
+        optional_configs.add_options()("sample_sizes",
+                                       po::value<std::vector<size_t>>(&sample_sizes)
+                                           ->multitoken()
+                                           ->default_value(std::vector<size_t>{64000, 256000, 1000000},
+                                                           "64000 256000 1000000"),
+                                       "Training sample sizes to run");
+        optional_configs.add_options()("kmeans_batch_sizes",
+                                       po::value<std::vector<size_t>>(&kmeans_batch_sizes)
+                                           ->multitoken()
+                                           ->default_value(std::vector<size_t>{0, 16384}, "0 16384"),
+                                       "Mini-batch sizes of k-means to run for every sample size, 0 runs Lloyds");
+        optional_configs.add_options()("eval_size", po::value<size_t>(&eval_size)->default_value(10000),
+                                       "Number of points the quantization error is measured on");
+        optional_configs.add_options()("num_threads,T",
+                                       po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
+                                       program_options_utils::NUMBER_THREADS_DESCRIPTION);
+        desc.add(required_configs).add(optional_configs);
+
+        po::variables_map vm;
+        po::store(po::parse_command_line(argc, argv, desc), vm);
+        if (vm.count("help"))
+        {
+            std::cout << desc;
+            return 0;
+        }
+        po::notify(vm);
+    }
+    catch (const std::exception &ex)
+    {
+        std::cerr << ex.what() << '\n';
+        return -1;
+    }
+
+    if (num_centers != NUM_PQ_CENTROIDS && num_centers != NUM_PQ4_CENTROIDS)
+    {
+        std::cout << "num_centers must be 256 or 16" << std::endl;
+        return -1;
+    }
+    omp_set_num_threads(num_threads);
+
+    try
+    {
+        if (data_type == std::string("float"))
+            return benchmark_pq_training<float>(data_file, pq_prefix, num_pq_chunks, num_centers, use_opq,
+                                                sample_sizes, kmeans_batch_sizes, eval_size);
+        else if (data_type == std::string("int8"))
+            return benchmark_pq_training<int8_t>(data_file, pq_prefix, num_pq_chunks, num_centers, use_opq,
+                                                 sample_sizes, kmeans_batch_sizes, eval_size);
+        else if (data_type == std::string("uint8"))
+            return benchmark_pq_training<uint8_t>(data_file, pq_prefix, num_pq_chunks, num_centers, use_opq,
+                                                  sample_sizes, kmeans_batch_sizes, eval_size);
+        else
+        {
+            std::cerr << "Unsupported data type. Use float or int8 or uint8" << std::endl;
+            return -1;
+        }
+    }
+    catch (std::exception &e)
+    {
+        std::cout << std::string(e.what()) << std::endl;
+        diskann::cerr << "PQ training benchmark failed." << std::endl;
+        return -1;
+    }
+}
@@ -16,6 +16,8 @@
 #endif
 
 #include "index.h"
+#include "instrumentation.h"
+#include "disk_utils.h"
 #include "memory_mapper.h"
 #include "parameters.h"
 #include "utils.h"
@@ -55,7 +57,8 @@ inline size_t random(size_t range_from, size_t range_to)
  */
 void handle_args(int argc, char **argv, std::string &data_type, path &input_data_path, path &final_index_path_prefix,
                  path &label_data_path, std::string &universal_label, uint32_t &num_threads, uint32_t &R, uint32_t &L,
-                 uint32_t &stitched_R, float &alpha)
+                 uint32_t &stitched_R, float &alpha, uint32_t &disk_pq_chunks, bool &disk_labels_in_sectors,
+                 bool &disk_pq_fast_scan)
 {
     po::options_description desc{
         program_options_utils::make_program_description("build_stitched_index", "Build a stitched DiskANN index.")};
@@ -90,6 +93,16 @@ void handle_args(int argc, char **argv, std::string &data_type, path &input_data
                                        program_options_utils::UNIVERSAL_LABEL);
         optional_configs.add_options()("stitched_R", po::value<uint32_t>(&stitched_R)->default_value(100),
                                        "Degree to prune final graph down to");
+        optional_configs.add_options()("disk_pq_chunks", po::value<uint32_t>(&disk_pq_chunks)->default_value(0),
+                                       "If non-zero, also export the stitched index to the SSD index layout with "
+                                       "this many PQ bytes per vector (index_path_prefix_disk.index)");
+        optional_configs.add_options()("disk_labels_in_sectors",
+                                       po::bool_switch(&disk_labels_in_sectors)->default_value(false),
+                                       "Store every node's labels in its SSD sector instead of in memory; "
+                                       "only used with disk_pq_chunks");
+        optional_configs.add_options()("disk_pq_fast_scan", po::bool_switch(&disk_pq_fast_scan)->default_value(false),
+                                       "Use 4-bit PQ codes, searched with fast scan lookups, for the SSD index; "
+                                       "only used with disk_pq_chunks");
 
         // Merge required and optional parameters
         desc.add(required_configs).add(optional_configs);
@@ -355,7 +368,7 @@ size_t stitch_label_indices(
             delete[] pivot_data;
         }
         
-
+        DISKANN_PROBE_SCOPE(StitchLabelGraph);
         for (uint32_t node_point = 0; node_point < curr_label_index.size(); node_point++)
         {
             uint32_t original_point_id = label_id_to_orig_id_map[lbl][node_point];
@@ -368,6 +381,7 @@ size_t stitch_label_indices(
                 {
                     stitched_graph[original_point_id].push_back(original_neighbor_id);
                     final_index_size += sizeof(uint32_t);
+                    DISKANN_PROBE_COUNT(StitchedEdges, 1);
                 }
             }
         }
@@ -455,13 +469,15 @@ int main(int argc, char **argv)
     std::string data_type;
     path input_data_path, final_index_path_prefix, label_data_path;
     std::string universal_label;
-    uint32_t num_threads, R, L, stitched_R;
+    uint32_t num_threads, R, L, stitched_R, disk_pq_chunks;
+    bool disk_labels_in_sectors = false, disk_pq_fast_scan = false;
     float alpha;
     bool skip_building_stitched_graph=false;
 
     auto index_timer = std::chrono::high_resolution_clock::now();
     handle_args(argc, argv, data_type, input_data_path, final_index_path_prefix, label_data_path, universal_label,
-                num_threads, R, L, stitched_R, alpha);
+                num_threads, R, L, stitched_R, alpha, disk_pq_chunks, disk_labels_in_sectors,
+                disk_pq_fast_scan);
 
     path labels_file_to_use = final_index_path_prefix + "_label_formatted.txt";
     path labels_map_file = final_index_path_prefix + "_labels_map.txt";
@@ -577,5 +593,29 @@ int main(int argc, char **argv)
     std::chrono::duration<double> index_time = std::chrono::high_resolution_clock::now() - index_timer;
     std::cout << "pruned/stitched graph generated in " << index_time.count() << " seconds" << std::endl;
 
+    // 7. optionally convert the stitched index to the SSD layout
+    if (disk_pq_chunks > 0)
+    {
+        int ret = -1;
+        if (data_type == "uint8")
+            ret = diskann::create_disk_index_from_mem_index<uint8_t>(final_index_path_prefix, final_index_path_prefix,
+                                                                     disk_pq_chunks, false, "", disk_labels_in_sectors,
+                                                                     disk_pq_fast_scan);
+        else if (data_type == "int8")
+            ret = diskann::create_disk_index_from_mem_index<int8_t>(final_index_path_prefix, final_index_path_prefix,
+                                                                    disk_pq_chunks, false, "", disk_labels_in_sectors,
+                                                                    disk_pq_fast_scan);
+        else if (data_type == "float")
+            ret = diskann::create_disk_index_from_mem_index<float>(final_index_path_prefix, final_index_path_prefix,
+                                                                   disk_pq_chunks, false, "", disk_labels_in_sectors,
+                                                                   disk_pq_fast_scan);
+        if (ret != 0)
+        {
+            std::cerr << "Failed to export the stitched index to the SSD layout" << std::endl;
+            return -1;
+        }
+    }
+
     clean_up_artifacts(input_data_path, final_index_path_prefix, all_labels);
+    DISKANN_INSTRUMENT_REPORT(final_index_path_prefix + "_build_instrumentation.json");
 }
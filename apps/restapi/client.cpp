@@ -7,13 +7,20 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT license.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <numeric>
 #include <string>
 #include <cstdlib>
 #include <codecvt>
+#include <thread>
 #include <boost/program_options.hpp>
 
 #include <cpprest/http_client.h>
 #include <restapi/common.h>
+#include "filter_utils.h"
 
 using namespace web;
 using namespace web::http;
@@ -22,58 +29,159 @@ using namespace web::http::client;
 using namespace diskann;
 namespace po = boost::program_options;
 
+// Builds the request for one query. Queries with labels go to the filtered
+// search path. encoding is json (an array of numbers), base64 (the raw
+// elements in a json string) or raw (the elements as the request body).
 template <typename T>
-void query_loop(const std::string &ip_addr_port, const std::string &query_file, const unsigned nq, const unsigned Ls,
-                const unsigned k_value)
+web::http::http_request make_request(const T *vec, const size_t ndims, const unsigned query_id, const unsigned Ls,
+                                     const unsigned k_value, const std::vector<std::string> *labels,
+                                     const std::string &encoding)
 {
-    web::http::client::http_client client(U(ip_addr_port));
+    web::http::http_request http_query(methods::POST);
+    web::http::uri_builder uri;
+    if (labels != nullptr)
+        uri.append_path(utility::conversions::to_string_t(FILTERED_SEARCH_PATH));
 
-    T *data;
-    size_t npts = 1, ndims = 128, rounded_dim = 128;
-    diskann::load_aligned_bin<T>(query_file, data, npts, ndims, rounded_dim);
-
-    for (unsigned i = 0; i < nq; ++i)
+    if (encoding == std::string("raw"))
+    {
+        uri.append_query(utility::conversions::to_string_t(QUERY_ID_KEY), query_id);
+        uri.append_query(utility::conversions::to_string_t(K_KEY), k_value);
+        uri.append_query(utility::conversions::to_string_t(L_KEY), Ls);
+        if (labels != nullptr)
+        {
+            std::string joined;
+            for (const auto &label : *labels)
+                joined += (joined.empty() ? "" : ",") + label;
+            uri.append_query(utility::conversions::to_string_t(LABELS_KEY), utility::conversions::to_string_t(joined));
+        }
+        http_query.set_body(std::vector<unsigned char>((const unsigned char *)vec,
+                                                       (const unsigned char *)(vec + ndims)));
+    }
+    else
     {
-        T *vec = data + i * rounded_dim;
-        web::http::http_request http_query(methods::POST);
         web::json::value queryJson = web::json::value::object();
-        queryJson[QUERY_ID_KEY] = i;
+        queryJson[QUERY_ID_KEY] = query_id;
         queryJson[K_KEY] = k_value;
         queryJson[L_KEY] = Ls;
-        for (size_t i = 0; i < ndims; ++i)
+        if (encoding == std::string("base64"))
         {
-            queryJson[VECTOR_KEY][i] = web::json::value::number(vec[i]);
+            queryJson[VECTOR_BASE64_KEY] = web::json::value::string(utility::conversions::to_base64(
+                std::vector<unsigned char>((const unsigned char *)vec, (const unsigned char *)(vec + ndims))));
+        }
+        else
+        {
+            for (size_t i = 0; i < ndims; ++i)
+            {
+                queryJson[VECTOR_KEY][i] = web::json::value::number(vec[i]);
+            }
+        }
+        if (labels != nullptr)
+        {
+            for (size_t i = 0; i < labels->size(); ++i)
+                queryJson[LABELS_KEY][i] = web::json::value::string(utility::conversions::to_string_t((*labels)[i]));
         }
         http_query.set_body(queryJson);
+    }
+    http_query.set_request_uri(uri.to_uri());
+    return http_query;
+}
 
-        client.request(http_query)
-            .then([](web::http::http_response response) -> pplx::task<utility::string_t> {
-                if (response.status_code() == status_codes::OK)
-                {
-                    return response.extract_string();
-                }
-                std::cerr << "Query failed" << std::endl;
-                return pplx::task_from_result(utility::string_t());
-            })
-            .then([](pplx::task<utility::string_t> previousTask) {
+// Sends nq queries over num_concurrent connections, each with one request
+// in flight, and reports throughput and latency percentiles.
+template <typename T>
+void query_loop(const std::string &ip_addr_port, const std::string &query_file, const std::string &query_filters_file,
+                const std::string &encoding, const unsigned nq, const unsigned Ls, const unsigned k_value,
+                const unsigned num_concurrent, const bool quiet)
+{
+    T *data;
+    size_t npts = 1, ndims = 128, rounded_dim = 128;
+    diskann::load_aligned_bin<T>(query_file, data, npts, ndims, rounded_dim);
+    const unsigned num_queries = (unsigned)std::min<size_t>(nq, npts);
+
+    // labels of query i are columns of row i plus one, as in write_labels
+    std::vector<std::vector<std::string>> query_filters;
+    if (!query_filters_file.empty())
+    {
+        load_sparse_matrix(query_filters_file, query_filters);
+        if (query_filters.size() < num_queries)
+        {
+            std::cerr << "Query filters file has " << query_filters.size() << " rows for " << num_queries
+                      << " queries" << std::endl;
+            diskann::aligned_free(data);
+            return;
+        }
+    }
+
+    std::vector<double> latencies_us(num_queries, -1);
+    std::atomic<unsigned> next_query(0);
+    std::mutex print_mutex;
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < std::max(num_concurrent, 1u); t++)
+    {
+        workers.emplace_back([&]() {
+            web::http::client::http_client client(U(ip_addr_port));
+            for (unsigned i = next_query++; i < num_queries; i = next_query++)
+            {
+                web::http::http_request http_query =
+                    make_request(data + i * rounded_dim, ndims, i, Ls, k_value,
+                                 query_filters.empty() ? nullptr : &query_filters[i], encoding);
+                auto query_start = std::chrono::high_resolution_clock::now();
                 try
                 {
-                    std::cout << previousTask.get() << std::endl;
+                    web::http::http_response response = client.request(http_query).get();
+                    utility::string_t body = response.extract_string().get();
+                    if (response.status_code() == status_codes::OK)
+                        latencies_us[i] = std::chrono::duration<double, std::micro>(
+                                              std::chrono::high_resolution_clock::now() - query_start)
+                                              .count();
+                    std::lock_guard<std::mutex> lock(print_mutex);
+                    if (response.status_code() != status_codes::OK)
+                        std::cerr << "Query " << i << " failed: " << body << std::endl;
+                    else if (!quiet)
+                        std::cout << body << std::endl;
                 }
                 catch (http_exception const &e)
                 {
-                    std::wcout << e.what() << std::endl;
+                    std::lock_guard<std::mutex> lock(print_mutex);
+                    std::cerr << "Query " << i << " failed: " << e.what() << std::endl;
                 }
-            })
-            .wait();
+            }
+        });
+    }
+    for (auto &worker : workers)
+        worker.join();
+    double total_us =
+        std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start_time).count();
+    diskann::aligned_free(data);
+
+    std::vector<double> succeeded;
+    for (const auto latency : latencies_us)
+    {
+        if (latency >= 0)
+            succeeded.push_back(latency);
     }
+    std::sort(succeeded.begin(), succeeded.end());
+    std::cout << succeeded.size() << " of " << num_queries << " queries succeeded, " << num_concurrent
+              << " concurrent" << std::endl;
+    if (succeeded.empty())
+        return;
+    auto percentile = [&succeeded](double p) {
+        return succeeded[std::min(succeeded.size() - 1, (size_t)(p * succeeded.size()))];
+    };
+    std::cout << "QPS: " << succeeded.size() / (total_us / 1e6) << std::endl;
+    std::cout << "Latency (us) mean: " << std::accumulate(succeeded.begin(), succeeded.end(), 0.0) / succeeded.size()
+              << " p50: " << percentile(0.5) << " p99: " << percentile(0.99) << " max: " << succeeded.back()
+              << std::endl;
 }
 
 int main(int argc, char *argv[])
 {
-    std::string data_type, query_file, address;
+    std::string data_type, query_file, address, query_filters_file, encoding;
     uint32_t num_queries;
-    uint32_t l_search, k_value;
+    uint32_t l_search, k_value, num_concurrent;
+    bool quiet = false;
 
     po::options_description desc{"Arguments"};
     try
@@ -87,6 +195,15 @@ int main(int argc, char *argv[])
                            "Number of queries to search");
         desc.add_options()("l_search", po::value<uint32_t>(&l_search)->required(), "Value of L");
         desc.add_options()("k_value,K", po::value<uint32_t>(&k_value)->default_value(10), "Value of K (default 10)");
+        desc.add_options()("query_filters_file",
+                           po::value<std::string>(&query_filters_file)->default_value(std::string()),
+                           "Sparse matrix of query labels; runs filtered searches if given");
+        desc.add_options()("encoding", po::value<std::string>(&encoding)->default_value("json"),
+                           "Query vector encoding <json/base64/raw>");
+        desc.add_options()("num_concurrent", po::value<uint32_t>(&num_concurrent)->default_value(1),
+                           "Number of requests in flight");
+        desc.add_options()("quiet", po::bool_switch(&quiet)->default_value(false),
+                           "Do not print the responses");
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
         if (vm.count("help"))
@@ -104,15 +221,18 @@ int main(int argc, char *argv[])
 
     if (data_type == std::string("float"))
     {
-        query_loop<float>(address, query_file, num_queries, l_search, k_value);
+        query_loop<float>(address, query_file, query_filters_file, encoding, num_queries, l_search, k_value,
+                          num_concurrent, quiet);
     }
     else if (data_type == std::string("int8"))
     {
-        query_loop<int8_t>(address, query_file, num_queries, l_search, k_value);
+        query_loop<int8_t>(address, query_file, query_filters_file, encoding, num_queries, l_search, k_value,
+                           num_concurrent, quiet);
     }
     else if (data_type == std::string("uint8"))
     {
-        query_loop<uint8_t>(address, query_file, num_queries, l_search, k_value);
+        query_loop<uint8_t>(address, query_file, query_filters_file, encoding, num_queries, l_search, k_value,
+                            num_concurrent, quiet);
     }
     else
     {
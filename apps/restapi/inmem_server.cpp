@@ -17,6 +17,8 @@ namespace po = boost::program_options;
 std::unique_ptr<Server> g_httpServer(nullptr);
 std::vector<std::unique_ptr<diskann::BaseSearch>> g_inMemorySearch;
 
+uint32_t g_batchThreads = 0, g_maxBatchSize = 0, g_maxBatchWaitUs = 0;
+
 void setup(const utility::string_t &address, const std::string &typestring)
 {
     web::http::uri_builder uriBldr(address);
@@ -24,7 +26,10 @@ void setup(const utility::string_t &address, const std::string &typestring)
 
     std::cout << "Attempting to start server on " << uri.to_string() << std::endl;
 
-    g_httpServer = std::unique_ptr<Server>(new Server(uri, g_inMemorySearch, typestring));
+    std::unique_ptr<SearchBatcher> batcher;
+    if (g_batchThreads > 0)
+        batcher.reset(new SearchBatcher(g_batchThreads, g_maxBatchSize, g_maxBatchWaitUs));
+    g_httpServer = std::unique_ptr<Server>(new Server(uri, g_inMemorySearch, typestring, std::move(batcher)));
     std::cout << "Created a server object" << std::endl;
 
     g_httpServer->open().wait();
@@ -59,6 +64,13 @@ int main(int argc, char *argv[])
                            "distance function <l2/mips>");
         desc.add_options()("tags_file", po::value<std::string>(&tags_file)->default_value(std::string()),
                            "Tags file location");
+        desc.add_options()("batch_threads", po::value<uint32_t>(&g_batchThreads)->default_value(0),
+                           "Threads that run batches of concurrent requests, 0 searches each request on its "
+                           "listener thread");
+        desc.add_options()("max_batch_size", po::value<uint32_t>(&g_maxBatchSize)->default_value(64),
+                           "Most requests in one batch");
+        desc.add_options()("max_batch_wait_us", po::value<uint32_t>(&g_maxBatchWaitUs)->default_value(200),
+                           "Longest wait in microseconds for a batch to fill");
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
         if (vm.count("help"))
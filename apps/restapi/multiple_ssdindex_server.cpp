@@ -11,6 +11,9 @@
 #include <omp.h>
 
 #include <restapi/server.h>
+#ifndef _WINDOWS
+#include "shared_io_scheduler.h"
+#endif
 
 using namespace diskann;
 namespace po = boost::program_options;
@@ -42,6 +45,7 @@ int main(int argc, char *argv[])
     std::string data_type, index_prefix_paths, address, dist_fn, tags_file;
     uint32_t num_nodes_to_cache;
     uint32_t num_threads;
+    uint32_t num_io_threads;
 
     po::options_description desc{"Arguments"};
     try
@@ -50,7 +54,8 @@ int main(int argc, char *argv[])
         desc.add_options()("address", po::value<std::string>(&address)->required(), "Web server address");
         desc.add_options()("data_type", po::value<std::string>(&data_type)->required(), "data type <int8/uint8/float>");
         desc.add_options()("index_prefix_paths", po::value<std::string>(&index_prefix_paths)->required(),
-                           "Path prefix for loading index file components");
+                           "File with one index path prefix per line, optionally followed by a tab and "
+                           "the index's I/O weight (default 1)");
         desc.add_options()("num_nodes_to_cache", po::value<uint32_t>(&num_nodes_to_cache)->default_value(0),
                            "Number of nodes to cache during search");
         desc.add_options()("num_threads,T", po::value<uint32_t>(&num_threads)->default_value(omp_get_num_procs()),
@@ -60,6 +65,9 @@ int main(int argc, char *argv[])
                            "distance function <l2/mips>");
         desc.add_options()("tags_file", po::value<std::string>(&tags_file)->default_value(std::string()),
                            "Tags file location");
+        desc.add_options()("io_threads", po::value<uint32_t>(&num_io_threads)->default_value(0),
+                           "If non-zero, all indices share one I/O scheduler with this many I/O threads, "
+                           "which splits device time between them by weight");
 
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -88,6 +96,7 @@ int main(int argc, char *argv[])
     }
 
     std::vector<std::pair<std::string, std::string>> index_tag_paths;
+    std::vector<uint32_t> index_weights;
     std::ifstream index_in(index_prefix_paths);
     if (!index_in.is_open())
     {
@@ -103,9 +112,17 @@ int main(int argc, char *argv[])
     std::string prefix, tagfile;
     while (std::getline(index_in, prefix))
     {
+        uint32_t weight = 1;
+        size_t tab_pos = prefix.find('\t');
+        if (tab_pos != std::string::npos)
+        {
+            weight = (uint32_t)std::stoul(prefix.substr(tab_pos + 1));
+            prefix = prefix.substr(0, tab_pos);
+        }
         if (std::getline(tags_in, tagfile))
         {
             index_tag_paths.push_back(std::make_pair(prefix, tagfile));
+            index_weights.push_back(weight);
         }
         else
         {
@@ -118,30 +135,49 @@ int main(int argc, char *argv[])
     index_in.close();
     tags_in.close();
 
+    // one reader per index, all served by the same scheduler if requested
+    std::vector<std::shared_ptr<AlignedFileReader>> readers(index_tag_paths.size());
+    if (num_io_threads > 0)
+    {
+#ifndef _WINDOWS
+        auto scheduler = std::make_shared<SharedIOScheduler>(num_io_threads);
+        for (size_t i = 0; i < readers.size(); i++)
+            readers[i] = std::make_shared<ScheduledAlignedFileReader>(scheduler, index_weights[i]);
+#else
+        std::cerr << "io_threads is not supported on Windows; using one reader per index" << std::endl;
+#endif
+    }
+
     if (data_type == std::string("float"))
     {
-        for (auto &index_tag : index_tag_paths)
+        for (size_t i = 0; i < index_tag_paths.size(); i++)
         {
+            auto &index_tag = index_tag_paths[i];
             auto searcher = std::unique_ptr<diskann::BaseSearch>(new diskann::PQFlashSearch<float>(
-                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric));
+                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric,
+                readers[i]));
             g_ssdSearch.push_back(std::move(searcher));
         }
     }
     else if (data_type == std::string("int8"))
     {
-        for (auto &index_tag : index_tag_paths)
+        for (size_t i = 0; i < index_tag_paths.size(); i++)
         {
+            auto &index_tag = index_tag_paths[i];
             auto searcher = std::unique_ptr<diskann::BaseSearch>(new diskann::PQFlashSearch<int8_t>(
-                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric));
+                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric,
+                readers[i]));
             g_ssdSearch.push_back(std::move(searcher));
         }
     }
     else if (data_type == std::string("uint8"))
     {
-        for (auto &index_tag : index_tag_paths)
+        for (size_t i = 0; i < index_tag_paths.size(); i++)
         {
+            auto &index_tag = index_tag_paths[i];
             auto searcher = std::unique_ptr<diskann::BaseSearch>(new diskann::PQFlashSearch<uint8_t>(
-                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric));
+                index_tag.first.c_str(), num_nodes_to_cache, num_threads, index_tag.second.c_str(), metric,
+                readers[i]));
             g_ssdSearch.push_back(std::move(searcher));
         }
     }
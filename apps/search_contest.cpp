@@ -18,6 +18,10 @@
 #endif
 
 #include "index.h"
+#include "instrumentation.h"
+#include "search_profiler.h"
+#include "search_thread_pool.h"
+#include "numa_utils.h"
 #include "memory_mapper.h"
 #include "utils.h"
 #include "program_options_utils.hpp"
@@ -72,11 +76,66 @@ void save_metadata(const std::string &meta_result_path, const string output_bin_
     // }
 }
 
+// Prints the latency distribution of one run and, unless latency_path is
+// empty, appends it to that CSV file. latencies are in microseconds and are
+// sorted in place.
+void report_latency_percentiles(const std::string &latency_path, const uint32_t L, const uint32_t run,
+                                std::vector<float> &latencies)
+{
+    if (latencies.empty())
+        return;
+    std::sort(latencies.begin(), latencies.end());
+    const size_t n = latencies.size();
+    auto percentile = [&](const double p) { return latencies[std::min(n - 1, (size_t)(p * n))]; };
+    const double mean = std::accumulate(latencies.begin(), latencies.end(), 0.0) / (double)n;
+
+    std::cout << "Latency (us) with L=" << L << ": mean=" << mean << ", p50=" << percentile(0.5)
+              << ", p90=" << percentile(0.9) << ", p99=" << percentile(0.99) << ", p99.9=" << percentile(0.999)
+              << ", max=" << latencies.back() << std::endl;
+
+    if (latency_path.empty())
+        return;
+    const bool new_file = !file_exists(latency_path);
+    std::ofstream file(latency_path, std::ios_base::app);
+    if (new_file)
+        file << "L,run,mean_us,p50_us,p90_us,p99_us,p999_us,max_us\n";
+    file << L << "," << run << "," << mean << "," << percentile(0.5) << "," << percentile(0.9) << ","
+         << percentile(0.99) << "," << percentile(0.999) << "," << latencies.back() << "\n";
+}
+
+// Writes the num_slow slowest queries of a run, slowest first, with their
+// filters and the search branch that answered them.
+void save_slow_queries(const std::string &slow_query_path, const uint32_t num_slow,
+                       const std::vector<float> &latencies, const std::vector<diskann::QueryStats> &stats,
+                       const std::vector<std::vector<std::string>> &query_filters)
+{
+    std::vector<uint32_t> order(latencies.size());
+    std::iota(order.begin(), order.end(), 0);
+    const size_t count = std::min<size_t>(num_slow, order.size());
+    std::partial_sort(order.begin(), order.begin() + count, order.end(),
+                      [&latencies](uint32_t a, uint32_t b) { return latencies[a] > latencies[b]; });
+
+    std::ofstream file(slow_query_path);
+    file << "query_id\tlatency_us\tbranch\thops\tcmps\tfilter_checks\tfilters\n";
+    for (size_t k = 0; k < count; k++)
+    {
+        const uint32_t q = order[k];
+        file << q << "\t" << latencies[q] << "\t" << (stats[q].brute_force ? "brute_force" : "graph") << "\t"
+             << stats[q].n_hops << "\t" << stats[q].n_cmps << "\t" << stats[q].n_filter_checks << "\t";
+        for (size_t f = 0; f < query_filters[q].size(); f++)
+            file << (f == 0 ? "" : ",") << query_filters[q][f];
+        file << "\n";
+    }
+}
+
 template <typename T, typename LabelT = uint32_t>
 int search_memory_index(diskann::Metric &metric, const std::string &index_path, const std::string &query_file,
                         const uint32_t num_threads, const uint32_t recall_at, const std::vector<uint32_t> &Lvec,
                         const std::string &query_filter_file, const std::string &result_path_prefix,
-                        const string &dataset, const uint32_t runs)
+                        const string &dataset, const uint32_t runs, const std::string &profile_prefix,
+                        const bool heap_profile, const bool hw_counters, const uint32_t num_slow_queries,
+                        const bool use_search_pool, const uint32_t chunk_size,
+                        const diskann::NumaPlacement numa_placement, const diskann::HugePagePolicy huge_pages)
 {
     using TagT = uint32_t;
     // Load the query file
@@ -109,15 +168,52 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                       .is_use_opq(false)
                       .with_num_pq_chunks(0)
                       .with_num_frozen_pts(num_frozen_pts)
+                      .with_huge_pages(huge_pages)
                       .build();
 
+    // created once so that the runs reuse the same pinned threads
+    std::unique_ptr<diskann::SearchThreadPool> search_pool;
+    if (use_search_pool)
+        search_pool = std::make_unique<diskann::SearchThreadPool>(num_threads, true,
+                                                                  numa_placement != diskann::NumaPlacement::None);
+
     auto index_factory = diskann::IndexFactory(config);
-    auto index = index_factory.create_instance();
-    index->load(index_path.c_str(), num_threads, *(std::max_element(Lvec.begin(), Lvec.end())));
-    std::cout << "Index loaded" << std::endl;
+    auto load_index = [&]() {
+        auto index = index_factory.create_instance();
+        index->load(index_path.c_str(), num_threads, *(std::max_element(Lvec.begin(), Lvec.end())));
+        return index;
+    };
+    // with replication, indexes[n] is on node search_pool->nodes()[n] and
+    // serves the pool threads of that node; otherwise there is one index
+    std::vector<std::unique_ptr<diskann::AbstractIndex>> indexes;
+    if (numa_placement == diskann::NumaPlacement::Replicate)
+    {
+        for (const uint32_t node : search_pool->nodes())
+        {
+            diskann::ScopedNumaMemoryPolicy memory_policy({node}, false);
+            indexes.emplace_back(load_index());
+            std::cout << "Index replica loaded on NUMA node " << node << std::endl;
+        }
+    }
+    else
+    {
+        std::unique_ptr<diskann::ScopedNumaMemoryPolicy> memory_policy;
+        if (numa_placement == diskann::NumaPlacement::Interleave)
+            memory_policy = std::make_unique<diskann::ScopedNumaMemoryPolicy>(diskann::get_numa_nodes(), true);
+        indexes.emplace_back(load_index());
+        std::cout << "Index loaded" << std::endl;
+    }
+    // leave the load out of the instrumentation report
+    DISKANN_INSTRUMENT_RESET();
+
+    std::unique_ptr<diskann::SearchProfiler> profiler;
+    if (!profile_prefix.empty())
+        profiler = std::make_unique<diskann::SearchProfiler>(profile_prefix, num_threads, true, heap_profile,
+                                                             hw_counters, search_pool.get());
 
     if (metric == diskann::FAST_L2)
-        index->optimize_index_layout();
+        for (auto &index : indexes)
+            index->optimize_index_layout();
 
     std::cout << "Using " << num_threads << " threads to search" << std::endl;
     std::cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
@@ -126,6 +222,8 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
     std::vector<std::vector<uint32_t>> query_result_ids(Lvec.size());
     std::vector<std::vector<float>> query_result_dists(Lvec.size());
     std::vector<float> latency_stats(query_num, 0);
+    // the branch and hop counts of the slow queries, only collected when they are dumped
+    std::vector<diskann::QueryStats> query_stats;
     std::vector<uint32_t> cmp_stats;
 
     cmp_stats = std::vector<uint32_t>(query_num, 0);
@@ -150,22 +248,47 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
             query_result_ids[test_id].resize(recall_at * query_num);
             query_result_dists[test_id].resize(recall_at * query_num);
             std::vector<T *> res = std::vector<T *>();
-            auto start = std::chrono::high_resolution_clock::now();
+            if (num_slow_queries > 0)
+                query_stats.assign(query_num, diskann::QueryStats());
             omp_set_num_threads(num_threads);
-#pragma omp parallel for schedule(dynamic, 1)
-            for (int64_t i = 0; i < (int64_t)query_num; i++)
-            {
+            if (profiler)
+                profiler->start("L" + std::to_string(L) + "_run" + std::to_string(run_count));
+            auto search_query = [&](const size_t i, const uint32_t thread_id) {
+                auto &index = indexes[search_pool ? search_pool->thread_node(thread_id) : 0];
                 auto qs = std::chrono::high_resolution_clock::now();
 
                 std::vector<std::string> raw_filter = query_filters[i];
-                auto retval = index->search_with_multi_filters(query + i * query_aligned_dim, raw_filter, recall_at, L,
-                                                               query_result_ids[test_id].data() + i * recall_at,
-                                                               query_result_dists[test_id].data() + i * recall_at);
+                index->search_with_multi_filters(query + i * query_aligned_dim, raw_filter, recall_at, L,
+                                                 query_result_ids[test_id].data() + i * recall_at,
+                                                 query_result_dists[test_id].data() + i * recall_at,
+                                                 num_slow_queries > 0 ? query_stats.data() + i : nullptr);
+                std::chrono::duration<float, std::micro> query_time = std::chrono::high_resolution_clock::now() - qs;
+                latency_stats[i] = query_time.count();
+            };
+
+            auto start = std::chrono::high_resolution_clock::now();
+            if (search_pool)
+            {
+                search_pool->parallel_for(query_num, chunk_size, search_query);
+            }
+            else
+            {
+#pragma omp parallel for schedule(dynamic, 1)
+                for (int64_t i = 0; i < (int64_t)query_num; i++)
+                    search_query((size_t)i, 0);
             }
             std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - start;
+            if (profiler)
+                profiler->stop(query_num);
             auto search_time = diff.count();
             std::cout << "Search with L=" << L << ", time=" << search_time << std::endl;
             search_times.emplace_back(search_time);
+            // before the percentiles sort latency_stats
+            if (result_path_prefix != "" && num_slow_queries > 0)
+                save_slow_queries(result_path_prefix + "_L" + std::to_string(L) + "_slow_queries.tsv",
+                                  num_slow_queries, latency_stats, query_stats, query_filters);
+            report_latency_percentiles(result_path_prefix != "" ? result_path_prefix + "_latency.csv" : "", L,
+                                       run_count, latency_stats);
             if (result_path_prefix != "")
             {
                 std::string cur_result_path_prefix = result_path_prefix + "_L" + std::to_string(L);
@@ -185,6 +308,7 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
     // TODO: save search metadata to file
     // store search_metadata for contest store_results() to hdf5 file
 
+    DISKANN_INSTRUMENT_REPORT(result_path_prefix + "_search_instrumentation.json");
     diskann::aligned_free(query);
     return 0;
 }
@@ -192,8 +316,11 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
 int main(int argc, char **argv)
 {
     std::string data_type, dist_fn, index_path_prefix, query_file, gt_file, label_type, query_filters_file,
-        result_path_prefix, dataset;
-    uint32_t num_threads, K, runs;
+        result_path_prefix, dataset, profile_prefix, scheduler, numa, huge_pages;
+    uint32_t num_threads, K, runs, num_slow_queries, chunk_size;
+    diskann::NumaPlacement numa_placement;
+    diskann::HugePagePolicy huge_page_policy;
+    bool heap_profile, hw_counters;
     std::vector<uint32_t> Lvec;
 
     // Default paramters
@@ -234,7 +361,28 @@ int main(int argc, char **argv)
                                        program_options_utils::NUMBER_OF_RESULTS_DESCRIPTION);
         optional_configs.add_options()("dataset", po::value<std::string>(&dataset)->default_value("yfcc-10M"),
                                        program_options_utils::DATA_TYPE_DESCRIPTION);
-        desc.add(required_configs).add(optional_configs);
+        optional_configs.add_options()("slow_queries", po::value<uint32_t>(&num_slow_queries)->default_value(0),
+                                       "Write the ids, filters and search branch of this many slowest queries in "
+                                       "the last run of every L to <result_path_prefix>_L<L>_slow_queries.tsv. "
+                                       "Collecting them times the phases of every query. Default 0.");
+        optional_configs.add_options()("scheduler", po::value<std::string>(&scheduler)->default_value("omp"),
+                                       program_options_utils::SEARCH_SCHEDULER_DESCRIPTION);
+        optional_configs.add_options()("chunk_size", po::value<uint32_t>(&chunk_size)->default_value(8),
+                                       program_options_utils::SEARCH_CHUNK_SIZE_DESCRIPTION);
+        optional_configs.add_options()("numa", po::value<std::string>(&numa)->default_value("none"),
+                                       program_options_utils::NUMA_PLACEMENT_DESCRIPTION);
+        optional_configs.add_options()("huge_pages", po::value<std::string>(&huge_pages)->default_value("none"),
+                                       program_options_utils::HUGE_PAGES_DESCRIPTION);
+
+        // Profiling
+        po::options_description profiling_configs("Profiling");
+        profiling_configs.add_options()("profile", po::value<std::string>(&profile_prefix)->default_value(""),
+                                        program_options_utils::PROFILE_DESCRIPTION);
+        profiling_configs.add_options()("heap_profile", po::bool_switch(&heap_profile),
+                                        program_options_utils::HEAP_PROFILE_DESCRIPTION);
+        profiling_configs.add_options()("hw_counters", po::bool_switch(&hw_counters),
+                                        program_options_utils::HW_COUNTERS_DESCRIPTION);
+        desc.add(required_configs).add(optional_configs).add(profiling_configs);
 
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -244,6 +392,8 @@ int main(int argc, char **argv)
             return 0;
         }
         po::notify(vm);
+        numa_placement = diskann::get_numa_placement(numa);
+        huge_page_policy = diskann::get_huge_page_policy(huge_pages);
     }
     catch (const std::exception &ex)
     {
@@ -266,17 +416,43 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    if (scheduler != std::string("pool") && scheduler != std::string("omp"))
+    {
+        std::cout << "Unsupported scheduler " << scheduler << ". Use pool or omp." << std::endl;
+        return -1;
+    }
+
+    if (numa_placement == diskann::NumaPlacement::Replicate && scheduler != std::string("pool"))
+    {
+        std::cout << "--numa replicate routes queries by pool thread and needs --scheduler pool." << std::endl;
+        return -1;
+    }
+
+    if (num_slow_queries > 0 && result_path_prefix.empty())
+    {
+        std::cout << "--slow_queries writes to <result_path_prefix>_L<L>_slow_queries.tsv and needs a non-empty "
+                     "--result_path_prefix."
+                  << std::endl;
+        return -1;
+    }
+
     try
     {
         if (data_type == std::string("uint8"))
         {
             return search_memory_index<uint8_t, uint32_t>(metric, index_path_prefix, query_file, num_threads, K, Lvec,
-                                                          query_filters_file, result_path_prefix, dataset, runs);
+                                                          query_filters_file, result_path_prefix, dataset, runs,
+                                                          profile_prefix, heap_profile, hw_counters,
+                                                          num_slow_queries, scheduler == "pool", chunk_size,
+                                                          numa_placement, huge_page_policy);
         }
         else if (data_type == std::string("float"))
         {
             return search_memory_index<float, uint32_t>(metric, index_path_prefix, query_file, num_threads, K, Lvec,
-                                                        query_filters_file, result_path_prefix, dataset, runs);
+                                                        query_filters_file, result_path_prefix, dataset, runs,
+                                                        profile_prefix, heap_profile, hw_counters, num_slow_queries,
+                                                        scheduler == "pool", chunk_size, numa_placement,
+                                                        huge_page_policy);
         }
     }
     catch (std::exception &e)
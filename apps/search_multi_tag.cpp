@@ -18,6 +18,9 @@
 #endif
 
 #include "index.h"
+#include "instrumentation.h"
+#include "search_profiler.h"
+#include "search_thread_pool.h"
 #include "memory_mapper.h"
 #include "utils.h"
 #include "program_options_utils.hpp"
@@ -30,7 +33,11 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                         const std::string &query_file, const std::string &truthset_file, const uint32_t num_threads,
                         const uint32_t recall_at, const bool print_all_recalls, const std::vector<uint32_t> &Lvec,
                         const bool dynamic, const bool tags, const bool show_qps_per_thread,
-                        const std::string &query_filter_file, const float fail_if_recall_below)
+                        const std::string &query_filter_file, const float fail_if_recall_below,
+                        const uint32_t num_pq_chunks, const bool pq_fast_scan, const bool mmap_data,
+                        const uint32_t sq_bits, const bool print_query_stats, const std::string &profile_prefix,
+                        const bool heap_profile, const bool hw_counters, const bool use_search_pool,
+                        const uint32_t chunk_size, const diskann::HugePagePolicy huge_pages)
 {
     using TagT = uint32_t;
     // Load the query file
@@ -76,11 +83,17 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
 
     std::cout<<"num_frozen_pts:"<<num_frozen_pts<<std::endl;
 
+    diskann::DataStoreStrategy data_strategy = diskann::DataStoreStrategy::MEMORY;
+    if (sq_bits == 8)
+        data_strategy = diskann::DataStoreStrategy::MEMORY_SQ8;
+    else if (sq_bits == 4)
+        data_strategy = diskann::DataStoreStrategy::MEMORY_SQ4;
+
     auto config = diskann::IndexConfigBuilder()
                       .with_metric(metric)
                       .with_dimension(query_dim)
                       .with_max_points(0)
-                      .with_data_load_store_strategy(diskann::DataStoreStrategy::MEMORY)
+                      .with_data_load_store_strategy(data_strategy)
                       .with_graph_load_store_strategy(diskann::GraphStoreStrategy::MEMORY)
                       .with_data_type(diskann_type_to_name<T>())
                       .with_label_type(diskann_type_to_name<LabelT>())
@@ -90,14 +103,29 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
                       .is_concurrent_consolidate(false)
                       .is_pq_dist_build(false)
                       .is_use_opq(false)
-                      .with_num_pq_chunks(0)
+                      .is_pq_dist_search(num_pq_chunks > 0)
+                      .is_pq_fast_scan(pq_fast_scan)
+                      .is_mmap_full_vectors(mmap_data)
+                      .with_num_pq_chunks(num_pq_chunks)
                       .with_num_frozen_pts(num_frozen_pts)
+                      .with_huge_pages(huge_pages)
                       .build();
 
     auto index_factory = diskann::IndexFactory(config);
     auto index = index_factory.create_instance();
     index->load(index_path.c_str(), num_threads, *(std::max_element(Lvec.begin(), Lvec.end())));
     std::cout << "Index loaded" << std::endl;
+    // leave the load out of the instrumentation report
+    DISKANN_INSTRUMENT_RESET();
+
+    std::unique_ptr<diskann::SearchThreadPool> search_pool;
+    if (use_search_pool)
+        search_pool = std::make_unique<diskann::SearchThreadPool>(num_threads);
+
+    std::unique_ptr<diskann::SearchProfiler> profiler;
+    if (!profile_prefix.empty())
+        profiler = std::make_unique<diskann::SearchProfiler>(profile_prefix, num_threads, true, heap_profile,
+                                                             hw_counters, search_pool.get());
 
     if (metric == diskann::FAST_L2)
         index->optimize_index_layout();
@@ -142,6 +170,9 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
         cmp_stats = std::vector<uint32_t>(query_num, 0);
     }
 
+    // per-query counters and time split of the search, per L
+    std::vector<std::vector<diskann::QueryStats>> query_stats(Lvec.size());
+
     std::vector<TagT> query_result_tags;
     if (tags)
     {
@@ -162,15 +193,13 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
         query_result_ids[test_id].resize(recall_at * query_num);
         query_result_dists[test_id].resize(recall_at * query_num);
         std::vector<T *> res = std::vector<T *>();
+        if (print_query_stats)
+            query_stats[test_id].resize(query_num);
 
-        auto s = std::chrono::high_resolution_clock::now();
         omp_set_num_threads(num_threads);
-#pragma omp parallel for schedule(dynamic, 1)
-        for (int64_t i = 0; i < (int64_t)query_num; i++)
-        {
-            // if (i==20){
-            //     std::cout<<std::endl;
-            // }
+        if (profiler)
+            profiler->start("L" + std::to_string(L));
+        auto search_query = [&](const size_t i) {
             auto qs = std::chrono::high_resolution_clock::now();
             if (filtered_search)
             {
@@ -178,15 +207,30 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
 
                 auto retval = index->search_with_multi_filters(query + i * query_aligned_dim, raw_filter, recall_at, L,
                                                          query_result_ids[test_id].data() + i * recall_at,
-                                                         query_result_dists[test_id].data() + i * recall_at);
+                                                         query_result_dists[test_id].data() + i * recall_at,
+                                                         print_query_stats ? query_stats[test_id].data() + i : nullptr);
                 cmp_stats[i] = retval.second;
             }
             
             auto qe = std::chrono::high_resolution_clock::now();
             std::chrono::duration<double> diff = qe - qs;
             latency_stats[i] = (float)(diff.count() * 1000000);
+        };
+
+        auto s = std::chrono::high_resolution_clock::now();
+        if (search_pool)
+        {
+            search_pool->parallel_for(query_num, chunk_size, [&](size_t i, uint32_t) { search_query(i); });
+        }
+        else
+        {
+#pragma omp parallel for schedule(dynamic, 1)
+            for (int64_t i = 0; i < (int64_t)query_num; i++)
+                search_query((size_t)i);
         }
         std::chrono::duration<double> diff = std::chrono::high_resolution_clock::now() - s;
+        if (profiler)
+            profiler->stop(query_num);
 
         double displayed_qps = query_num / diff.count();
 
@@ -229,6 +273,49 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
         std::cout << std::endl;
     }
 
+    if (print_query_stats)
+    {
+        std::cout << std::endl
+                  << std::setw(4) << "Ls" << std::setw(12) << "Avg hops" << std::setw(12) << "Init ids"
+                  << std::setw(16) << "Filter checks"
+                  << std::setw(12) << "Reject %" << std::setw(14) << "Brute force %" << std::setw(14) << "Filter (mus)"
+                  << std::setw(12) << "Dist (mus)" << std::setw(14) << "Queue (mus)" << std::setw(15) << "99.9 Latency"
+                  << std::endl;
+        std::cout << std::string(4 + 12 + 12 + 16 + 12 + 14 + 14 + 12 + 14 + 15, '=') << std::endl;
+        for (uint32_t test_id = 0; test_id < Lvec.size(); test_id++)
+        {
+            diskann::QueryStats *l_stats = query_stats[test_id].data();
+            if (query_stats[test_id].empty())
+                continue;
+
+            auto mean_hops = diskann::get_mean_stats<uint32_t>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.n_hops; });
+            auto mean_init_ids = diskann::get_mean_stats<uint32_t>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.n_init_ids; });
+            auto mean_checks = diskann::get_mean_stats<uint32_t>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.n_filter_checks; });
+            auto mean_rejects = diskann::get_mean_stats<uint32_t>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.n_filter_rejects; });
+            auto brute_force_share = diskann::get_mean_stats<uint32_t>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.brute_force ? 1u : 0u; });
+            auto mean_filter_us = diskann::get_mean_stats<float>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.filter_us; });
+            auto mean_dist_us = diskann::get_mean_stats<float>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.dist_us; });
+            auto mean_queue_us = diskann::get_mean_stats<float>(
+                l_stats, query_num, [](const diskann::QueryStats &stats) { return stats.queue_us; });
+            auto latency_999 = diskann::get_percentile_stats<float>(
+                l_stats, query_num, 0.999f, [](const diskann::QueryStats &stats) { return stats.total_us; });
+
+            std::cout << std::setw(4) << Lvec[test_id] << std::setw(12) << mean_hops << std::setw(12) << mean_init_ids
+                      << std::setw(16) << mean_checks
+                      << std::setw(12) << (mean_checks > 0 ? 100.0 * mean_rejects / mean_checks : 0.0)
+                      << std::setw(14) << 100.0 * brute_force_share << std::setw(14) << mean_filter_us
+                      << std::setw(12) << mean_dist_us << std::setw(14) << mean_queue_us << std::setw(15)
+                      << latency_999 << std::endl;
+        }
+    }
+
     std::cout << "Done searching. Now saving results " << std::endl;
     // uint64_t test_id = 0;
     // for (auto L : Lvec)
@@ -249,6 +336,7 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
     //     test_id++;
     // }
 
+    DISKANN_INSTRUMENT_REPORT(index_path + "_search_instrumentation.json");
     diskann::aligned_free(query);
     return best_recall >= fail_if_recall_below ? 0 : -1;
 }
@@ -256,10 +344,12 @@ int search_memory_index(diskann::Metric &metric, const std::string &index_path,
 int main(int argc, char **argv)
 {
     std::string data_type, dist_fn, index_path_prefix, query_file, gt_file, label_type,
-        query_filters_file;
-    uint32_t num_threads, K;
+        query_filters_file, profile_prefix, scheduler, huge_pages;
+    uint32_t num_threads, K, num_pq_chunks, sq_bits, chunk_size;
+    diskann::HugePagePolicy huge_page_policy;
     std::vector<uint32_t> Lvec;
-    bool print_all_recalls, dynamic, tags, show_qps_per_thread;
+    bool print_all_recalls, dynamic, tags, show_qps_per_thread, pq_fast_scan, generate_pq, mmap_data, print_query_stats,
+        heap_profile, hw_counters;
     float fail_if_recall_below = 0.0f;
 
     po::options_description desc{
@@ -305,6 +395,32 @@ int main(int argc, char **argv)
         optional_configs.add_options()("fail_if_recall_below",
                                        po::value<float>(&fail_if_recall_below)->default_value(0.0f),
                                        program_options_utils::FAIL_IF_RECALL_BELOW);
+        optional_configs.add_options()("num_pq_chunks", po::value<uint32_t>(&num_pq_chunks)->default_value(0),
+                                       "Number of PQ bytes per vector to traverse the graph with, results are "
+                                       "re-ranked with full precision vectors. Unless mmap_data is set, the full "
+                                       "precision vectors stay loaded next to the PQ codes, so this trades memory for "
+                                       "traversal bandwidth and saves no memory. 0 searches with full precision only. "
+                                       "Default 0.");
+        optional_configs.add_options()("pq_fast_scan", po::bool_switch(&pq_fast_scan),
+                                       "With num_pq_chunks, use 4-bit PQ codes (two chunks per byte) and fast scan "
+                                       "lookups. Pass twice the chunks for the bytes of 8-bit PQ.");
+        optional_configs.add_options()("generate_pq", po::bool_switch(&generate_pq),
+                                       "Train PQ with num_pq_chunks (and pq_fast_scan) on <index_path_prefix>.data, "
+                                       "write the files PQ search loads and exit. Run once before searching with "
+                                       "num_pq_chunks.");
+        optional_configs.add_options()("mmap_data", po::bool_switch(&mmap_data),
+                                       "With num_pq_chunks, memory map the full precision vectors instead of "
+                                       "loading them, so only the PQ codes stay in memory. With sq_bits, memory map "
+                                       "them to re-rank results.");
+        optional_configs.add_options()("sq_bits", po::value<uint32_t>(&sq_bits)->default_value(0),
+                                       "Keep float vectors scalar quantized to 8 or 4 bits per dimension. 0 keeps "
+                                       "full precision vectors. Default 0.");
+        optional_configs.add_options()("scheduler", po::value<std::string>(&scheduler)->default_value("omp"),
+                                       program_options_utils::SEARCH_SCHEDULER_DESCRIPTION);
+        optional_configs.add_options()("chunk_size", po::value<uint32_t>(&chunk_size)->default_value(8),
+                                       program_options_utils::SEARCH_CHUNK_SIZE_DESCRIPTION);
+        optional_configs.add_options()("huge_pages", po::value<std::string>(&huge_pages)->default_value("none"),
+                                       program_options_utils::HUGE_PAGES_DESCRIPTION);
 
         // Output controls
         po::options_description output_controls("Output controls");
@@ -314,9 +430,21 @@ int main(int argc, char **argv)
         output_controls.add_options()("print_qps_per_thread", po::bool_switch(&show_qps_per_thread),
                                       "Print overall QPS divided by the number of threads in "
                                       "the output table");
+        output_controls.add_options()("print_query_stats", po::bool_switch(&print_query_stats),
+                                      "Collect per-query hops, filter checks and the time split between label "
+                                      "matching, distances and the candidate pools, and print their means per L");
+
+        // Profiling
+        po::options_description profiling_configs("Profiling");
+        profiling_configs.add_options()("profile", po::value<std::string>(&profile_prefix)->default_value(""),
+                                        program_options_utils::PROFILE_DESCRIPTION);
+        profiling_configs.add_options()("heap_profile", po::bool_switch(&heap_profile),
+                                        program_options_utils::HEAP_PROFILE_DESCRIPTION);
+        profiling_configs.add_options()("hw_counters", po::bool_switch(&hw_counters),
+                                        program_options_utils::HW_COUNTERS_DESCRIPTION);
 
         // Merge required and optional parameters
-        desc.add(required_configs).add(optional_configs).add(output_controls);
+        desc.add(required_configs).add(optional_configs).add(output_controls).add(profiling_configs);
 
         po::variables_map vm;
         po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -326,6 +454,7 @@ int main(int argc, char **argv)
             return 0;
         }
         po::notify(vm);
+        huge_page_policy = diskann::get_huge_page_policy(huge_pages);
     }
     catch (const std::exception &ex)
     {
@@ -359,25 +488,62 @@ int main(int argc, char **argv)
         return -1;
     }
 
+    if (sq_bits != 0 && ((sq_bits != 8 && sq_bits != 4) || data_type != std::string("float")))
+    {
+        std::cout << "sq_bits must be 0, 4 or 8, and scalar quantization needs float data." << std::endl;
+        return -1;
+    }
+
+    if (scheduler != std::string("pool") && scheduler != std::string("omp"))
+    {
+        std::cout << "Unsupported scheduler " << scheduler << ". Use pool or omp." << std::endl;
+        return -1;
+    }
+
+    if (generate_pq && num_pq_chunks == 0)
+    {
+        std::cout << "--generate_pq needs --num_pq_chunks." << std::endl;
+        return -1;
+    }
+
     try
     {
+        if (generate_pq)
+        {
+            if (data_type == std::string("int8"))
+                diskann::generate_pq_search_data<int8_t>(index_path_prefix, metric, num_pq_chunks, false, pq_fast_scan);
+            else if (data_type == std::string("uint8"))
+                diskann::generate_pq_search_data<uint8_t>(index_path_prefix, metric, num_pq_chunks, false,
+                                                          pq_fast_scan);
+            else if (data_type == std::string("float"))
+                diskann::generate_pq_search_data<float>(index_path_prefix, metric, num_pq_chunks, false, pq_fast_scan);
+            return 0;
+        }
+
         if (data_type == std::string("int8"))
         {
             return search_memory_index<int8_t, uint32_t>(
                 metric, index_path_prefix,  query_file, gt_file, num_threads, K, print_all_recalls,
-                Lvec, dynamic, tags, show_qps_per_thread, query_filters_file, fail_if_recall_below);
+                Lvec, dynamic, tags, show_qps_per_thread, query_filters_file, fail_if_recall_below, num_pq_chunks,
+                pq_fast_scan, mmap_data, sq_bits, print_query_stats, profile_prefix, heap_profile, hw_counters,
+                scheduler == "pool", chunk_size, huge_page_policy);
         }
         else if (data_type == std::string("uint8"))
         {
             return search_memory_index<uint8_t, uint32_t>(
                 metric, index_path_prefix,  query_file, gt_file, num_threads, K, print_all_recalls,
-                Lvec, dynamic, tags, show_qps_per_thread, query_filters_file, fail_if_recall_below);
+                Lvec, dynamic, tags, show_qps_per_thread, query_filters_file, fail_if_recall_below, num_pq_chunks,
+                pq_fast_scan, mmap_data, sq_bits, print_query_stats, profile_prefix, heap_profile, hw_counters,
+                scheduler == "pool", chunk_size, huge_page_policy);
         }
         else if (data_type == std::string("float"))
         {
             return search_memory_index<float, uint32_t>(metric, index_path_prefix, query_file, gt_file,
                                                         num_threads, K, print_all_recalls, Lvec, dynamic, tags,
-                                                        show_qps_per_thread, query_filters_file, fail_if_recall_below);
+                                                        show_qps_per_thread, query_filters_file, fail_if_recall_below,
+                                                        num_pq_chunks, pq_fast_scan, mmap_data, sq_bits,
+                                                        print_query_stats, profile_prefix, heap_profile, hw_counters,
+                                                        scheduler == "pool", chunk_size, huge_page_policy);
         }
     }
     catch (std::exception &e)
@@ -9,7 +9,7 @@
 
 template <typename T>
 bool generate_pq(const std::string &data_path, const std::string &index_prefix_path, const size_t num_pq_centers,
-                 const size_t num_pq_chunks, const float sampling_rate, const bool opq)
+                 const size_t num_pq_chunks, const float sampling_rate, const bool opq, const size_t kmeans_batch_size)
 {
     std::string pq_pivots_path = index_prefix_path + "_pq_pivots.bin";
     std::string pq_compressed_vectors_path = index_prefix_path + "_pq_compressed.bin";
@@ -23,12 +23,13 @@ bool generate_pq(const std::string &data_path, const std::string &index_prefix_p
     if (opq)
     {
         diskann::generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, (uint32_t)num_pq_centers,
-                                     (uint32_t)num_pq_chunks, pq_pivots_path, true);
+                                     (uint32_t)num_pq_chunks, pq_pivots_path, true, kmeans_batch_size);
     }
     else
     {
         diskann::generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, (uint32_t)num_pq_centers,
-                                    (uint32_t)num_pq_chunks, KMEANS_ITERS_FOR_PQ, pq_pivots_path);
+                                    (uint32_t)num_pq_chunks, KMEANS_ITERS_FOR_PQ, pq_pivots_path, false,
+                                    kmeans_batch_size);
     }
     diskann::generate_pq_data_from_pivots<T>(data_path, (uint32_t)num_pq_centers, (uint32_t)num_pq_chunks,
                                              pq_pivots_path, pq_compressed_vectors_path, true);
@@ -40,13 +41,13 @@ bool generate_pq(const std::string &data_path, const std::string &index_prefix_p
 
 int main(int argc, char **argv)
 {
-    if (argc != 7)
+    if (argc != 7 && argc != 8)
     {
         std::cout << "Usage: \n"
                   << argv[0]
                   << "  <data_type[float/uint8/int8]>   <data_file[.bin]>"
                      "  <PQ_prefix_path>  <target-bytes/data-point>  "
-                     "<sampling_rate> <PQ(0)/OPQ(1)>"
+                     "<sampling_rate> <PQ(0)/OPQ(1)>  [kmeans_batch_size, 0 for full k-means]"
                   << std::endl;
     }
     else
@@ -57,13 +58,17 @@ int main(int argc, char **argv)
         const size_t num_pq_chunks = (size_t)atoi(argv[4]);
         const float sampling_rate = (float)atof(argv[5]);
         const bool opq = atoi(argv[6]) == 0 ? false : true;
+        const size_t kmeans_batch_size = argc == 8 ? (size_t)atoll(argv[7]) : 0;
 
         if (std::string(argv[1]) == std::string("float"))
-            generate_pq<float>(data_path, index_prefix_path, num_pq_centers, num_pq_chunks, sampling_rate, opq);
+            generate_pq<float>(data_path, index_prefix_path, num_pq_centers, num_pq_chunks, sampling_rate, opq,
+                               kmeans_batch_size);
         else if (std::string(argv[1]) == std::string("int8"))
-            generate_pq<int8_t>(data_path, index_prefix_path, num_pq_centers, num_pq_chunks, sampling_rate, opq);
+            generate_pq<int8_t>(data_path, index_prefix_path, num_pq_centers, num_pq_chunks, sampling_rate, opq,
+                                kmeans_batch_size);
         else if (std::string(argv[1]) == std::string("uint8"))
-            generate_pq<uint8_t>(data_path, index_prefix_path, num_pq_centers, num_pq_chunks, sampling_rate, opq);
+            generate_pq<uint8_t>(data_path, index_prefix_path, num_pq_centers, num_pq_chunks, sampling_rate, opq,
+                                 kmeans_batch_size);
         else
             std::cout << "Error. wrong file type" << std::endl;
     }
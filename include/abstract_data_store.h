@@ -60,6 +60,11 @@ template <typename data_t> class AbstractDataStore
     //    //ERROR.
     virtual location_t resize(const location_t new_num_points);
 
+    // Frees the stored vectors and sets the capacity to 0, for an index that
+    // reads its vectors from elsewhere, e.g. a memory mapped data file. The
+    // dimensions and distance function stay available.
+    virtual void release_vectors() = 0;
+
     // operations on vectors
     // like populate_data function, but over one vector at a time useful for
     // streaming setting
@@ -5,6 +5,7 @@
 #include "types.h"
 #include "index_config.h"
 #include "index_build_params.h"
+#include "percentile_stats.h"
 #include <any>
 
 namespace diskann
@@ -77,10 +78,12 @@ class AbstractIndex
     std::pair<uint32_t, uint32_t> search_with_filters(const DataType &query, const std::string &raw_label,
                                                       const size_t K, const uint32_t L, IndexType *indices,
                                                       float *distances);
+    // stats, when given, receives the hop, comparison and filter counts of
+    // the query and where its time went.
     template <typename IndexType>
     std::pair<uint32_t, uint32_t> search_with_multi_filters(const DataType &query, const std::vector<std::string> &query_filters,
                                                             const size_t &K, const uint32_t &L, IndexType *indices,
-                                                            float *distances);
+                                                            float *distances, QueryStats *stats = nullptr);
     void convert_filters();
 
     template <typename data_type, typename tag_type> int insert_point(const data_type *point, const tag_type tag);
@@ -110,7 +113,7 @@ class AbstractIndex
                                                                float *distances) = 0;
     virtual std::pair<uint32_t, uint32_t> _search_with_multi_filters(const DataType &query, const std::vector<std::string> &query_filters,
                                                             const size_t &K, const uint32_t &L, std::any &indices,
-                                                            float *distances) = 0;
+                                                            float *distances, QueryStats *stats) = 0;
     virtual int _insert_point(const DataType &data_point, const TagType tag) = 0;
     virtual int _lazy_delete(const TagType &tag) = 0;
     virtual void _lazy_delete(TagVector &tags, TagVector &failed_tags) = 0;
@@ -109,6 +109,12 @@ class AlignedFileReader
     virtual void deregister_thread() = 0;
     virtual void deregister_all_threads() = 0;
 
+    // optionally pin a buffer that the calling thread reads into, so readers
+    // that support it can skip per-request page mapping; ignored by default
+    virtual void register_buffer(void * /*buf*/, uint64_t /*len*/)
+    {
+    }
+
     // Open & close ops
     // Blocking calls
     virtual void open(const std::string &fname) = 0;
@@ -117,4 +123,23 @@ class AlignedFileReader
     // process batch of aligned requests in parallel
     // NOTE :: blocking call
     virtual void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false) = 0;
+
+    // Split-phase reads for pipelined search. submit_reqs() issues the reads
+    // and returns at once; poll_reqs() waits until at least min_done issued
+    // reads have completed and appends the buf of every completed read to
+    // done_bufs. Only available if supports_async() is true.
+    virtual bool supports_async() const
+    {
+        return false;
+    }
+    virtual void submit_reqs(std::vector<AlignedRead> & /*read_reqs*/, IOContext & /*ctx*/)
+    {
+        throw diskann::ANNException("submit_reqs() is not supported by this reader", -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    }
+    virtual void poll_reqs(IOContext & /*ctx*/, uint64_t /*min_done*/, std::vector<void *> & /*done_bufs*/)
+    {
+        throw diskann::ANNException("poll_reqs() is not supported by this reader", -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    }
 };
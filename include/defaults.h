@@ -14,6 +14,12 @@ const uint32_t MAX_OCCLUSION_SIZE = 750;
 const uint32_t FILTER_LIST_SIZE = 0;
 const uint32_t NUM_FROZEN_POINTS_STATIC = 0;
 const uint32_t NUM_FROZEN_POINTS_DYNAMIC = 1;
+// number of per-label medoids used to seed a multi-filter search (0 seeds all)
+const uint32_t NUM_FILTER_ENTRY_POINTS = 3;
+// how many candidates ahead graph traversal prefetches vectors and label
+// lists (0 disables prefetching). Off until cache miss counts show a gain;
+// enable per index with Index::set_prefetch_distance, 2 is a starting point.
+const uint32_t PREFETCH_DISTANCE = 0;
 
 // In-mem index related limits
 const float GRAPH_SLACK_FACTOR = 1.3;
@@ -40,6 +40,8 @@ const double THRESHOLD_FOR_CACHING_IN_GB = 1.0;
 const uint32_t NUM_NODES_TO_CACHE = 250000;
 const uint32_t WARMUP_L = 20;
 const uint32_t NUM_KMEANS_REPS = 12;
+// fraction of the nodes whose labels fit in their sector, if labels are stored there
+const double SECTOR_LABELS_COVERAGE = 0.99;
 
 template <typename T, typename LabelT> class PQFlashIndex;
 
@@ -103,6 +105,26 @@ DISKANN_DLLEXPORT int build_disk_index(
 template <typename T>
 DISKANN_DLLEXPORT void create_disk_layout(const std::string base_file, const std::string mem_index_file,
                                           const std::string output_file,
-                                          const std::string reorder_data_file = std::string(""));
+                                          const std::string reorder_data_file = std::string(""),
+                                          const std::string label_file = std::string(""));
+
+// Converts a saved filtered in-memory index (e.g. the stitched index of
+// build_stitched_index) into the files PQFlashIndex::load(index_prefix_path)
+// reads: PQ pivots and codes, the sector layout, labels, per-label medoid
+// lists, universal label and label map. The data file defaults to the
+// index's ".data" file. Only L2 graphs are supported: metric is the one the
+// index was built with, and any other throws an ANNException. With
+// labels_in_sectors every node's labels are also written into its sector, so
+// the loaded index keeps only a 64-bit label signature per point in memory.
+// With pq_fast_scan the PQ codes are 4-bit (16 centroids per chunk), which
+// the loaded index searches with fast scan lookups.
+template <typename T>
+DISKANN_DLLEXPORT int create_disk_index_from_mem_index(const std::string &mem_index_path,
+                                                       const std::string &index_prefix_path,
+                                                       const size_t num_pq_chunks, const bool use_opq = false,
+                                                       const std::string &data_file = std::string(""),
+                                                       const bool labels_in_sectors = false,
+                                                       const bool pq_fast_scan = false,
+                                                       const diskann::Metric metric = diskann::Metric::L2);
 
 } // namespace diskann
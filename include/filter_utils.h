@@ -68,6 +68,22 @@ template <typename T>
 DISKANN_DLLEXPORT void generate_label_indices(path input_data_path, path final_index_path_prefix, label_set all_labels,
                                               unsigned R, unsigned L, float alpha, unsigned num_threads);
 
+/*
+ * Builds a stitched index over num_points vectors of data in memory, the
+ * in-process counterpart of the build_stitched_index app: a vanilla index per
+ * label, built without per-label data files, unioned into one graph that is
+ * pruned to stitched_R and saved under final_index_path_prefix.
+ *
+ * point_labels[i] holds the raw labels of point i, at least one per point.
+ * Raw labels are mapped to label ids in _labels_map.txt in the same way as
+ * convert_labels_string_to_int does for label files.
+ */
+template <typename T>
+DISKANN_DLLEXPORT void build_stitched_index(const T *data, size_t num_points, size_t dim,
+                                            const std::vector<std::vector<uint32_t>> &point_labels,
+                                            path final_index_path_prefix, uint32_t R, uint32_t L, uint32_t stitched_R,
+                                            float alpha, uint32_t num_threads);
+
 DISKANN_DLLEXPORT load_label_index_return_values load_label_index(path label_index_path,
                                                                   uint32_t label_number_of_points);
 
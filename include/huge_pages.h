@@ -0,0 +1,92 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Page backing of the large arrays of an in-memory index: the vectors of the
+// data store, the optimized (FAST_L2) node layout and the label signatures.
+// Random accesses across an index of millions of points miss the dTLB on
+// almost every hop with 4KB pages.
+//  - None: aligned_alloc, as before.
+//  - Transparent: 2MB aligned anonymous memory with madvise(MADV_HUGEPAGE).
+//    Needs /sys/kernel/mm/transparent_hugepage/enabled set to madvise or
+//    always.
+//  - Explicit2MB, Explicit1GB: hugetlbfs pages reserved in
+//    /proc/sys/vm/nr_hugepages (or the 1GB pool). Falls back to Transparent
+//    when the pool has too few free pages.
+// Only Linux backs memory with huge pages; elsewhere every policy is None.
+enum class HugePagePolicy
+{
+    None,
+    Transparent,
+    Explicit2MB,
+    Explicit1GB
+};
+
+// Parses none, thp, 2mb or 1gb.
+DISKANN_DLLEXPORT HugePagePolicy get_huge_page_policy(const std::string &policy);
+
+// Allocates size bytes aligned to alignment (a power of two dividing size).
+// Huge page backed memory is rounded up to a whole number of pages and zero
+// filled. Small arrays would waste most of such a page: 1GB pages are used
+// only from 1GB on, with 2MB pages below that, and arrays under 2MB get
+// regular aligned memory whatever the policy. Free with huge_page_free,
+// passing the same size and policy.
+DISKANN_DLLEXPORT void *huge_page_alloc(const size_t size, const size_t alignment, const HugePagePolicy policy);
+DISKANN_DLLEXPORT void huge_page_free(void *ptr, const size_t size, const HugePagePolicy policy);
+
+// Allocator for std::vector members that should follow the huge page policy
+// of their index.
+template <typename T> class HugePageAllocator
+{
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    HugePageAllocator(const HugePagePolicy policy = HugePagePolicy::None) noexcept : _policy(policy)
+    {
+    }
+
+    template <typename U> HugePageAllocator(const HugePageAllocator<U> &other) noexcept : _policy(other.policy())
+    {
+    }
+
+    T *allocate(const size_t n)
+    {
+        return (T *)huge_page_alloc(n * sizeof(T), alignof(T), _policy);
+    }
+
+    void deallocate(T *ptr, const size_t n) noexcept
+    {
+        huge_page_free(ptr, n * sizeof(T), _policy);
+    }
+
+    HugePagePolicy policy() const noexcept
+    {
+        return _policy;
+    }
+
+    template <typename U> bool operator==(const HugePageAllocator<U> &other) const noexcept
+    {
+        return _policy == other.policy();
+    }
+
+    template <typename U> bool operator!=(const HugePageAllocator<U> &other) const noexcept
+    {
+        return _policy != other.policy();
+    }
+
+  private:
+    HugePagePolicy _policy;
+};
+} // namespace diskann
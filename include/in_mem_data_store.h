@@ -15,13 +15,15 @@
 #include "natural_number_map.h"
 #include "natural_number_set.h"
 #include "aligned_file_reader.h"
+#include "huge_pages.h"
 
 namespace diskann
 {
 template <typename data_t> class InMemDataStore : public AbstractDataStore<data_t>
 {
   public:
-    InMemDataStore(const location_t capacity, const size_t dim, std::unique_ptr<Distance<data_t>> distance_fn);
+    InMemDataStore(const location_t capacity, const size_t dim, std::unique_ptr<Distance<data_t>> distance_fn,
+                   const HugePagePolicy huge_pages = HugePagePolicy::None);
     virtual ~InMemDataStore();
 
     virtual location_t load(const std::string &filename) override;
@@ -55,6 +57,8 @@ template <typename data_t> class InMemDataStore : public AbstractDataStore<data_
 
     virtual size_t get_alignment_factor() const override;
 
+    virtual void release_vectors() override;
+
   protected:
     virtual location_t expand(const location_t new_size) override;
     virtual location_t shrink(const location_t new_size) override;
@@ -66,6 +70,7 @@ template <typename data_t> class InMemDataStore : public AbstractDataStore<data_
 
   private:
     data_t *_data = nullptr;
+    HugePagePolicy _huge_pages; // backing of _data
 
     size_t _aligned_dim;
 
@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <memory>
+
+#include "abstract_data_store.h"
+
+#include "distance.h"
+#include "aligned_file_reader.h"
+#include "huge_pages.h"
+
+namespace diskann
+{
+// In-memory data store that keeps every vector as per-dimension scalar
+// quantized codes (8 or 4 bits per dimension) instead of raw data_t values.
+// Queries stay in full precision and are compared against the codes with
+// asymmetric distance kernels, so no per-query preprocessing is needed.
+//
+// Quantization ranges are trained on the data passed to load/populate_data.
+// get_vector() returns de-quantized vectors, so exact re-ranking must read
+// the original data file (see IndexConfigBuilder::is_mmap_full_vectors), and
+// save() refuses to write them over the full precision format.
+template <typename data_t> class InMemSQDataStore : public AbstractDataStore<data_t>
+{
+  public:
+    InMemSQDataStore(const location_t capacity, const size_t dim, std::unique_ptr<Distance<data_t>> distance_fn,
+                     const uint32_t num_bits, const HugePagePolicy huge_pages = HugePagePolicy::None);
+    virtual ~InMemSQDataStore();
+
+    virtual location_t load(const std::string &filename) override;
+    virtual size_t save(const std::string &filename, const location_t num_points) override;
+
+    virtual size_t get_aligned_dim() const override;
+
+    // Trains the quantizer on the given vectors and encodes them.
+    virtual void populate_data(const data_t *vectors, const location_t num_pts) override;
+    virtual void populate_data(const std::string &filename, const size_t offset) override;
+
+    virtual void extract_data_to_bin(const std::string &filename, const location_t num_pts) override;
+
+    virtual void get_vector(const location_t i, data_t *target) const override;
+    virtual void set_vector(const location_t i, const data_t *const vector) override;
+    virtual void prefetch_vector(const location_t loc) override;
+
+    virtual void move_vectors(const location_t old_location_start, const location_t new_location_start,
+                              const location_t num_points) override;
+    virtual void copy_vectors(const location_t from_loc, const location_t to_loc, const location_t num_points) override;
+
+    virtual float get_distance(const data_t *query, const location_t loc) const override;
+    virtual float get_distance(const location_t loc1, const location_t loc2) const override;
+    virtual void get_distance(const data_t *query, const location_t *locations, const uint32_t location_count,
+                              float *distances) const override;
+
+    virtual location_t calculate_medoid() const override;
+
+    virtual Distance<data_t> *get_dist_fn() override;
+
+    virtual size_t get_alignment_factor() const override;
+
+    virtual void release_vectors() override;
+
+    uint32_t get_num_bits() const;
+
+  protected:
+    virtual location_t expand(const location_t new_size) override;
+    virtual location_t shrink(const location_t new_size) override;
+
+  private:
+    // Per-dimension min/max training over vectors with stride _aligned_dim,
+    // after any metric preprocessing. Ranges must be final before encode().
+    void reset_ranges();
+    void update_ranges(const float *vectors, const size_t num_pts);
+    void finalize_ranges();
+    void encode(const float *vector, uint8_t *code) const;
+    void decode(const uint8_t *code, float *vector) const;
+
+    // Copies num_pts raw vectors (stride _dim) into buffer as zero padded
+    // floats (stride _aligned_dim) and applies the metric preprocessing.
+    void prepare_batch(const data_t *vectors, const size_t num_pts, float *buffer);
+    location_t populate_from_file(const std::string &filename, const size_t offset);
+
+    // Size of the _codes allocation for num_pts points.
+    size_t codes_bytes(const location_t num_pts) const;
+
+    float asymmetric_distance(const float *query, const uint8_t *code) const;
+    float to_distance(const float raw) const;
+
+    uint8_t *_codes = nullptr;
+    HugePagePolicy _huge_pages; // backing of _codes
+
+    size_t _aligned_dim;
+    size_t _code_size; // bytes per vector
+    uint32_t _num_bits;
+    uint32_t _num_levels;
+    bool _trained = false;
+
+    // Per-dimension reconstruction x = _vmin[d] + code * _delta[d], both of
+    // length _aligned_dim and zero beyond _dim so padding contributes nothing.
+    float *_vmin = nullptr;
+    float *_delta = nullptr;
+
+    Metric _metric;
+    std::unique_ptr<Distance<data_t>> _distance_fn;
+};
+
+} // namespace diskann
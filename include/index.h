@@ -21,6 +21,9 @@
 #include "in_mem_data_store.h"
 #include "in_mem_graph_store.h"
 #include "abstract_index.h"
+#include "memory_mapper.h"
+#include "label_signature.h"
+#include "huge_pages.h"
 
 #define OVERHEAD_FACTOR 1.1
 #define EXPAND_IF_FULL 0
@@ -122,6 +125,18 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // Get converted integer label from string to int map (_label_map)
     DISKANN_DLLEXPORT LabelT get_converted_label(const std::string &raw_label);
 
+    // Whether search_with_multi_filters can search raw_label: it converts to
+    // a label of the index (or the universal label) that has a medoid.
+    DISKANN_DLLEXPORT bool is_searchable_label(const std::string &raw_label);
+
+    // Number of medoids of the rarest query label used as entry points by
+    // search_with_multi_filters. 0 seeds every medoid of that label.
+    DISKANN_DLLEXPORT void set_num_filter_entry_points(uint32_t num_entry_points);
+
+    // Number of candidates ahead that graph traversal prefetches vectors and
+    // label lists for. 0 disables prefetching.
+    DISKANN_DLLEXPORT void set_prefetch_distance(uint32_t prefetch_distance);
+
     // Set starting point of an index before inserting any points incrementally.
     // The data count should be equal to _num_frozen_pts * _aligned_dim.
     DISKANN_DLLEXPORT void set_start_points(const T *data, size_t data_count);
@@ -152,10 +167,14 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
                                                                         const size_t K, const uint32_t L,
                                                                         IndexType *indices, float *distances);
 
+    // stats, when not null, is filled with the hops, distance comparisons
+    // and filter checks of the query, and its time split between label
+    // matching, distances and the candidate pools.
     template <typename IndexType>
     DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> search_with_multi_filters(const T *query, const std::vector<std::string> &query_filters,
                                                                         const size_t &K, const uint32_t &L,
-                                                                        IndexType *indices, float *distances);
+                                                                        IndexType *indices, float *distances,
+                                                                        QueryStats *stats = nullptr);
 
     // Will fail if tag already in the index or if tag=0.
     DISKANN_DLLEXPORT int insert_point(const T *point, const TagT tag);
@@ -224,7 +243,7 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     virtual std::pair<uint32_t, uint32_t> _search_with_multi_filters(const DataType &query,
                                                                const std::vector<std::string> &query_filters, const size_t &K,
                                                                const uint32_t &L, std::any &indices,
-                                                               float *distances) override;                                                               
+                                                               float *distances, QueryStats *stats) override;                                                               
 
     virtual int _insert_point(const DataType &data_point, const TagType tag) override;
 
@@ -262,6 +281,43 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
 
     std::unordered_map<std::string, LabelT> load_label_map(const std::string &map_file);
 
+    // PQ distance search: traversal uses _pq_data, results are re-ranked with
+    // full precision vectors, memory mapped from the data file if requested.
+    // The same re-ranking applies to a quantized data store with mapped vectors.
+    size_t map_full_vectors(const std::string &data_file);
+    void load_pq_search_data(const std::string &index_file, size_t num_points);
+    void get_full_precision_vector(uint32_t location, T *dest);
+    float get_full_precision_distance(const T *aligned_query, uint32_t location, T *vector_scratch);
+    void rerank_with_full_precision(InMemQueryScratch<T> *scratch);
+
+    // Copies the medoid vectors of every label into one contiguous buffer,
+    // grouped by label, so entry point selection scans a single array.
+    void build_filter_entry_points();
+
+    // Appends to init_ids the closest medoids of best_filter to the query,
+    // restricted to medoids carrying every label in filters when any do.
+    void select_filter_entry_points(const T *aligned_query, const LabelT &best_filter,
+                                    const std::vector<LabelT> &filters, std::vector<uint32_t> &init_ids);
+
+    // Label signature filtering of whole neighbor lists. The predicate is
+    // prepared once per search; filter_candidates_by_labels keeps the
+    // candidates sharing a label with filters, along with their
+    // common_filter_size, and only verifies signature hits exactly.
+    void build_label_signatures();
+
+    // Software pipelined prefetching for position m of ids: the vector of
+    // ids[m + N], and the label record of ids[m + 2N] then its label list N
+    // steps later, with N = _prefetch_distance. m == 0 primes the pipeline.
+    // With a mask, only positions with a non-zero mask entry are prefetched.
+    void prefetch_vectors_ahead(const uint32_t *ids, size_t count, size_t m);
+    void prefetch_labels_ahead(const uint32_t *ids, size_t count, size_t m, const uint8_t *mask = nullptr);
+    void prefetch_neighbours(uint32_t location);
+    LabelSignaturePredicate prepare_label_predicate(bool search_invocation, const std::vector<LabelT> &filters);
+    void filter_candidates_by_labels(const std::vector<uint32_t> &candidates, bool search_invocation,
+                                     const std::vector<LabelT> &filters, const LabelSignaturePredicate &predicate,
+                                     std::vector<uint8_t> &hits, std::vector<uint32_t> &ids_out,
+                                     std::vector<uint32_t> &common_sizes_out);
+
     // Returns the locations of start point and frozen points suitable for use
     // with iterate_to_fixed_point.
     std::vector<uint32_t> get_init_ids();
@@ -274,7 +330,8 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     std::pair<uint32_t, uint32_t> iterate_to_fixed_point_v2(const T *node_coords, const uint32_t Lindex,
                                                          const std::vector<uint32_t> &init_ids,
                                                          InMemQueryScratch<T> *scratch, bool use_filter,
-                                                         const std::vector<LabelT> &filters, bool search_invocation, uint32_t location=-1, uint32_t K=10);
+                                                         const std::vector<LabelT> &filters, bool search_invocation, uint32_t location=-1, uint32_t K=10,
+                                                         QueryStats *stats = nullptr);
     
     
     void search_for_point_and_prune(int location, uint32_t Lindex, std::vector<uint32_t> &pruned_list,
@@ -360,7 +417,11 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     // Graph related data structures
     std::unique_ptr<AbstractGraphStore> _graph_store;
 
+    // backing of _opt_graph and _pts_to_label_signature; the data store
+    // gets the same policy from the index config
+    HugePagePolicy _huge_pages = HugePagePolicy::None;
     char *_opt_graph = nullptr;
+    size_t _opt_graph_size = 0; // bytes
 
     T *_data = nullptr; // coordinates of all base points
     // Dimensions
@@ -395,12 +456,21 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
 
     bool _filtered_index = false;
     std::vector<std::vector<LabelT>> _pts_to_labels;
+    std::vector<uint64_t, HugePageAllocator<uint64_t>> _pts_to_label_signature; // see label_signature.h
     tsl::robin_set<LabelT> _labels;
     std::vector<uint32_t> _labels_pts_count;
     std::unordered_map<LabelT, std::vector<uint32_t>> _label_to_pts;
     std::string _labels_file;
     std::unordered_map<LabelT, std::vector<uint32_t>> _label_to_medoid_id;
     std::unordered_map<uint32_t, uint32_t> _medoid_counts;
+    // Contiguous copy of per-label medoid vectors (aligned_dim stride).
+    // _label_to_entry_point_range maps a label to (offset, count) into
+    // _filter_entry_point_ids and _filter_entry_point_data.
+    T *_filter_entry_point_data = nullptr;
+    std::vector<uint32_t> _filter_entry_point_ids;
+    std::unordered_map<LabelT, std::pair<uint32_t, uint32_t>> _label_to_entry_point_range;
+    uint32_t _num_filter_entry_points = defaults::NUM_FILTER_ENTRY_POINTS;
+    uint32_t _prefetch_distance = defaults::PREFETCH_DISTANCE;
     bool _use_universal_label = false;
     LabelT _universal_label = 0;
     uint32_t _filterIndexingQueueSize;
@@ -424,6 +494,14 @@ template <typename T, typename TagT = uint32_t, typename LabelT = uint32_t> clas
     bool _pq_generated = false;
     FixedChunkPQTable _pq_table;
 
+    // Flags for PQ based distance search of a loaded index
+    bool _pq_search = false;
+    bool _pq_fast_scan = false; // 4-bit codes in _pq_data, packed two per byte
+    bool _mmap_full_vectors = false;
+    bool _rerank_full_precision = false;
+    std::unique_ptr<MemoryMapper> _full_vectors_mapper;
+    const T *_full_vectors = nullptr;
+
     //
     // Data structures, locks and flags for dynamic indexing and tags
     //
@@ -1,11 +1,14 @@
 #include "common_includes.h"
+#include "huge_pages.h"
 #include "parameters.h"
 
 namespace diskann
 {
 enum class DataStoreStrategy
 {
-    MEMORY
+    MEMORY,
+    MEMORY_SQ8, // in-memory, 8-bit per-dimension scalar quantized (float data only)
+    MEMORY_SQ4  // in-memory, 4-bit per-dimension scalar quantized (float data only)
 };
 
 enum class GraphStoreStrategy
@@ -27,10 +30,15 @@ struct IndexConfig
     bool pq_dist_build;
     bool concurrent_consolidate;
     bool use_opq;
+    bool pq_dist_search;
+    bool pq_fast_scan;
+    bool mmap_full_vectors;
 
     size_t num_pq_chunks;
     size_t num_frozen_pts;
 
+    HugePagePolicy huge_pages;
+
     std::string label_type;
     std::string tag_type;
     std::string data_type;
@@ -43,15 +51,16 @@ struct IndexConfig
   private:
     IndexConfig(DataStoreStrategy data_strategy, GraphStoreStrategy graph_strategy, Metric metric, size_t dimension,
                 size_t max_points, size_t num_pq_chunks, size_t num_frozen_points, bool dynamic_index, bool enable_tags,
-                bool pq_dist_build, bool concurrent_consolidate, bool use_opq, const std::string &data_type,
-                const std::string &tag_type, const std::string &label_type,
-                std::shared_ptr<IndexWriteParameters> index_write_params,
-                std::shared_ptr<IndexSearchParams> index_search_params)
+                bool pq_dist_build, bool concurrent_consolidate, bool use_opq, bool pq_dist_search,
+                bool pq_fast_scan, bool mmap_full_vectors, const std::string &data_type, const std::string &tag_type,
+                const std::string &label_type, std::shared_ptr<IndexWriteParameters> index_write_params,
+                std::shared_ptr<IndexSearchParams> index_search_params, HugePagePolicy huge_pages)
         : data_strategy(data_strategy), graph_strategy(graph_strategy), metric(metric), dimension(dimension),
           max_points(max_points), dynamic_index(dynamic_index), enable_tags(enable_tags), pq_dist_build(pq_dist_build),
-          concurrent_consolidate(concurrent_consolidate), use_opq(use_opq), num_pq_chunks(num_pq_chunks),
-          num_frozen_pts(num_frozen_points), label_type(label_type), tag_type(tag_type), data_type(data_type),
-          index_write_params(index_write_params), index_search_params(index_search_params)
+          concurrent_consolidate(concurrent_consolidate), use_opq(use_opq), pq_dist_search(pq_dist_search),
+          pq_fast_scan(pq_fast_scan), mmap_full_vectors(mmap_full_vectors), num_pq_chunks(num_pq_chunks),
+          num_frozen_pts(num_frozen_points), huge_pages(huge_pages), label_type(label_type), tag_type(tag_type),
+          data_type(data_type), index_write_params(index_write_params), index_search_params(index_search_params)
     {
     }
 
@@ -123,6 +132,35 @@ class IndexConfigBuilder
         return *this;
     }
 
+    // Search a loaded index over PQ codes (num_pq_chunks bytes per point) and
+    // re-rank the candidates with full precision vectors. load() reads the
+    // codes written by generate_pq_search_data (pq.h) and fails without them.
+    // The full precision vectors stay loaded alongside the codes, so this only
+    // saves memory together with is_mmap_full_vectors.
+    IndexConfigBuilder &is_pq_dist_search(bool pq_dist_search)
+    {
+        this->_pq_dist_search = pq_dist_search;
+        return *this;
+    }
+
+    // With PQ search, use 4-bit codes (16 centroids per chunk, two chunks per
+    // byte) and fast scan lookups. Pass twice the chunks of 8-bit PQ for the
+    // same code size.
+    IndexConfigBuilder &is_pq_fast_scan(bool pq_fast_scan)
+    {
+        this->_pq_fast_scan = pq_fast_scan;
+        return *this;
+    }
+
+    // With PQ search, memory map the full precision vectors for re-ranking
+    // instead of loading them into the data store. With a scalar quantized
+    // data store, memory map them to re-rank the quantized search results.
+    IndexConfigBuilder &is_mmap_full_vectors(bool mmap_full_vectors)
+    {
+        this->_mmap_full_vectors = mmap_full_vectors;
+        return *this;
+    }
+
     IndexConfigBuilder &with_num_pq_chunks(size_t num_pq_chunks)
     {
         this->_num_pq_chunks = num_pq_chunks;
@@ -135,6 +173,14 @@ class IndexConfigBuilder
         return *this;
     }
 
+    // Back the vectors, the optimized layout and the label signatures of the
+    // index with huge pages, see huge_pages.h.
+    IndexConfigBuilder &with_huge_pages(HugePagePolicy huge_pages)
+    {
+        this->_huge_pages = huge_pages;
+        return *this;
+    }
+
     IndexConfigBuilder &with_label_type(const std::string &label_type)
     {
         this->_label_type = label_type;
@@ -210,9 +256,21 @@ class IndexConfigBuilder
             _num_frozen_pts = 1;
         }
 
+        if (_mmap_full_vectors && !_pq_dist_search && _data_strategy == DataStoreStrategy::MEMORY)
+            throw ANNException("Error: memory mapped full vectors require PQ distance search or a scalar "
+                               "quantized data store.",
+                               -1);
+
+        if (_pq_dist_search && _num_pq_chunks == 0)
+            throw ANNException("Error: please pass num_pq_chunks for PQ distance search.", -1);
+
+        if (_pq_fast_scan && !_pq_dist_search)
+            throw ANNException("Error: fast scan requires PQ distance search.", -1);
+
         return IndexConfig(_data_strategy, _graph_strategy, _metric, _dimension, _max_points, _num_pq_chunks,
                            _num_frozen_pts, _dynamic_index, _enable_tags, _pq_dist_build, _concurrent_consolidate,
-                           _use_opq, _data_type, _tag_type, _label_type, _index_write_params, _index_search_params);
+                           _use_opq, _pq_dist_search, _pq_fast_scan, _mmap_full_vectors, _data_type, _tag_type, _label_type,
+                           _index_write_params, _index_search_params, _huge_pages);
     }
 
     IndexConfigBuilder(const IndexConfigBuilder &) = delete;
@@ -231,10 +289,15 @@ class IndexConfigBuilder
     bool _pq_dist_build = false;
     bool _concurrent_consolidate = false;
     bool _use_opq = false;
+    bool _pq_dist_search = false;
+    bool _pq_fast_scan = false;
+    bool _mmap_full_vectors = false;
 
     size_t _num_pq_chunks = 0;
     size_t _num_frozen_pts = 0;
 
+    HugePagePolicy _huge_pages = HugePagePolicy::None;
+
     std::string _label_type = "uint32";
     std::string _tag_type = "uint32";
     std::string _data_type;
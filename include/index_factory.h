@@ -1,6 +1,7 @@
 #include "index.h"
 #include "abstract_graph_store.h"
 #include "in_mem_graph_store.h"
+#include "in_mem_sq_data_store.h"
 
 namespace diskann
 {
@@ -12,10 +13,9 @@ class IndexFactory
 
     // Consruct a data store with distance function emplaced within
     template <typename T>
-    DISKANN_DLLEXPORT static std::unique_ptr<AbstractDataStore<T>> construct_datastore(const DataStoreStrategy stratagy,
-                                                                                       const size_t num_points,
-                                                                                       const size_t dimension,
-                                                                                       const Metric m);
+    DISKANN_DLLEXPORT static std::unique_ptr<AbstractDataStore<T>> construct_datastore(
+        const DataStoreStrategy stratagy, const size_t num_points, const size_t dimension, const Metric m,
+        const HugePagePolicy huge_pages = HugePagePolicy::None);
 
     DISKANN_DLLEXPORT static std::unique_ptr<AbstractGraphStore> construct_graphstore(
         const GraphStoreStrategy stratagy, const size_t size, const size_t reserve_graph_degree);
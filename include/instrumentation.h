@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "windows_customizations.h"
+
+#ifdef DISKANN_INSTRUMENT
+#ifdef _WINDOWS
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// Hot path counters and scoped cycle timers for the search, prune and build
+// loops. They are compiled in only with DISKANN_INSTRUMENT defined (cmake
+// -DDISKANN_INSTRUMENT=ON); otherwise every macro below expands to nothing.
+//
+//   DISKANN_PROBE_SCOPE(OccludeList);     // time the enclosing scope
+//   DISKANN_PROBE_COUNT(DistanceCmps, n); // add n to a counter
+//   DISKANN_INSTRUMENT_RESET();           // drop what was recorded so far
+//   DISKANN_INSTRUMENT_REPORT(path);      // write the totals as JSON
+//
+// Each thread records into its own block, so probes never share a cache line
+// across threads. Reset and report must not run concurrently with probes.
+// Scopes nest: inter_insert includes the occlude_list calls of its prunes.
+namespace diskann
+{
+namespace instrumentation
+{
+enum class Probe : uint32_t
+{
+    IterateToFixedPoint,
+    IterateToFixedPointV2,
+    OccludeList,
+    InterInsert,
+    StitchLabelGraph,
+    NumProbes
+};
+
+enum class Counter : uint32_t
+{
+    Hops,
+    DistanceCmps,
+    FilterChecks,
+    FilterRejects,
+    OccludeCandidates,
+    ReverseEdges,
+    StitchedEdges,
+    NumCounters
+};
+
+constexpr size_t NUM_PROBES = (size_t)Probe::NumProbes;
+constexpr size_t NUM_COUNTERS = (size_t)Counter::NumCounters;
+
+#ifdef DISKANN_INSTRUMENT
+// padded to whole cache lines so that neighbouring blocks do not false share
+struct alignas(64) ThreadProbes
+{
+    uint64_t calls[NUM_PROBES] = {};
+    uint64_t cycles[NUM_PROBES] = {};
+    uint64_t counts[NUM_COUNTERS] = {};
+};
+
+// Allocates the block of the calling thread. Blocks outlive their threads so
+// that the report still sees the work of finished threads.
+DISKANN_DLLEXPORT ThreadProbes *register_thread();
+DISKANN_DLLEXPORT void reset();
+DISKANN_DLLEXPORT void write_report(const std::string &report_file);
+
+inline ThreadProbes &thread_probes()
+{
+    static thread_local ThreadProbes *probes = register_thread();
+    return *probes;
+}
+
+class ScopedProbe
+{
+  public:
+    explicit ScopedProbe(Probe probe) : _probe((size_t)probe), _start(__rdtsc())
+    {
+    }
+
+    ~ScopedProbe()
+    {
+        ThreadProbes &probes = thread_probes();
+        probes.calls[_probe]++;
+        probes.cycles[_probe] += __rdtsc() - _start;
+    }
+
+    ScopedProbe(const ScopedProbe &) = delete;
+    ScopedProbe &operator=(const ScopedProbe &) = delete;
+
+  private:
+    const size_t _probe;
+    const uint64_t _start;
+};
+#endif
+} // namespace instrumentation
+} // namespace diskann
+
+#ifdef DISKANN_INSTRUMENT
+#define DISKANN_PROBE_CONCAT_(a, b) a##b
+#define DISKANN_PROBE_CONCAT(a, b) DISKANN_PROBE_CONCAT_(a, b)
+#define DISKANN_PROBE_SCOPE(probe)                                                                                     \
+    diskann::instrumentation::ScopedProbe DISKANN_PROBE_CONCAT(_diskann_probe_, __LINE__)(                            \
+        diskann::instrumentation::Probe::probe)
+#define DISKANN_PROBE_COUNT(counter, n)                                                                                \
+    (diskann::instrumentation::thread_probes().counts[(size_t)diskann::instrumentation::Counter::counter] +=          \
+     (uint64_t)(n))
+#define DISKANN_INSTRUMENT_RESET() diskann::instrumentation::reset()
+#define DISKANN_INSTRUMENT_REPORT(report_file) diskann::instrumentation::write_report(report_file)
+#else
+#define DISKANN_PROBE_SCOPE(probe)
+#define DISKANN_PROBE_COUNT(counter, n) ((void)0)
+#define DISKANN_INSTRUMENT_RESET() ((void)0)
+#define DISKANN_INSTRUMENT_REPORT(report_file) ((void)0)
+#endif
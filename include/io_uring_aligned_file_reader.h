@@ -0,0 +1,77 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#if !defined(_WINDOWS) && defined(USE_IO_URING)
+
+#include <liburing.h>
+
+#include "aligned_file_reader.h"
+#include "tsl/robin_map.h"
+
+// AlignedFileReader backed by io_uring. Every registered thread owns a ring
+// whose address is handed out as the thread's IOContext, so callers keep
+// using the libaio style get_ctx()/read() interface unchanged.
+//
+// The index file is registered with each ring, and a buffer passed to
+// register_buffer() is registered as a fixed buffer so reads into it skip
+// per-request page pinning. With sqpoll, a kernel thread polls the
+// submission queue and read() only has to wait for completions.
+class IoUringAlignedFileReader : public AlignedFileReader
+{
+  private:
+    struct ThreadRing
+    {
+        struct io_uring ring;
+        bool file_registered = false;
+        char *fixed_buf = nullptr;
+        uint64_t fixed_len = 0;
+        // length of every read in flight, by its buf
+        tsl::robin_map<void *, uint64_t> pending_len;
+    };
+
+    FileHandle file_desc;
+    io_context_t bad_ctx = (io_context_t)-1;
+    uint32_t queue_depth;
+    bool sqpoll;
+
+    static ThreadRing *to_ring(io_context_t ctx);
+    void register_file(ThreadRing *thread_ring);
+    // fills sqe to read req, with the buf as its completion data
+    void prep_read(ThreadRing *thread_ring, struct io_uring_sqe *sqe, const AlignedRead &req);
+    // checks that the read of cqe succeeded with its full length, marks cqe
+    // seen and returns its buf
+    void *complete_read(ThreadRing *thread_ring, struct io_uring_cqe *cqe);
+
+  public:
+    IoUringAlignedFileReader(const bool sqpoll = false, const uint32_t queue_depth = MAX_IO_DEPTH);
+    ~IoUringAlignedFileReader();
+
+    IOContext &get_ctx();
+
+    // register thread-id for a context
+    void register_thread();
+
+    // de-register thread-id for a context
+    void deregister_thread();
+    void deregister_all_threads();
+
+    // register buf as the calling thread's fixed buffer
+    void register_buffer(void *buf, uint64_t len);
+
+    // Open & close ops
+    // Blocking calls
+    void open(const std::string &fname);
+    void close();
+
+    // process batch of aligned requests in parallel
+    // NOTE :: blocking call
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // split-phase reads for pipelined search
+    bool supports_async() const;
+    void submit_reqs(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    void poll_reqs(IOContext &ctx, uint64_t min_done, std::vector<void *> &done_bufs);
+};
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#ifdef USE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace diskann
+{
+// Bloom style 64-bit label signatures. Every label sets two hashed bits of
+// its point's signature. A point can only carry a label if its signature
+// contains all bits of the label's mask, so a signature miss rules a point
+// out without touching its label list; hits must still be verified exactly.
+template <typename LabelT> inline uint64_t label_signature(const LabelT label)
+{
+    const uint64_t h = (uint64_t)label * 0x9E3779B97F4A7C15ULL;
+    return (1ULL << (h >> 58)) | (1ULL << ((h >> 52) & 63));
+}
+
+template <typename LabelT> inline uint64_t label_signature(const std::vector<LabelT> &labels)
+{
+    uint64_t signature = 0;
+    for (const auto &label : labels)
+        signature |= label_signature(label);
+    return signature;
+}
+
+// Query side of a filtered search, prepared once per query: one mask per
+// label that lets a point pass the filter. A zero mask passes every point.
+struct LabelSignaturePredicate
+{
+    std::vector<uint64_t> masks;
+
+    template <typename LabelT> void add_labels(const std::vector<LabelT> &labels)
+    {
+        for (const auto &label : labels)
+            masks.push_back(label_signature(label));
+    }
+
+    void add_all()
+    {
+        masks.push_back(0);
+    }
+};
+
+// Predicate of a filtered search, mirroring Index::detect_common_filters: a
+// point passes if it carries any of the filters or the universal label; at
+// build time (!search_invocation) a universal filter lets every point pass.
+template <typename LabelT>
+LabelSignaturePredicate make_label_predicate(const std::vector<LabelT> &filters, const bool search_invocation,
+                                             const bool use_universal_label, const LabelT universal_label)
+{
+    LabelSignaturePredicate predicate;
+    if (use_universal_label && !search_invocation &&
+        std::find(filters.begin(), filters.end(), universal_label) != filters.end())
+    {
+        predicate.add_all();
+        return predicate;
+    }
+    predicate.add_labels(filters);
+    if (use_universal_label)
+        predicate.masks.push_back(label_signature(universal_label));
+    return predicate;
+}
+
+// For each of the num_ids points, hits[i] is set to 1 if signatures[ids[i]]
+// contains all bits of at least one predicate mask and to 0 otherwise.
+inline void label_signature_hits(const uint64_t *signatures, const uint32_t *ids, const size_t num_ids,
+                                 const LabelSignaturePredicate &predicate, uint8_t *hits)
+{
+    const uint64_t *masks = predicate.masks.data();
+    const size_t num_masks = predicate.masks.size();
+    size_t i = 0;
+#ifdef USE_AVX2
+    // four signatures per gather, one compare per query label
+    for (; i + 4 <= num_ids; i += 4)
+    {
+        const __m128i idx = _mm_loadu_si128((const __m128i *)(ids + i));
+        const __m256i sigs = _mm256_i32gather_epi64((const long long *)signatures, idx, 8);
+        __m256i any = _mm256_setzero_si256();
+        for (size_t m = 0; m < num_masks; m++)
+        {
+            const __m256i mask = _mm256_set1_epi64x((long long)masks[m]);
+            any = _mm256_or_si256(any, _mm256_cmpeq_epi64(_mm256_and_si256(sigs, mask), mask));
+        }
+        const int bits = _mm256_movemask_pd(_mm256_castsi256_pd(any));
+        hits[i] = bits & 1;
+        hits[i + 1] = (bits >> 1) & 1;
+        hits[i + 2] = (bits >> 2) & 1;
+        hits[i + 3] = (bits >> 3) & 1;
+    }
+#endif
+    for (; i < num_ids; i++)
+    {
+        const uint64_t sig = signatures[ids[i]];
+        uint8_t hit = 0;
+        for (size_t m = 0; m < num_masks && !hit; m++)
+            hit = (sig & masks[m]) == masks[m];
+        hits[i] = hit;
+    }
+}
+
+} // namespace diskann
@@ -4,6 +4,8 @@
 #pragma once
 #ifndef _WINDOWS
 
+#include <memory>
+
 #include "aligned_file_reader.h"
 
 class LinuxAlignedFileReader : public AlignedFileReader
@@ -34,6 +36,17 @@ class LinuxAlignedFileReader : public AlignedFileReader
     // process batch of aligned requests in parallel
     // NOTE :: blocking call
     void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+
+    // split-phase reads for pipelined search
+    bool supports_async() const;
+    void submit_reqs(std::vector<AlignedRead> &read_reqs, IOContext &ctx);
+    void poll_reqs(IOContext &ctx, uint64_t min_done, std::vector<void *> &done_bufs);
 };
 
+// Creates the reader for the given I/O backend: "aio" (libaio), "io_uring" or
+// "io_uring_sqpoll". An empty backend reads DISKANN_IO_BACKEND from the
+// environment and defaults to "aio". The io_uring backends require a build
+// with DISKANN_USE_IO_URING.
+std::shared_ptr<AlignedFileReader> create_linux_aligned_file_reader(const std::string &backend = "");
+
 #endif
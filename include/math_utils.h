@@ -79,6 +79,16 @@ float lloyds_iter(float *data, size_t num_points, size_t dim, float *centers, si
 float run_lloyds(float *data, size_t num_points, size_t dim, float *centers, const size_t num_centers,
                  const size_t max_reps, std::vector<size_t> *closest_docs, uint32_t *closest_center);
 
+// Mini-batch k-means: runs max_iters updates of centers (initialized by the
+// caller) from batch_size points sampled from data each. warm_start says the
+// centers come from an earlier run (e.g. the previous OPQ round) and should
+// not be replaced by the first points they see. If closest_center is not
+// NULL, it returns the closest center of every point at the end. Returns the
+// residual of the last batch.
+float run_minibatch_kmeans(float *data, size_t num_points, size_t dim, float *centers, const size_t num_centers,
+                           const size_t batch_size, const size_t max_iters, const bool warm_start,
+                           uint32_t *closest_center);
+
 // assumes already memory allocated for pivot_data as new
 // float[num_centers*dim] and select randomly num_centers points as pivots
 void selecting_pivots(float *data, size_t num_points, size_t dim, float *pivot_data, size_t num_centers);
@@ -109,6 +109,12 @@ class NeighborPriorityQueue
         return _cur < _size;
     }
 
+    // Only valid if has_unexpanded_node().
+    const Neighbor &peek_closest_unexpanded() const
+    {
+        return _data[_cur];
+    }
+
     size_t size() const
     {
         return _size;
@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Where the memory of a loaded in-memory index goes on a multi-socket host.
+//  - None: first touch, i.e. mostly the node of the loading thread.
+//  - Interleave: pages spread round robin over all nodes, so that every
+//    search thread sees the same mix of local and remote accesses.
+//  - Replicate: one copy of the index per node, each searched only by the
+//    threads pinned to that node. Meant for read-only (e.g. stitched)
+//    indexes, and costs one index of memory per node.
+enum class NumaPlacement
+{
+    None,
+    Interleave,
+    Replicate
+};
+
+// Parses none, interleave or replicate.
+DISKANN_DLLEXPORT NumaPlacement get_numa_placement(const std::string &placement);
+
+// The CPUs the process may run on, in increasing order.
+DISKANN_DLLEXPORT std::vector<int> get_allowed_cpus();
+
+// The online NUMA nodes that have CPUs the process may run on, in
+// increasing order; {0} on hosts without NUMA support.
+DISKANN_DLLEXPORT std::vector<uint32_t> get_numa_nodes();
+
+// The CPUs of the node the process may run on.
+DISKANN_DLLEXPORT std::vector<int> get_numa_node_cpus(const uint32_t node);
+
+// Sets the memory policy of the calling thread, and of the threads of its
+// OpenMP team, for the lifetime of the object: interleaved over nodes, or
+// preferring nodes[0] otherwise. Allocations made in the scope, e.g. by
+// Index::load, are placed by it. Pages already touched do not move. Does
+// nothing (with a warning) where the policy cannot be set.
+class ScopedNumaMemoryPolicy
+{
+  public:
+    DISKANN_DLLEXPORT ScopedNumaMemoryPolicy(const std::vector<uint32_t> &nodes, const bool interleave);
+    DISKANN_DLLEXPORT ~ScopedNumaMemoryPolicy();
+
+    ScopedNumaMemoryPolicy(const ScopedNumaMemoryPolicy &) = delete;
+    ScopedNumaMemoryPolicy &operator=(const ScopedNumaMemoryPolicy &) = delete;
+
+  private:
+    bool _set = false;
+};
+} // namespace diskann
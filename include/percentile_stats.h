@@ -33,6 +33,17 @@ struct QueryStats
     unsigned n_cmps = 0;       // # cmps
     unsigned n_cache_hits = 0; // # cache_hits
     unsigned n_hops = 0;       // # search hops
+    unsigned io_limit = 0;     // I/O budget of the query
+    float mean_beam_width = 0; // beam width averaged over the hops
+
+    // in-memory filtered search
+    unsigned n_filter_checks = 0;  // # candidates checked against the filters
+    unsigned n_filter_rejects = 0; // # candidates that failed the filters
+    unsigned n_init_ids = 0;       // # start points seeded into the pool
+    bool brute_force = false;      // answered by scanning the rarest label
+    float filter_us = 0;           // time spent matching labels
+    float dist_us = 0;             // time spent computing distances
+    float queue_us = 0;            // time spent inserting into the pools
 };
 
 template <typename T>
@@ -7,6 +7,10 @@
 
 #define NUM_PQ_BITS 8
 #define NUM_PQ_CENTROIDS (1 << NUM_PQ_BITS)
+// centroids per chunk of 4-bit PQ and points per code block of its fast
+// scan layout, see pq_fast_scan.h
+#define NUM_PQ4_CENTROIDS 16
+#define FAST_SCAN_BLOCK_SIZE 32
 #define MAX_OPQ_ITERS 20
 #define NUM_KMEANS_REPS_PQ 12
 #define MAX_PQ_TRAINING_SET_SIZE 256000
@@ -14,11 +18,15 @@
 
 namespace diskann
 {
+// Pivots of 8-bit (256 centroids per chunk) or 4-bit (16 centroids per
+// chunk) PQ. The chunk distance tables it populates hold num_centers
+// entries per chunk.
 class FixedChunkPQTable
 {
-    float *tables = nullptr; // pq_tables = float array of size [256 * ndims]
+    float *tables = nullptr; // pq_tables = float array of size [num_centers * ndims]
     uint64_t ndims = 0;      // ndims = true dimension of vectors
     uint64_t n_chunks = 0;
+    uint32_t num_centers = NUM_PQ_CENTROIDS;
     bool use_rotation = false;
     uint32_t *chunk_offsets = nullptr;
     float *centroid = nullptr;
@@ -38,6 +46,8 @@ class FixedChunkPQTable
 
     uint32_t get_num_chunks();
 
+    uint32_t get_num_centers();
+
     void preprocess_query(float *query_vec);
 
     // assumes pre-processed query
@@ -58,13 +68,18 @@ template <typename T> struct PQScratch
     float *aligned_pqtable_dist_scratch = nullptr; // MUST BE AT LEAST [256 * NCHUNKS]
     float *aligned_dist_scratch = nullptr;         // MUST BE AT LEAST diskann MAX_DEGREE
     uint8_t *aligned_pq_coord_scratch = nullptr;   // MUST BE AT LEAST  [N_CHUNKS * MAX_DEGREE]
+    uint8_t *aligned_fast_scan_lut = nullptr;      // [16 * NCHUNKS] quantized 4-bit PQ table
     float *rotated_query = nullptr;
     float *aligned_query_float = nullptr;
 
     PQScratch(size_t graph_degree, size_t aligned_dim)
     {
+        // also holds the blocked 4-bit codes of up to graph_degree points
         diskann::alloc_aligned((void **)&aligned_pq_coord_scratch,
-                               (size_t)graph_degree * (size_t)MAX_PQ_CHUNKS * sizeof(uint8_t), 256);
+                               ROUND_UP(graph_degree, FAST_SCAN_BLOCK_SIZE) * (size_t)MAX_PQ_CHUNKS * sizeof(uint8_t),
+                               256);
+        diskann::alloc_aligned((void **)&aligned_fast_scan_lut,
+                               (size_t)NUM_PQ4_CENTROIDS * (size_t)MAX_PQ_CHUNKS * sizeof(uint8_t), 256);
         diskann::alloc_aligned((void **)&aligned_pqtable_dist_scratch, 256 * (size_t)MAX_PQ_CHUNKS * sizeof(float),
                                256);
         diskann::alloc_aligned((void **)&aligned_dist_scratch, (size_t)graph_degree * sizeof(float), 256);
@@ -99,13 +114,17 @@ void aggregate_coords(const unsigned *ids, const uint64_t n_ids, const uint8_t *
 void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_nchunks, const float *pq_dists,
                     float *dists_out);
 
+// Chunks are trained in parallel. With kmeans_batch_size > 0 (and below
+// num_train) every chunk runs mini-batch k-means on batches of that many
+// points instead of Lloyds on the whole training set.
 DISKANN_DLLEXPORT int generate_pq_pivots(const float *const train_data, size_t num_train, unsigned dim,
                                          unsigned num_centers, unsigned num_pq_chunks, unsigned max_k_means_reps,
-                                         std::string pq_pivots_path, bool make_zero_mean = false);
+                                         std::string pq_pivots_path, bool make_zero_mean = false,
+                                         size_t kmeans_batch_size = 0);
 
 DISKANN_DLLEXPORT int generate_opq_pivots(const float *train_data, size_t num_train, unsigned dim, unsigned num_centers,
                                           unsigned num_pq_chunks, std::string opq_pivots_path,
-                                          bool make_zero_mean = false);
+                                          bool make_zero_mean = false, size_t kmeans_batch_size = 0);
 
 template <typename T>
 int generate_pq_data_from_pivots(const std::string &data_file, unsigned num_centers, unsigned num_pq_chunks,
@@ -121,5 +140,20 @@ template <typename T>
 void generate_quantized_data(const std::string &data_file_to_use, const std::string &pq_pivots_path,
                              const std::string &pq_compressed_vectors_path, const diskann::Metric compareMetric,
                              const double p_val, const uint64_t num_pq_chunks, const bool use_opq,
-                             const std::string &codebook_prefix = "");
+                             const std::string &codebook_prefix = "",
+                             const uint32_t num_centers = NUM_PQ_CENTROIDS);
+
+// Prefix of the <prefix>_pivots.bin and <prefix>_compressed.bin files an
+// in-memory index at index_file reads for PQ distance search:
+// index_file + "_pq<chunks>", "_opq<chunks>" or, for 4-bit fast scan codes,
+// "_pq4b<chunks>".
+DISKANN_DLLEXPORT std::string get_pq_search_prefix(const std::string &index_file, const uint64_t num_pq_chunks,
+                                                   const bool use_opq, const bool fast_scan);
+
+// Trains PQ on a sample of <index_file>.data and writes the files named by
+// get_pq_search_prefix. Loading an index with PQ distance search needs them.
+template <typename T>
+DISKANN_DLLEXPORT void generate_pq_search_data(const std::string &index_file, const diskann::Metric metric,
+                                               const uint64_t num_pq_chunks, const bool use_opq,
+                                               const bool fast_scan);
 } // namespace diskann
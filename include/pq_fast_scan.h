@@ -0,0 +1,67 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include "pq.h"
+
+// Fast scan distance lookups for 4-bit PQ (16 centroids per chunk).
+//
+// A point's 4-bit codes are stored packed, two chunks per byte (chunk 2p in
+// the low nibble of byte p). To compute distances, the codes of a neighbor
+// list are regrouped into blocks of FAST_SCAN_BLOCK_SIZE points. Within a
+// block, the 32 bytes for chunk pair p hold chunk 2p in bytes 0-15 and
+// chunk 2p+1 in bytes 16-31. Byte j of each half keeps point j in its low
+// nibble and point j+16 in its high nibble.
+//
+// The query's chunk distance table is quantized to bytes, so the 16 entries
+// of a chunk fit in one 128-bit register. With AVX2 a single pshufb then
+// looks up one chunk pair for 32 points. Distances are accumulated in
+// 16-bit integers, widened to 32 bits every FAST_SCAN_FLUSH_BYTES code bytes
+// so that any number of chunks is exact, and converted back to floats once
+// per block.
+namespace diskann
+{
+// code bytes (chunk pairs) summed in 16 bits before widening: the even and
+// odd lanes of 128 bytes add up to at most 2 * 128 * 255 < 65536
+constexpr size_t FAST_SCAN_FLUSH_BYTES = 128;
+
+// bytes per point of packed 4-bit codes
+inline size_t pq4_code_bytes(const size_t n_chunks)
+{
+    return DIV_ROUND_UP(n_chunks, 2);
+}
+
+// bytes of the blocked codes of n_pts points
+inline size_t fast_scan_codes_bytes(const size_t n_pts, const size_t n_chunks)
+{
+    return ROUND_UP(n_pts, FAST_SCAN_BLOCK_SIZE) * pq4_code_bytes(n_chunks);
+}
+
+// Packs 4-bit codes stored one per byte (as written by
+// generate_pq_data_from_pivots with 16 centers) to pq4_code_bytes per point.
+DISKANN_DLLEXPORT void pack_pq4_codes(const uint8_t *codes, const size_t n_pts, const size_t n_chunks,
+                                      uint8_t *packed);
+
+// Quantizes a chunk distance table of 16 floats per chunk to the byte table
+// lut of 16 * 2 * pq4_code_bytes(n_chunks) entries. The distance of a point
+// is then bias + scale * (sum of its lut entries).
+DISKANN_DLLEXPORT void quantize_fast_scan_lut(const float *chunk_dists, const size_t n_chunks, uint8_t *lut,
+                                              float &scale, float &bias);
+
+// Gathers the packed codes of ids into the blocked layout in out, which
+// must hold fast_scan_codes_bytes(n_ids, n_chunks) bytes.
+DISKANN_DLLEXPORT void aggregate_fast_scan_codes(const uint32_t *ids, const size_t n_ids, const uint8_t *packed_codes,
+                                                 const size_t n_chunks, uint8_t *out);
+
+// Distances of the n_pts points in blocked_codes from the query of lut.
+DISKANN_DLLEXPORT void fast_scan_dist_lookup(const uint8_t *blocked_codes, const size_t n_pts, const size_t n_chunks,
+                                             const uint8_t *lut, const float scale, const float bias,
+                                             float *dists_out);
+
+// The same without SIMD, used when AVX2 is not available and as the
+// reference of the SIMD path.
+DISKANN_DLLEXPORT void fast_scan_dist_lookup_scalar(const uint8_t *blocked_codes, const size_t n_pts,
+                                                    const size_t n_chunks, const uint8_t *lut, const float scale,
+                                                    const float bias, float *dists_out);
+} // namespace diskann
@@ -56,6 +56,15 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
                                                                    uint64_t beamwidth, uint64_t num_nodes_to_cache,
                                                                    uint32_t num_threads,
                                                                    std::vector<uint32_t> &node_list);
+
+    // Filter-aware cache planning: replays the sample queries, each with its
+    // own labels (sample_filters[i], empty for an unfiltered query), so the
+    // searches start at the per-label medoids the real workload uses. The
+    // most visited nodes are returned, as many as fit in cache_budget_bytes
+    // of _nhood_cache and _coord_cache memory; unvisited nodes are not cached.
+    DISKANN_DLLEXPORT void generate_cache_list_from_filtered_sample_queries(
+        const std::string &sample_bin, const std::vector<std::vector<std::string>> &sample_filters, uint64_t l_search,
+        uint64_t beamwidth, uint64_t cache_budget_bytes, uint32_t num_threads, std::vector<uint32_t> &node_list);
 #endif
 
     DISKANN_DLLEXPORT void cache_bfs_levels(uint64_t num_nodes_to_cache, std::vector<uint32_t> &node_list,
@@ -81,8 +90,32 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
                                               const uint32_t io_limit, const bool use_reorder_data = false,
                                               QueryStats *stats = nullptr);
 
+    // Conjunctive multi-label search: the beam traverses points carrying any
+    // of filter_labels and only points carrying all of them are returned. An
+    // empty filter_labels searches without a filter.
+    DISKANN_DLLEXPORT void cached_beam_search_multi_filters(
+        const T *query, const uint64_t k_search, const uint64_t l_search, uint64_t *res_ids, float *res_dists,
+        const uint64_t beam_width, const std::vector<LabelT> &filter_labels,
+        const uint32_t io_limit = std::numeric_limits<uint32_t>::max(), const bool use_reorder_data = false,
+        QueryStats *stats = nullptr);
+
     DISKANN_DLLEXPORT LabelT get_converted_label(const std::string &filter_label);
 
+    // Overlap I/O with compute in cached_beam_search: up to beam_width reads
+    // stay in flight and every node is expanded as soon as its read completes.
+    // Ignored if the reader has no split-phase reads (supports_async()).
+    DISKANN_DLLEXPORT void set_pipelined_search(const bool pipelined);
+
+    // Online search control. With adaptive_beam_width the beam_width passed
+    // to cached_beam_search is the widest beam: it is halved after every hop
+    // in which the k_search best candidates were all expanded (down to a
+    // quarter) and doubled again when closer candidates show up. With a
+    // non-zero io_budget_factor each query may issue at most
+    // io_budget_factor * l_search reads, further capped by the number of
+    // points that carry one of its labels, and by the io_limit argument.
+    // Both show up per query in QueryStats.
+    DISKANN_DLLEXPORT void set_adaptive_search(const bool adaptive_beam_width, const float io_budget_factor = 0);
+
     DISKANN_DLLEXPORT uint32_t range_search(const T *query1, const double range, const uint64_t min_l_search,
                                             const uint64_t max_l_search, std::vector<uint64_t> &indices,
                                             std::vector<float> &distances, const uint64_t min_beam_width,
@@ -98,12 +131,15 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     // node_ids: input list of node_ids to be read
     // coord_buffers: pointers to pre-allocated buffers that coords need to copied to. If null, dont copy.
     // nbr_buffers: pre-allocated buffers to copy neighbors into
+    // label_buffers: if labels are stored in the sectors, optional buffers of 1 + max labels per node to copy
+    //                the label count and labels into. If null, dont copy.
     //
     // returns a vector of bool one for each node_id: true if read is success, else false
     //
     DISKANN_DLLEXPORT std::vector<bool> read_nodes(const std::vector<uint32_t> &node_ids,
                                                    std::vector<T *> &coord_buffers,
-                                                   std::vector<std::pair<uint32_t, uint32_t *>> &nbr_buffers);
+                                                   std::vector<std::pair<uint32_t, uint32_t *>> &nbr_buffers,
+                                                   std::vector<uint32_t *> *label_buffers = nullptr);
 
     DISKANN_DLLEXPORT std::vector<std::uint8_t> get_pq_vector(std::uint64_t vid);
     DISKANN_DLLEXPORT uint64_t get_num_points();
@@ -115,9 +151,25 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     DISKANN_DLLEXPORT void set_universal_label(const LabelT &label);
 
   private:
-    DISKANN_DLLEXPORT inline bool point_has_label(uint32_t point_id, LabelT label_id);
+    // Number of (sorted) filter_labels the point carries; all of them if it
+    // carries the universal label.
+    DISKANN_DLLEXPORT inline uint32_t common_filter_size(uint32_t point_id, const std::vector<LabelT> &filter_labels);
+    // Same count for labels stored in a sector, from the label block of the
+    // node (label count followed by the labels), or from _spilled_labels if
+    // the node has more labels than the block has slots.
+    DISKANN_DLLEXPORT inline uint32_t sector_filter_size(uint32_t point_id, const uint32_t *label_block,
+                                                         const std::vector<LabelT> &filter_labels);
+    // Upper bound of common_filter_size from the point's label signature, for
+    // indices whose labels are stored in the sectors. label_masks holds the
+    // signature of every filter label.
+    DISKANN_DLLEXPORT inline uint32_t candidate_filter_size(uint32_t point_id, const std::vector<LabelT> &filter_labels,
+                                                            const std::vector<uint64_t> &label_masks);
     std::unordered_map<std::string, LabelT> load_label_map(const std::string &map_file);
     DISKANN_DLLEXPORT void parse_label_file(const std::string &map_file, size_t &num_pts_labels);
+    // Reads only the label signature and per-label point counts of every
+    // point, used when the labels themselves are stored in the sectors. The
+    // labels of points with more than _max_node_labels go to _spilled_labels.
+    DISKANN_DLLEXPORT void parse_label_signatures(const std::string &label_file, size_t &num_pts_labels);
     DISKANN_DLLEXPORT void get_label_file_metadata(std::string map_file, uint32_t &num_pts, uint32_t &num_total_labels);
     DISKANN_DLLEXPORT void generate_random_labels(std::vector<LabelT> &labels, const uint32_t num_labels,
                                                   const uint32_t nthreads);
@@ -134,6 +186,10 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     // returns region of `node_buf` containing [COORD(T)]
     DISKANN_DLLEXPORT T *offset_to_node_coords(char *node_buf);
 
+    // returns region of `node_buf` containing [NLABELS][LABEL(uint32_t)], only
+    // present if _max_node_labels > 0
+    DISKANN_DLLEXPORT uint32_t *offset_to_node_labels(char *node_buf);
+
     // index info for multi-node sectors
     // nhood of node `i` is in sector: [i / nnodes_per_sector]
     // offset in sector: [(i % nnodes_per_sector) * max_node_len]
@@ -146,10 +202,14 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     // coords start at ofsset
     // #nbrs of node `i`: *(unsigned*) (offset + disk_bytes_per_point)
     // nbrs of node `i` : (unsigned*) (offset + disk_bytes_per_point + 1)
+    // #labels of node `i`: *(unsigned*) (offset + disk_bytes_per_point + 1 + max_degree), if labels are stored
+    // labels of node `i` : (unsigned*) (offset + disk_bytes_per_point + 2 + max_degree), if #labels fit in the
+    //                      max_node_labels slots
 
     uint64_t _max_node_len = 0;
     uint64_t _nnodes_per_sector = 0; // 0 for multi-sector nodes, >0 for multi-node sectors
     uint64_t _max_degree = 0;
+    uint64_t _max_node_labels = 0; // label slots per node in the sectors, 0 if labels are kept in memory
 
     // Data used for searching with re-order vectors
     uint64_t _ndims_reorder_vecs = 0;
@@ -178,8 +238,9 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     // data: char * _n_chunks
     // chunk_size = chunk size of each dimension chunk
     // pq_tables = float* [[2^8 * [chunk_size]] * _n_chunks]
-    uint8_t *data = nullptr;
+    uint8_t *data = nullptr; // packed two per byte if _pq_fast_scan
     uint64_t _n_chunks;
+    bool _pq_fast_scan = false; // 4-bit PQ codes, looked up with fast scan
     FixedChunkPQTable _pq_table;
 
     // distance comparator
@@ -211,19 +272,29 @@ template <typename T, typename LabelT = uint32_t> class PQFlashIndex
     T *_coord_cache_buf = nullptr;
     tsl::robin_map<uint32_t, T *> _coord_cache;
 
+    // label_cache; label blocks of cached nodes if labels are stored in the sectors
+    uint32_t *_label_cache_buf = nullptr;
+    tsl::robin_map<uint32_t, uint32_t *> _label_cache;
+
     // thread-specific scratch
     ConcurrentQueue<SSDThreadData<T> *> _thread_data;
     uint64_t _max_nthreads;
     bool _load_flag = false;
     bool _count_visited_nodes = false;
     bool _reorder_data_exists = false;
+    bool _pipelined_search = false;
+    bool _adaptive_beam_width = false;
+    float _io_budget_factor = 0;
     uint64_t _reoreder_data_offset = 0;
 
     // filter support
     uint32_t *_pts_to_label_offsets = nullptr;
     uint32_t *_pts_to_label_counts = nullptr;
     LabelT *_pts_to_labels = nullptr;
+    uint64_t *_pts_to_label_signature = nullptr; // replaces the label lists above if labels are in the sectors
+    tsl::robin_map<uint32_t, std::vector<LabelT>> _spilled_labels; // labels of points that overflow their sector
     std::unordered_map<LabelT, std::vector<uint32_t>> _filter_to_medoid_ids;
+    std::unordered_map<LabelT, uint32_t> _label_num_pts; // used to seed multi-label search from the rarest label
     bool _use_universal_label = false;
     LabelT _universal_filter_label;
     tsl::robin_set<uint32_t> _dummy_pts;
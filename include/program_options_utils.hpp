@@ -77,5 +77,24 @@ const char *UNIVERSAL_LABEL =
     "in the labels file instead of listing all labels for a node.  DiskANN will not automatically assign a "
     "universal label to a node.";
 const char *FILTERED_LBUILD = "Build complexity for filtered points, higher value results in better graphs";
+const char *SEARCH_SCHEDULER_DESCRIPTION =
+    "How queries are spread over the search threads: pool for a persistent pinned thread pool that steals "
+    "chunks of queries, omp for an OpenMP loop with dynamic scheduling. Default omp.";
+const char *SEARCH_CHUNK_SIZE_DESCRIPTION = "Queries a pool thread claims at a time. Default 8.";
+const char *NUMA_PLACEMENT_DESCRIPTION =
+    "Placement of the index on multi-socket hosts: none for first touch, interleave to spread its pages over all "
+    "NUMA nodes, replicate for one copy per node searched by the pool threads of that node. Default none.";
+const char *HUGE_PAGES_DESCRIPTION =
+    "Back the vectors, optimized layout and label signatures of the index with huge pages: none, thp for "
+    "transparent huge pages, 2mb or 1gb for hugetlbfs pages, falling back to thp. Compare with --hw_counters "
+    "dtlb_load_misses. Default none.";
+const char *PROFILE_DESCRIPTION =
+    "Output prefix that turns on profiling of the timed search loop only, one CPU profile "
+    "<prefix>_L<L>.prof per search list size. CPU profiles need a build with -DDISKANN_PROFILER=ON, "
+    "without it --profile collects the hardware counters of --hw_counters instead";
+const char *HEAP_PROFILE_DESCRIPTION = "With --profile, also write a gperftools heap profile per search list size";
+const char *HW_COUNTERS_DESCRIPTION =
+    "With --profile, count cycles, instructions, cache, branch and dTLB misses of the search threads "
+    "with perf_event_open and append them to <prefix>_hw_counters.csv";
 
 } // namespace program_options_utils
@@ -12,7 +12,15 @@ namespace diskann
 static const std::string VECTOR_KEY = "query", K_KEY = "k", INDICES_KEY = "indices", DISTANCES_KEY = "distances",
                          TAGS_KEY = "tags", QUERY_ID_KEY = "query_id", ERROR_MESSAGE_KEY = "error", L_KEY = "Ls",
                          TIME_TAKEN_KEY = "time_taken_in_us", PARTITION_KEY = "partition",
-                         UNKNOWN_ERROR = "unknown_error";
+                         UNKNOWN_ERROR = "unknown_error", LABELS_KEY = "labels", VECTOR_BASE64_KEY = "query_base64";
+
+// POSTs to this path below the server address run filtered searches.
+static const std::string FILTERED_SEARCH_PATH = "filtered";
+
+// A request body of this content type is the raw query vector; the other
+// fields are passed in the URI query string, with labels comma separated.
+static const std::string RAW_VECTOR_CONTENT_TYPE = "application/octet-stream";
+
 const unsigned int DEFAULT_L = 100;
 
 } // namespace diskann
\ No newline at end of file
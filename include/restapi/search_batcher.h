@@ -0,0 +1,58 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pplx/pplxtasks.h>
+#include <restapi/search_wrapper.h>
+
+namespace diskann
+{
+// Coalesces searches submitted concurrently by the HTTP listener into
+// batches that run on a dedicated OpenMP team of num_threads threads, so
+// that the listener threads only parse requests and the index sees a
+// steady number of searching threads. A batch is dispatched once
+// max_batch_size searches are queued, or max_wait_us after the oldest of
+// them arrived.
+class SearchBatcher
+{
+  public:
+    // runs one request against every searcher of the server
+    typedef std::function<std::vector<SearchResult>()> SearchFunction;
+
+    SearchBatcher(const uint32_t num_threads, const uint32_t max_batch_size, const uint32_t max_wait_us);
+    ~SearchBatcher();
+
+    // The task completes with the results of search, or its exception,
+    // once the batch it joined has run.
+    pplx::task<std::vector<SearchResult>> submit(SearchFunction search);
+
+  private:
+    struct PendingSearch
+    {
+        SearchFunction search;
+        pplx::task_completion_event<std::vector<SearchResult>> done;
+        std::chrono::steady_clock::time_point arrival;
+    };
+
+    void dispatch_loop();
+
+    const uint32_t _num_threads;
+    const uint32_t _max_batch_size;
+    const uint32_t _max_wait_us;
+
+    std::mutex _queue_mutex;
+    std::condition_variable _queue_cv;
+    std::deque<PendingSearch> _queue;
+    bool _stop = false;
+    std::thread _dispatcher;
+};
+} // namespace diskann
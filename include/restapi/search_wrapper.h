@@ -102,6 +102,27 @@ class BaseSearch
         throw SearchNotImplementedException("uint8_t");
     }
 
+    // Returns the nearest points that carry all of labels; the result may
+    // hold fewer than K points, and none if a label is not in the index.
+    virtual SearchResult search_with_filters(const float * /*query*/, const unsigned int /*dimensions*/,
+                                             const unsigned int /*K*/, const unsigned int /*Ls*/,
+                                             const std::vector<std::string> & /*labels*/)
+    {
+        throw SearchNotImplementedException("float");
+    }
+    virtual SearchResult search_with_filters(const int8_t * /*query*/, const unsigned int /*dimensions*/,
+                                             const unsigned int /*K*/, const unsigned int /*Ls*/,
+                                             const std::vector<std::string> & /*labels*/)
+    {
+        throw SearchNotImplementedException("int8_t");
+    }
+    virtual SearchResult search_with_filters(const uint8_t * /*query*/, const unsigned int /*dimensions*/,
+                                             const unsigned int /*K*/, const unsigned int /*Ls*/,
+                                             const std::vector<std::string> & /*labels*/)
+    {
+        throw SearchNotImplementedException("uint8_t");
+    }
+
     void lookup_tags(const unsigned K, const unsigned *indices, std::string *ret_tags);
 
   protected:
@@ -117,6 +138,8 @@ template <typename T> class InMemorySearch : public BaseSearch
     virtual ~InMemorySearch();
 
     SearchResult search(const T *query, const unsigned int dimensions, const unsigned int K, const unsigned int Ls);
+    SearchResult search_with_filters(const T *query, const unsigned int dimensions, const unsigned int K,
+                                     const unsigned int Ls, const std::vector<std::string> &labels);
 
   private:
     unsigned int _dimensions, _numPoints;
@@ -126,8 +149,10 @@ template <typename T> class InMemorySearch : public BaseSearch
 template <typename T> class PQFlashSearch : public BaseSearch
 {
   public:
+    // reader defaults to the platform's AlignedFileReader; pass one to share
+    // I/O with other indices, e.g. a ScheduledAlignedFileReader
     PQFlashSearch(const std::string &indexPrefix, const unsigned num_nodes_to_cache, const unsigned num_threads,
-                  const std::string &tagsFile, Metric m);
+                  const std::string &tagsFile, Metric m, std::shared_ptr<AlignedFileReader> shared_reader = nullptr);
     virtual ~PQFlashSearch();
 
     SearchResult search(const T *query, const unsigned int dimensions, const unsigned int K, const unsigned int Ls);
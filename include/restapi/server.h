@@ -3,16 +3,41 @@
 
 #pragma once
 
+#include <chrono>
+#include <memory>
+
 #include <restapi/common.h>
+#include <restapi/search_batcher.h>
 #include <cpprest/http_listener.h>
 
 namespace diskann
 {
+// A parsed search request. queryVector is aligned and zero padded to a
+// multiple of 8 dimensions.
+template <class T> struct SearchRequest
+{
+    int64_t queryId = -1;
+    unsigned int K = 0;
+    unsigned int Ls = DEFAULT_L;
+    unsigned int dimensions = 0;
+    T *queryVector = nullptr;
+    std::vector<std::string> labels;
+    std::chrono::high_resolution_clock::time_point startTime;
+
+    ~SearchRequest()
+    {
+        if (queryVector != nullptr)
+            diskann::aligned_free(queryVector);
+    }
+};
+
 class Server
 {
   public:
+    // Without a batcher, every request is searched on the listener thread
+    // that parsed it.
     Server(web::uri &url, std::vector<std::unique_ptr<diskann::BaseSearch>> &multi_searcher,
-           const std::string &typestring);
+           const std::string &typestring, std::unique_ptr<SearchBatcher> batcher = nullptr);
     virtual ~Server();
 
     pplx::task<void> open();
@@ -25,9 +50,16 @@ class Server
     web::json::value toJsonArray(const std::vector<T> &v, std::function<web::json::value(const T &)> valConverter);
     web::json::value prepareResponse(const int64_t &queryId, const int k);
 
+    template <class T> void parseJson(const utility::string_t &body, SearchRequest<T> &request);
+    template <class T>
+    void parseRaw(const web::uri &uri, const std::vector<unsigned char> &body, SearchRequest<T> &request);
+    template <class T> void allocQueryVector(const size_t dimensions, SearchRequest<T> &request);
+    template <class T>
+    void copyQueryVector(const std::vector<unsigned char> &bytes, SearchRequest<T> &request);
+
     template <class T>
-    void parseJson(const utility::string_t &body, unsigned int &k, int64_t &queryId, T *&queryVector,
-                   unsigned int &dimensions, unsigned &Ls);
+    pplx::task<std::vector<diskann::SearchResult>> runSearch(std::shared_ptr<SearchRequest<T>> request,
+                                                             const bool filtered);
 
     web::json::value idsToJsonArray(const diskann::SearchResult &result);
     web::json::value distancesToJsonArray(const diskann::SearchResult &result);
@@ -41,5 +73,6 @@ class Server
     std::unique_ptr<web::http::experimental::listener::http_listener> _listener;
     const bool _multi_search;
     std::vector<std::unique_ptr<diskann::BaseSearch>> _multi_searcher;
+    std::unique_ptr<SearchBatcher> _batcher;
 };
 } // namespace diskann
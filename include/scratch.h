@@ -53,6 +53,10 @@ template <typename T> class InMemQueryScratch
     {
         return _pq_scratch;
     }
+    inline T *rerank_vector()
+    {
+        return _rerank_vector;
+    }
     inline std::vector<Neighbor> &pool()
     {
         return _pool;
@@ -103,6 +107,10 @@ template <typename T> class InMemQueryScratch
 
     PQScratch<T> *_pq_scratch = nullptr;
 
+    // Aligned copy of a full precision vector read from a memory mapped data
+    // file while re-ranking PQ search results. Only allocated with PQ scratch.
+    T *_rerank_vector = nullptr;
+
     // _pool stores all neighbors explored from best_L_nodes.
     // Usually around L+R, but could be higher.
     // Initialized to 3L+R for some slack, expands as needed.
@@ -157,6 +165,8 @@ template <typename T> class SSDQueryScratch
     tsl::robin_set<size_t> visited;
     NeighborPriorityQueue retset;
     std::vector<Neighbor> full_retset;
+    // candidates carrying every query label, for multi-label searches
+    NeighborPriorityQueue match_all_retset;
 
     SSDQueryScratch(size_t aligned_dim, size_t visited_reserve);
     ~SSDQueryScratch();
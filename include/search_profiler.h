@@ -0,0 +1,59 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "search_thread_pool.h"
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// Profiles one timed search loop at a time, so that the profile of every
+// search list size leaves out the index load and the other settings.
+//
+// Between start(label) and stop() it can
+//  - run the gperftools CPU profiler, written to <prefix>_<label>.prof,
+//  - run the gperftools heap profiler, dumped to <prefix>_<label>.*.heap,
+//  - count cycles, instructions, cache, branch and dTLB misses of the
+//    search threads with perf_event_open, printed and appended to
+//    <prefix>_hw_counters.csv.
+// The gperftools profilers need a build with -DDISKANN_PROFILER=ON; in other
+// builds a CPU profile request collects the hardware counters instead. The
+// hardware counters need Linux and a permissive perf_event_paranoid.
+//
+// Hardware counters are opened by each thread of search_pool, or if there
+// is none, of an OpenMP team of num_threads threads, which the search loop
+// is expected to reuse.
+class SearchProfiler
+{
+  public:
+    DISKANN_DLLEXPORT SearchProfiler(const std::string &profile_prefix, const uint32_t num_threads,
+                                     const bool cpu_profile, const bool heap_profile, const bool hw_counters,
+                                     SearchThreadPool *search_pool = nullptr);
+    DISKANN_DLLEXPORT ~SearchProfiler();
+
+    DISKANN_DLLEXPORT void start(const std::string &label);
+    // num_queries scales the per query counts of the summary
+    DISKANN_DLLEXPORT void stop(const uint64_t num_queries);
+
+  private:
+    void open_hw_counters();
+    void close_hw_counters();
+
+    const std::string _profile_prefix;
+    const uint32_t _num_threads;
+    bool _cpu_profile;
+    bool _heap_profile;
+    bool _hw_counters;
+    SearchThreadPool *_search_pool;
+
+    std::string _label;
+    bool _running = false;
+    // one row of event file descriptors per thread, -1 where unavailable
+    std::vector<std::vector<int>> _hw_counter_fds;
+};
+} // namespace diskann
@@ -0,0 +1,44 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "neighbor.h"
+#include "tsl/robin_set.h"
+
+namespace diskann
+{
+// Appends to results, closest first, the candidates not already in results
+// until it holds k points. Used by filtered searches to fill up with
+// matching points that were seen but not expanded.
+inline void append_unexpanded_results(std::vector<Neighbor> &results, const NeighborPriorityQueue &candidates,
+                                      const size_t k)
+{
+    if (results.size() >= k)
+        return;
+    tsl::robin_set<uint32_t> in_results;
+    for (auto &nn : results)
+        in_results.insert(nn.id);
+    for (size_t i = 0; i < candidates.size() && results.size() < k; i++)
+    {
+        if (in_results.insert(candidates[i].id).second)
+            results.push_back(candidates[i]);
+    }
+}
+
+// Marks the result slots [num_found, k) of a search that found fewer than k
+// points with an invalid id and the largest distance. distances may be null.
+inline void pad_search_results(uint64_t *indices, float *distances, const size_t num_found, const size_t k)
+{
+    for (size_t i = num_found; i < k; i++)
+    {
+        indices[i] = std::numeric_limits<uint32_t>::max();
+        if (distances != nullptr)
+            distances[i] = std::numeric_limits<float>::max();
+    }
+}
+} // namespace diskann
@@ -0,0 +1,102 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "windows_customizations.h"
+
+namespace diskann
+{
+// A persistent team of search threads for running query batches without
+// re-entering an OpenMP parallel region for every batch.
+//
+// parallel_for hands every thread a contiguous slice of the batch, so that
+// a thread walks consecutive queries. It claims chunk_size queries at a
+// time from its own slice, then steals chunks from the other slices,
+// nearest first, so the batch stays balanced when some queries take much
+// longer than others. The calling thread only waits.
+//
+// With pin_threads, thread t is bound to the t-th CPU the process may run
+// on (Linux only). With numa_aware, the threads are instead split into
+// consecutive blocks, one per NUMA node, and each block is bound to the CPUs
+// of its node; thread_node() then tells a thread which node, e.g. which
+// index replica, is local to it.
+class SearchThreadPool
+{
+  public:
+    DISKANN_DLLEXPORT SearchThreadPool(const uint32_t num_threads, const bool pin_threads = true,
+                                       const bool numa_aware = false);
+    DISKANN_DLLEXPORT ~SearchThreadPool();
+
+    SearchThreadPool(const SearchThreadPool &) = delete;
+    SearchThreadPool &operator=(const SearchThreadPool &) = delete;
+
+    uint32_t num_threads() const
+    {
+        return (uint32_t)_threads.size();
+    }
+
+    // The NUMA nodes the threads run on, {0} unless numa_aware.
+    const std::vector<uint32_t> &nodes() const
+    {
+        return _nodes;
+    }
+
+    // Position in nodes() of the node of thread_id.
+    uint32_t thread_node(const uint32_t thread_id) const
+    {
+        return _thread_nodes[thread_id];
+    }
+
+    // Calls fn(i, thread_id) for every i in [0, n) and returns once all calls
+    // have. thread_id is in [0, num_threads()) and can index per-thread
+    // scratch. If fn throws, the remaining items are skipped and the first
+    // exception is rethrown here. Batches from several callers run one after
+    // the other.
+    DISKANN_DLLEXPORT void parallel_for(const size_t n, const size_t chunk_size,
+                                        const std::function<void(size_t, uint32_t)> &fn);
+
+    // Calls fn(thread_id) once on every thread of the pool, e.g. to set up
+    // per-thread state such as performance counters.
+    DISKANN_DLLEXPORT void run_on_each_thread(const std::function<void(uint32_t)> &fn);
+
+  private:
+    struct alignas(64) Slice
+    {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    void run(const std::function<void(uint32_t)> &body);
+    void worker_loop(const uint32_t thread_id);
+    void record_exception();
+
+    const bool _pin_threads;
+    std::vector<std::thread> _threads;
+    std::unique_ptr<Slice[]> _slices;
+    std::vector<uint32_t> _nodes;
+    std::vector<uint32_t> _thread_nodes;
+
+    std::mutex _run_mutex; // one batch at a time
+    std::mutex _mutex;
+    std::condition_variable _start_cv;
+    std::condition_variable _done_cv;
+    const std::function<void(uint32_t)> *_body = nullptr;
+    uint64_t _generation = 0;
+    uint32_t _running = 0;
+    bool _stop = false;
+
+    std::atomic<bool> _failed{false};
+    std::exception_ptr _exception;
+};
+} // namespace diskann
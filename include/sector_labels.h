@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace diskann
+{
+// Labels of an SSD index that stores them in its sectors. Every node record
+// ends in a label block: the node's label count followed by max_node_labels
+// label slots. A node with more labels than slots keeps its full count and
+// its first labels in the block, and the reader keeps all its labels in
+// memory (spilled labels), loaded from the label file.
+
+// Parses one line of a label file: comma separated numeric labels, up to an
+// optional tab. Empty entries are skipped.
+template <typename LabelT> std::vector<LabelT> parse_label_line(const std::string &line)
+{
+    std::vector<LabelT> labels;
+    std::string token;
+    std::istringstream iss(line);
+    getline(iss, token, '\t');
+    std::istringstream label_iss(token);
+    while (getline(label_iss, token, ','))
+    {
+        token.erase(std::remove(token.begin(), token.end(), '\n'), token.end());
+        token.erase(std::remove(token.begin(), token.end(), '\r'), token.end());
+        if (!token.empty())
+            labels.push_back((LabelT)std::stoul(token));
+    }
+    return labels;
+}
+
+// Fills the label block of a node with labels.
+inline void write_label_block(const std::vector<uint32_t> &labels, uint32_t *label_block,
+                              const uint64_t max_node_labels)
+{
+    label_block[0] = (uint32_t)labels.size();
+    std::copy(labels.begin(), labels.begin() + (std::min)((uint64_t)labels.size(), max_node_labels),
+              label_block + 1);
+}
+
+// Whether the labels of the node did not fit its label block.
+inline bool label_block_spilled(const uint32_t *label_block, const uint64_t max_node_labels)
+{
+    return label_block[0] > max_node_labels;
+}
+
+// Number of the (sorted) filter_labels the node carries, all of them if it
+// carries the universal label. spilled_labels are the node's labels if its
+// block spilled, nullptr otherwise.
+template <typename LabelT>
+uint32_t label_block_filter_size(const uint32_t *label_block, const uint64_t max_node_labels,
+                                 const std::vector<LabelT> *spilled_labels, const std::vector<LabelT> &filter_labels,
+                                 const bool use_universal_label, const LabelT universal_label)
+{
+    const uint32_t num_labels = spilled_labels != nullptr ? (uint32_t)spilled_labels->size()
+                                                          : (std::min)(label_block[0], (uint32_t)max_node_labels);
+    uint32_t common_size = 0;
+    for (uint32_t i = 0; i < num_labels; i++)
+    {
+        const LabelT label = spilled_labels != nullptr ? (*spilled_labels)[i] : (LabelT)label_block[1 + i];
+        if (use_universal_label && label == universal_label)
+            return (uint32_t)filter_labels.size();
+        if (std::binary_search(filter_labels.begin(), filter_labels.end(), label))
+            common_size++;
+    }
+    return common_size;
+}
+} // namespace diskann
@@ -0,0 +1,239 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+#ifndef _WINDOWS
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <sys/uio.h>
+
+#include "aligned_file_reader.h"
+
+// sectors a tenant of weight 1 may read per round robin turn
+#define DRR_QUANTUM_SECTORS 8
+// upper limit on the requests merged into one vectored read
+#define MAX_COALESCED_IOVECS 64
+// upper limit on the batches of a tenant executed together
+#define MAX_GROUPED_BATCHES 16
+
+// The deficit round robin queue of SharedIOScheduler, apart from its locking
+// and I/O. BatchT needs an int fd and a uint64_t cost in sectors. The caller
+// serializes access.
+template <typename BatchT> class DeficitRoundRobinQueue
+{
+  public:
+    // adds a tenant and returns its id
+    uint32_t add_tenant(const uint32_t weight)
+    {
+        std::unique_ptr<Tenant> tenant(new Tenant());
+        tenant->id = _next_tenant_id++;
+        tenant->weight = std::max<uint32_t>(weight, 1);
+        _tenants.push_back(std::move(tenant));
+        return _tenants.back()->id;
+    }
+
+    // the tenant must not have queued batches
+    void remove_tenant(const uint32_t tenant_id)
+    {
+        for (size_t i = 0; i < _tenants.size(); i++)
+        {
+            if (_tenants[i]->id != tenant_id)
+                continue;
+            assert(_tenants[i]->batches.empty());
+            _tenants.erase(_tenants.begin() + i);
+            if (i < _cursor)
+                _cursor--;
+            if (_cursor >= _tenants.size())
+            {
+                _cursor = 0;
+                _quantum_granted = false;
+            }
+            return;
+        }
+    }
+
+    // returns false if there is no such tenant
+    bool push(const uint32_t tenant_id, BatchT *batch)
+    {
+        auto iter = std::find_if(_tenants.begin(), _tenants.end(),
+                                 [tenant_id](const std::unique_ptr<Tenant> &t) { return t->id == tenant_id; });
+        if (iter == _tenants.end())
+            return false;
+        (*iter)->batches.push_back(batch);
+        _num_queued++;
+        return true;
+    }
+
+    bool empty() const
+    {
+        return _num_queued == 0;
+    }
+
+    // Pops the next batches, all of one tenant and file; empty if nothing is
+    // queued. The tenant at the cursor earns weight * quantum sectors once
+    // per turn and is served while its deficit covers the cost of its next
+    // batch. A tenant without queued batches keeps no credit.
+    std::vector<BatchT *> pop()
+    {
+        std::vector<BatchT *> batches;
+        if (_num_queued == 0)
+            return batches;
+        while (true)
+        {
+            Tenant &tenant = *_tenants[_cursor];
+            if (!tenant.batches.empty())
+            {
+                if (!_quantum_granted)
+                {
+                    tenant.deficit += (uint64_t)tenant.weight * DRR_QUANTUM_SECTORS;
+                    _quantum_granted = true;
+                }
+                // take every following batch on the same file the deficit
+                // still covers, so that their adjacent sectors can be read
+                // together
+                const int fd = tenant.batches.front()->fd;
+                while (!tenant.batches.empty() && batches.size() < MAX_GROUPED_BATCHES &&
+                       tenant.batches.front()->fd == fd && tenant.deficit >= tenant.batches.front()->cost)
+                {
+                    tenant.deficit -= tenant.batches.front()->cost;
+                    batches.push_back(tenant.batches.front());
+                    tenant.batches.pop_front();
+                    _num_queued--;
+                }
+                if (!batches.empty())
+                    return batches;
+            }
+            else
+            {
+                tenant.deficit = 0;
+            }
+            _cursor = (_cursor + 1) % _tenants.size();
+            _quantum_granted = false;
+        }
+    }
+
+  private:
+    struct Tenant
+    {
+        uint32_t id;
+        uint32_t weight;
+        uint64_t deficit = 0;
+        std::deque<BatchT *> batches;
+    };
+
+    std::vector<std::unique_ptr<Tenant>> _tenants;
+    uint32_t _next_tenant_id = 0;
+    uint64_t _num_queued = 0;
+    size_t _cursor = 0;
+    bool _quantum_granted = false;
+};
+
+// One vectored read of requests that continue each other on disk.
+struct CoalescedRead
+{
+    uint64_t offset;
+    uint64_t len;
+    std::vector<struct iovec> iovecs;
+};
+
+// Sorts the requests by offset and merges every run of back to back ones,
+// up to MAX_COALESCED_IOVECS, into a single read.
+std::vector<CoalescedRead> coalesce_reads(std::vector<const AlignedRead *> reqs);
+
+// Serves the reads of several disk indices (tenants) from one pool of I/O
+// threads, so shards hosted on the same device share its queues instead of
+// each index flooding them from its own search threads.
+//  - Batches are dispatched by deficit round robin: every tenant gets
+//    sectors in proportion to its weight, so a busy index can not starve
+//    the others and a heavier weight buys a larger share.
+//  - When a tenant's turn covers several of its queued batches on the same
+//    file, e.g. the beam reads of concurrent queries, they are executed
+//    together, and requests that read back to back sectors, within a batch
+//    or across them, are coalesced into a single vectored read. Different
+//    tenants read different files, so nothing is merged across tenants.
+//  - A read that returns fewer bytes than requested fails its batch.
+// Indices reach the scheduler through a ScheduledAlignedFileReader each.
+class SharedIOScheduler
+{
+  public:
+    SharedIOScheduler(const uint32_t num_io_threads = 4, const uint32_t queue_depth = MAX_IO_DEPTH);
+    ~SharedIOScheduler();
+
+    // adds a tenant and returns its id
+    uint32_t add_tenant(const uint32_t weight);
+    // the tenant must not have reads in progress
+    void remove_tenant(const uint32_t tenant_id);
+
+    // Queues read_reqs on file fd for the tenant and blocks until they are
+    // all done. Throws ANNException if any read fails.
+    void read(const uint32_t tenant_id, const int fd, std::vector<AlignedRead> &read_reqs);
+
+  private:
+    struct Batch
+    {
+        int fd;
+        std::vector<AlignedRead> *reqs;
+        uint64_t cost; // in sectors
+
+        std::mutex mut;
+        std::condition_variable cv;
+        bool done = false;
+        int error = 0;
+    };
+
+    uint32_t _queue_depth;
+    std::vector<std::thread> _io_threads;
+
+    // protects everything below
+    std::mutex _mut;
+    std::condition_variable _queue_cv;
+    DeficitRoundRobinQueue<Batch> _queue;
+    bool _stop = false;
+
+    void io_thread_main();
+    // Next batches in deficit round robin order, all of one tenant and file,
+    // empty once stopped and drained.
+    std::vector<Batch *> next_batches();
+    // returns 0 or a negative errno
+    int execute_batches(io_context_t ctx, const std::vector<Batch *> &batches);
+};
+
+// AlignedFileReader whose reads are served by a SharedIOScheduler. Searches
+// use it like any other reader; their threads only queue batches and wait,
+// the I/O itself runs on the scheduler's threads.
+class ScheduledAlignedFileReader : public AlignedFileReader
+{
+  private:
+    std::shared_ptr<SharedIOScheduler> scheduler;
+    uint32_t tenant_id;
+    FileHandle file_desc;
+    io_context_t bad_ctx = (io_context_t)-1;
+
+  public:
+    ScheduledAlignedFileReader(std::shared_ptr<SharedIOScheduler> scheduler, const uint32_t weight = 1);
+    ~ScheduledAlignedFileReader();
+
+    IOContext &get_ctx();
+
+    // register thread-id for a context
+    void register_thread();
+
+    // de-register thread-id for a context
+    void deregister_thread();
+    void deregister_all_threads();
+
+    // Open & close ops
+    // Blocking calls
+    void open(const std::string &fname);
+    void close();
+
+    // process batch of aligned requests in parallel
+    // NOTE :: blocking call
+    void read(std::vector<AlignedRead> &read_reqs, IOContext &ctx, bool async = false);
+};
+
+#endif
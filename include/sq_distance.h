@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#pragma once
+
+#include <immintrin.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace diskann
+{
+// Asymmetric distance kernels of InMemSQDataStore: a full precision query
+// against one vector of per-dimension scalar quantized codes, de-quantized as
+// vmin[d] + code[d] * delta[d]. The kernels return the raw squared L2 distance
+// (IP = false) or inner product (IP = true) over aligned_dim dimensions.
+
+// 4-bit codes are packed in blocks of 16 dimensions stored in 8 bytes:
+// byte j holds dimension j in its low nibble and dimension j + 8 in its high
+// nibble, so one 8 byte load unpacks into two runs of 8 consecutive floats.
+inline uint32_t sq_code_at(const uint8_t *code, const uint32_t num_bits, const size_t d)
+{
+    if (num_bits == 8)
+        return code[d];
+    const size_t j = d & 15;
+    const uint8_t packed = code[(d >> 4) * 8 + (j & 7)];
+    return j < 8 ? (packed & 0x0F) : (packed >> 4);
+}
+
+template <bool IP>
+float sq_distance_scalar(const float *query, const uint8_t *code, const uint32_t num_bits, const float *vmin,
+                         const float *delta, size_t aligned_dim)
+{
+    float raw = 0;
+    for (size_t d = 0; d < aligned_dim; d++)
+    {
+        float x = vmin[d] + (float)sq_code_at(code, num_bits, d) * delta[d];
+        raw += IP ? query[d] * x : (query[d] - x) * (query[d] - x);
+    }
+    return raw;
+}
+
+#ifdef USE_AVX2
+namespace sq_avx2
+{
+inline float hsum256(__m256 v)
+{
+    __m128 lo = _mm256_castps256_ps128(v);
+    __m128 hi = _mm256_extractf128_ps(v, 1);
+    lo = _mm_add_ps(lo, hi);
+    lo = _mm_hadd_ps(lo, lo);
+    lo = _mm_hadd_ps(lo, lo);
+    return _mm_cvtss_f32(lo);
+}
+
+template <bool IP>
+inline __m256 accumulate(__m256 acc, const float *query, const float *vmin, const float *delta, __m256i codes)
+{
+    __m256 x = _mm256_fmadd_ps(_mm256_cvtepi32_ps(codes), _mm256_loadu_ps(delta), _mm256_loadu_ps(vmin));
+    __m256 q = _mm256_loadu_ps(query);
+    if (IP)
+        return _mm256_fmadd_ps(q, x, acc);
+    __m256 diff = _mm256_sub_ps(q, x);
+    return _mm256_fmadd_ps(diff, diff, acc);
+}
+} // namespace sq_avx2
+
+// aligned_dim must be a multiple of 8.
+template <bool IP>
+float sq8_distance_avx2(const float *query, const uint8_t *code, const float *vmin, const float *delta,
+                        size_t aligned_dim)
+{
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t d = 0; d < aligned_dim; d += 8)
+    {
+        __m256i c = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(code + d)));
+        acc = sq_avx2::accumulate<IP>(acc, query + d, vmin + d, delta + d, c);
+    }
+    return sq_avx2::hsum256(acc);
+}
+
+// aligned_dim must be a multiple of 16.
+template <bool IP>
+float sq4_distance_avx2(const float *query, const uint8_t *code, const float *vmin, const float *delta,
+                        size_t aligned_dim)
+{
+    const __m128i mask = _mm_set1_epi8(0x0F);
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t d = 0; d < aligned_dim; d += 16)
+    {
+        __m128i packed = _mm_loadl_epi64((const __m128i *)(code + d / 2));
+        __m128i lo = _mm_and_si128(packed, mask);
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(packed, 4), mask);
+        acc = sq_avx2::accumulate<IP>(acc, query + d, vmin + d, delta + d, _mm256_cvtepu8_epi32(lo));
+        acc = sq_avx2::accumulate<IP>(acc, query + d + 8, vmin + d + 8, delta + d + 8, _mm256_cvtepu8_epi32(hi));
+    }
+    return sq_avx2::hsum256(acc);
+}
+#endif
+} // namespace diskann
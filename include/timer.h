@@ -25,6 +25,12 @@ class Timer
         return std::chrono::duration_cast<std::chrono::microseconds>(_clock::now() - check_point).count();
     }
 
+    // unlike elapsed(), keeps the fraction of a microsecond of short steps
+    float elapsed_us() const
+    {
+        return std::chrono::duration<float, std::micro>(_clock::now() - check_point).count();
+    }
+
     float elapsed_seconds() const
     {
         return (float)elapsed() / 1000000.0f;
@@ -13,14 +13,21 @@
 #include <cmath>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <filesystem>
 #include <unistd.h>
 
+#include "filter_utils.h"
 #include "index.h"
 #include "index_factory.h"
+#include "search_thread_pool.h"
 
 namespace py = pybind11;
 
@@ -28,9 +35,13 @@ class FilterDiskANN
 {
   public:
     FilterDiskANN(const diskann::Metric &m, const std::string &index_prefix, const size_t &num_points,
-                  const size_t &dimensions, const uint32_t &num_threads, const uint32_t &L)
+                  const size_t &dimensions, const uint32_t &num_threads, const uint32_t &L,
+                  const bool pin_threads = false)
+        : _dim(dimensions)
     {
-        auto index_search_params = diskann::IndexSearchParams(L, omp_get_num_procs());
+        // one search scratch per thread; searches on more threads wait for one
+        const uint32_t threads = num_threads > 0 ? num_threads : (uint32_t)omp_get_num_procs();
+        auto index_search_params = diskann::IndexSearchParams(L, threads);
 
         _index = new diskann::Index<uint8_t>(
             m, dimensions, num_points,
@@ -43,7 +54,10 @@ class FilterDiskANN
             false,                                                             // pq_dist_build
             0,                                                                 // num_pq_chunks
             false);                                                            // use_opq = false
-        _index->load(index_prefix.c_str(), omp_get_num_procs(), L);
+        _index->load(index_prefix.c_str(), threads, L);
+        // pinning one thread per CPU only pays off when the process owns the
+        // host; inside a notebook or server it fights the other threads
+        _search_pool = std::make_unique<diskann::SearchThreadPool>(threads, pin_threads);
         std::cout << "Current working directory: " << std::filesystem::current_path() << std::endl;
     }
 
@@ -52,90 +66,204 @@ class FilterDiskANN
         delete _index;
     }
 
+    // Dense query_filters: every entry of row i, plus label_offset, is a
+    // label of query i.
     void Search(py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &queries_input,
-                py::array_t<uint32_t, py::array::c_style | py::array::forcecast> &query_filters_input, const size_t num_queries,
-                const size_t knn, const uint32_t L, const uint32_t num_threads,
-                py::array_t<uint32_t, py::array::c_style> &res_id)
+                py::array_t<uint32_t, py::array::c_style | py::array::forcecast> &query_filters_input,
+                const size_t num_queries, const size_t knn, const uint32_t L, const uint32_t num_threads,
+                py::array_t<uint32_t, py::array::c_style> &res_id, const int64_t label_offset)
     {
+        if (queries_input.ndim() != 2 || (size_t)queries_input.shape(0) < num_queries)
+            throw std::invalid_argument("queries must be 2-D with at least num_queries rows");
+        if (query_filters_input.ndim() != 2 || (size_t)query_filters_input.shape(0) < num_queries)
+            throw std::invalid_argument("query_filters must be 2-D with at least num_queries rows");
+        if (res_id.size() < (py::ssize_t)(num_queries * knn))
+            throw std::invalid_argument("res_id must hold num_queries * knn ids");
+        const size_t num_filters = (size_t)query_filters_input.shape(1);
+        std::vector<int64_t> indptr(num_queries + 1);
+        for (size_t i = 0; i <= num_queries; i++)
+            indptr[i] = (int64_t)(i * num_filters);
+        validate_batch((size_t)queries_input.shape(1), indptr.data(), (size_t)query_filters_input.size(), num_queries);
+        std::vector<float> dists(num_queries * knn);
 
-        auto queries = queries_input.unchecked();
-        auto query_filters_data = query_filters_input.unchecked();
-        auto res = res_id.mutable_unchecked();
+        py::gil_scoped_release release;
+        search_batch(queries_input.data(), (size_t)queries_input.shape(1), indptr.data(), query_filters_input.data(),
+                     label_offset, num_queries, knn, L, num_threads, res_id.mutable_data(), dists.data());
+    }
+
+    // Filters in scipy CSR form: the labels of query i are
+    // indices[indptr[i]:indptr[i + 1]] + label_offset; the default 1 is the
+    // numbering write_labels uses for .spmat label matrices. The arrays are
+    // read in place when they are C-contiguous with a matching dtype. The
+    // search runs without the GIL on num_threads threads (0 for the threads
+    // of the index) and returns (ids, distances) of shape (num_queries, knn).
+    // Slots a query could not fill, e.g. because one of its labels is not in
+    // the index, hold UINT32_MAX and infinity.
+    template <typename IndPtrT, typename IndicesT>
+    py::tuple SearchCSR(py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &queries_input,
+                        py::array_t<IndPtrT, py::array::c_style> &indptr_input,
+                        py::array_t<IndicesT, py::array::c_style> &indices_input, const size_t knn, const uint32_t L,
+                        const uint32_t num_threads, const int64_t label_offset)
+    {
+        if (queries_input.ndim() != 2 || indptr_input.ndim() != 1 || indices_input.ndim() != 1)
+            throw std::invalid_argument("queries must be 2-D, indptr and indices 1-D");
+        const size_t num_queries = (size_t)queries_input.shape(0);
+        if ((size_t)indptr_input.shape(0) != num_queries + 1)
+            throw std::invalid_argument("indptr must have num_queries + 1 entries");
+        validate_batch((size_t)queries_input.shape(1), indptr_input.data(), (size_t)indices_input.shape(0),
+                       num_queries);
+
+        py::array_t<uint32_t> res_id({(py::ssize_t)num_queries, (py::ssize_t)knn});
+        py::array_t<float> res_dist({(py::ssize_t)num_queries, (py::ssize_t)knn});
+        {
+            py::gil_scoped_release release;
+            search_batch(queries_input.data(), (size_t)queries_input.shape(1), indptr_input.data(),
+                         indices_input.data(), label_offset, num_queries, knn, L, num_threads,
+                         res_id.mutable_data(), res_dist.mutable_data());
+        }
+        return py::make_tuple(res_id, res_dist);
+    }
+
+  private:
+    // Checks, while the GIL is held, that the queries match the index and
+    // that indptr describes num_queries rows of the num_indices labels.
+    template <typename IndPtrT>
+    void validate_batch(const size_t query_dim, const IndPtrT *indptr, const size_t num_indices,
+                        const size_t num_queries) const
+    {
+        if (query_dim != _dim)
+            throw std::invalid_argument("queries have " + std::to_string(query_dim) + " dimensions, the index has " +
+                                        std::to_string(_dim));
+        if (indptr[0] < 0)
+            throw std::invalid_argument("indptr must start at a non-negative offset");
+        for (size_t i = 0; i < num_queries; i++)
+        {
+            if (indptr[i + 1] < indptr[i])
+                throw std::invalid_argument("indptr must be non-decreasing");
+        }
+        if ((uint64_t)indptr[num_queries] > num_indices)
+            throw std::invalid_argument("indptr points past the end of indices");
+    }
 
-        std::vector<uint32_t> ids;
-        std::vector<uint8_t> one_query;
+    // Runs the queries in parallel, called without the GIL. The raw label
+    // of indices[j] is indices[j] + label_offset.
+    template <typename IndPtrT, typename LabelIdT>
+    void search_batch(const uint8_t *queries, const size_t query_dim, const IndPtrT *indptr, const LabelIdT *indices,
+                      const int64_t label_offset, const size_t num_queries, const size_t knn, const uint32_t L,
+                      const uint32_t num_threads, uint32_t *res_id, float *res_dist)
+    {
+        if (knn > L)
+            throw std::invalid_argument("L must be at least knn");
+        std::fill(res_id, res_id + num_queries * knn, std::numeric_limits<uint32_t>::max());
+        std::fill(res_dist, res_dist + num_queries * knn, std::numeric_limits<float>::infinity());
 
-#pragma omp parallel for schedule(dynamic, 1)
-        for (int64_t i = 0; i < (int64_t)num_queries; i++)
+        // the index takes labels as strings; convert every distinct label once
+        LabelIdT max_label = 0;
+        for (int64_t j = (int64_t)indptr[0]; j < (int64_t)indptr[num_queries]; j++)
         {
+            if constexpr (std::is_signed<LabelIdT>::value)
+            {
+                if (indices[j] < 0)
+                    throw std::invalid_argument("labels must be non-negative");
+            }
+            max_label = std::max(max_label, indices[j]);
+        }
+        // and look it up once: a label without points in the index matches
+        // nothing, so its queries keep empty rows
+        std::vector<std::string> label_strings((size_t)max_label + 1);
+        std::vector<bool> label_searchable((size_t)max_label + 1, false);
+        for (int64_t j = (int64_t)indptr[0]; j < (int64_t)indptr[num_queries]; j++)
+        {
+            if (label_strings[indices[j]].empty())
+            {
+                label_strings[indices[j]] = std::to_string((int64_t)indices[j] + label_offset);
+                label_searchable[indices[j]] = _index->is_searchable_label(label_strings[indices[j]]);
+            }
+        }
+
+        // the first error, rethrown once every thread is done
+        std::exception_ptr error;
+        std::mutex error_mutex;
+        auto search_query = [&](const size_t i) {
             std::vector<std::string> filters;
-            for(size_t j = 0; j<query_filters_data.shape(i);j++){
-                filters.emplace_back(std::to_string(query_filters_data(i,j)));
+            filters.reserve((size_t)(indptr[i + 1] - indptr[i]));
+            for (int64_t j = (int64_t)indptr[i]; j < (int64_t)indptr[i + 1]; j++)
+            {
+                if (!label_searchable[indices[j]])
+                    return;
+                filters.push_back(label_strings[indices[j]]);
+            }
+            try
+            {
+                _index->search_with_multi_filters(queries + i * query_dim, filters, knn, L, res_id + i * knn,
+                                                  res_dist + i * knn);
             }
-            _index->search_with_multi_filters(queries.data(i), filters, knn, L, &res(i, 0), nullptr);
-            // continue;
-            // _index->search_with_multi_filters(one_query.data(), filters, knn, L, ids.data(), nullptr);
-            //  index_bindings.cpp:73:46: error: no matching function for call to ‘diskann::Index<unsigned char,
-            //  unsigned int, unsigned int>::search_with_multi_filters(const unsigned char*,
-            //  std::vector<std::__cxx11::basic_string<char> >&, const uint64_t&, const uint64_t&, std::vector<unsigned
-            //  int>&, std::nullptr_t)’
-            // index_bindings.cpp:74:46: error: no matching function for call to ‘diskann::Index<unsigned char, unsigned
-            // int, unsigned int>::search_with_multi_filters(std::vector<unsigned char>&,
-            // std::vector<std::__cxx11::basic_string<char> >&, const uint64_t&, const uint64_t&, std::vector<unsigned
-            // int>&, std::nullptr_t)’
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        };
+
+        // the pool serves batches on the thread count of the index;
+        // other counts get an OpenMP team of their own
+        if (num_threads == 0 || num_threads == _search_pool->num_threads())
+        {
+            _search_pool->parallel_for(num_queries, SEARCH_CHUNK_SIZE, [&](size_t i, uint32_t) { search_query(i); });
+        }
+        else
+        {
+#pragma omp parallel for schedule(dynamic, 1) num_threads((int)num_threads)
+            for (int64_t i = 0; i < (int64_t)num_queries; i++)
+                search_query((size_t)i);
         }
-        // search_with_multi_filters(const DataType &query, const std::vector<std::string> &query_filters,
-        //                                                     const size_t K, const uint32_t L, IndexType *indices,
-        //                                                     float *distances);
-        // std::cout << "finish in cpp"  << std::endl;
+        if (error)
+            std::rethrow_exception(error);
     }
 
-  private:
+    static constexpr size_t SEARCH_CHUNK_SIZE = 8;
+
+    const size_t _dim;
     diskann::Index<uint8_t, uint32_t, uint32_t> *_index;
+    std::unique_ptr<diskann::SearchThreadPool> _search_pool;
 };
 
-// void Build(const std::string &data_path, const std::string &index_path_prefix, const std::string &label_file,
-//            const uint32_t &num_threads, const uint32_t &R, const uint32_t &L, const float &alpha)
-// {
-
-//     std::string data_type = "uint8";
-//     std::string label_type = "uint";
-//     diskann::Metric metric = diskann::Metric::L2;
-
-//     size_t data_num, data_dim;
-//     diskann::get_bin_metadata(data_path, data_num, data_dim);
-
-//     auto config = diskann::IndexConfigBuilder()
-//                       .with_metric(metric)
-//                       .with_dimension(data_dim)
-//                       .with_max_points(data_num)
-//                       .with_data_load_store_strategy(diskann::MEMORY)
-//                       .with_data_type(data_type)
-//                       .with_label_type(label_type)
-//                       .is_dynamic_index(false)
-//                       .is_enable_tags(false)
-//                       .is_use_opq(false)
-//                       .is_pq_dist_build(false)
-//                       .with_num_pq_chunks(0)
-//                       .build();
-
-//     auto index_build_params = diskann::IndexWriteParametersBuilder(L, R)
-//                                   .with_filter_list_size(0) // 过滤的L
-//                                   .with_alpha(alpha)
-//                                   .with_saturate_graph(false) // 是否为饱和图，即每个node的邻居要==R
-//                                   .with_num_threads(num_threads)
-//                                   .build();
-
-//     auto build_params = diskann::IndexBuildParamsBuilder(index_build_params)
-//                             .with_universal_label("")
-//                             .with_label_file(label_file)
-//                             .with_save_path_prefix(index_path_prefix)
-//                             .build();
-//     auto index_factory = diskann::IndexFactory(config);
-//     auto index = index_factory.create_instance();
-//     index->build(data_path, data_num, build_params, label_file); // 调用的是Index类的build函数
-//     index->save(index_path_prefix.c_str(), label_file); // 存了graph和data，search的时候要加载这两个
-// }
+// Builds a stitched index over the rows of data with the labels in the scipy
+// CSR matrix labels_csr, column c being label c + 1 as for search_csr, and
+// saves it under index_prefix for FilterDiskANN to load. Runs in-process
+// without the GIL, on num_threads threads (0 for all cores).
+void BuildStitched(py::array_t<uint8_t, py::array::c_style | py::array::forcecast> &data_input,
+                   const py::object &labels_csr, const std::string &index_prefix, const uint32_t R, const uint32_t L,
+                   const uint32_t stitched_R, const float alpha, const uint32_t num_threads)
+{
+    auto indptr = py::array_t<int64_t, py::array::c_style | py::array::forcecast>::ensure(labels_csr.attr("indptr"));
+    auto indices = py::array_t<int64_t, py::array::c_style | py::array::forcecast>::ensure(labels_csr.attr("indices"));
+    if (!indptr || !indices || indptr.ndim() != 1 || indices.ndim() != 1)
+        throw std::invalid_argument("labels_csr must be a CSR matrix with indptr and indices arrays");
+    if (data_input.ndim() != 2)
+        throw std::invalid_argument("data must be 2-D");
+    const size_t num_points = (size_t)data_input.shape(0), dim = (size_t)data_input.shape(1);
+    if ((size_t)indptr.shape(0) != num_points + 1)
+        throw std::invalid_argument("labels_csr must have one row per data point");
+
+    const int64_t *indptr_data = indptr.data(), *indices_data = indices.data();
+    std::vector<std::vector<uint32_t>> point_labels(num_points);
+    for (size_t i = 0; i < num_points; i++)
+    {
+        for (int64_t j = indptr_data[i]; j < indptr_data[i + 1]; j++)
+        {
+            if (indices_data[j] < 0 || indices_data[j] >= (int64_t)std::numeric_limits<uint32_t>::max())
+                throw std::invalid_argument("label columns must be in [0, 2^32 - 1)");
+            point_labels[i].push_back((uint32_t)indices_data[j] + 1);
+        }
+    }
+
+    const uint32_t threads = num_threads > 0 ? num_threads : (uint32_t)omp_get_num_procs();
+    py::gil_scoped_release release;
+    diskann::build_stitched_index<uint8_t>(data_input.data(), num_points, dim, point_labels, index_prefix, R, L,
+                                           stitched_R, alpha, threads);
+}
 
 PYBIND11_MODULE(filterdiskann, m)
 {
@@ -148,7 +276,21 @@ PYBIND11_MODULE(filterdiskann, m)
         .export_values();
     py::class_<FilterDiskANN>(m, "FilterDiskANN")
         .def(py::init<const diskann::Metric &, const std::string &, const size_t &, const size_t &, const uint32_t &,
-                      const uint32_t &>())
-        .def("search", &FilterDiskANN::Search);
-    // m.def("build", &Build);
+                      const uint32_t &, const bool>(),
+             py::arg("metric"), py::arg("index_prefix"), py::arg("num_points"), py::arg("dimensions"),
+             py::arg("num_threads"), py::arg("L"), py::arg("pin_threads") = false)
+        .def("search", &FilterDiskANN::Search, py::arg("queries"), py::arg("query_filters"), py::arg("num_queries"),
+             py::arg("knn"), py::arg("L"), py::arg("num_threads"), py::arg("res_id"), py::arg("label_offset") = 0)
+        // one overload per index dtype pair of scipy CSR matrices
+        .def("search_csr", &FilterDiskANN::SearchCSR<int32_t, int32_t>, py::arg("queries"), py::arg("indptr"),
+             py::arg("indices"), py::arg("knn"), py::arg("L"), py::arg("num_threads") = 0,
+             py::arg("label_offset") = 1)
+        .def("search_csr", &FilterDiskANN::SearchCSR<int64_t, int32_t>, py::arg("queries"), py::arg("indptr"),
+             py::arg("indices"), py::arg("knn"), py::arg("L"), py::arg("num_threads") = 0,
+             py::arg("label_offset") = 1)
+        .def("search_csr", &FilterDiskANN::SearchCSR<int64_t, int64_t>, py::arg("queries"), py::arg("indptr"),
+             py::arg("indices"), py::arg("knn"), py::arg("L"), py::arg("num_threads") = 0,
+             py::arg("label_offset") = 1);
+    m.def("build_stitched", &BuildStitched, py::arg("data"), py::arg("labels_csr"), py::arg("index_prefix"),
+          py::arg("R"), py::arg("L"), py::arg("stitched_R"), py::arg("alpha"), py::arg("num_threads") = 0);
 }
\ No newline at end of file
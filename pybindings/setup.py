@@ -26,7 +26,9 @@ module = Pybind11Extension('filterdiskann',
                       '../src/in_mem_data_store.cpp', '../src/memory_mapper.cpp', '../src/abstract_index.cpp',
                       '../src/scratch.cpp', '../src/pq.cpp', #'../src/linux_aligned_file_reader.cpp', 
                       '../src/utils.cpp', '../src/index.cpp', #'../src/disk_utils.cpp', 
-                      '../src/windows_aligned_file_reader.cpp', '../src/natural_number_set.cpp'],
+                      '../src/windows_aligned_file_reader.cpp', '../src/natural_number_set.cpp',
+                      '../src/instrumentation.cpp', '../src/search_thread_pool.cpp',
+                      '../src/numa_utils.cpp', '../src/huge_pages.cpp'],
              include_dirs=include_dirs,
              language='c++')
 
@@ -12,7 +12,12 @@ template <typename DT>
 StaticDiskIndex<DT>::StaticDiskIndex(const diskann::Metric metric, const std::string &index_path_prefix,
                                      const uint32_t num_threads, const size_t num_nodes_to_cache,
                                      const uint32_t cache_mechanism)
+#ifdef _WINDOWS
     : _reader(std::make_shared<PlatformSpecificAlignedFileReader>()), _index(_reader, metric)
+#else
+    // the I/O backend is picked with DISKANN_IO_BACKEND, libaio by default
+    : _reader(create_linux_aligned_file_reader()), _index(_reader, metric)
+#endif
 {
     const uint32_t _num_threads = num_threads != 0 ? num_threads : omp_get_num_procs();
     int load_success = _index.load(_num_threads, index_path_prefix.c_str());
@@ -44,10 +44,10 @@ std::pair<uint32_t, uint32_t> AbstractIndex::search_with_filters(const DataType
 template <typename IndexType>
 std::pair<uint32_t, uint32_t> AbstractIndex::search_with_multi_filters(const DataType &query, const std::vector<std::string> &query_filters,
                                                                  const size_t &K, const uint32_t &L, IndexType *indices,
-                                                                 float *distances)
+                                                                 float *distances, QueryStats *stats)
 {
     auto any_indices = std::any(indices);
-    return _search_with_multi_filters(query, query_filters, K, L, any_indices, distances);
+    return _search_with_multi_filters(query, query_filters, K, L, any_indices, distances, stats);
 }
 
 template <typename data_type>
@@ -158,11 +158,11 @@ template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search_w
 
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search_with_multi_filters<uint32_t>(
     const DataType &query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-    float *distances);
+    float *distances, QueryStats *stats);
 
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> AbstractIndex::search_with_multi_filters<uint64_t>(
     const DataType &query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-    float *distances);
+    float *distances, QueryStats *stats);
 
 template DISKANN_DLLEXPORT size_t AbstractIndex::search_with_tags<float, int32_t>(const float *query, const uint64_t K,
                                                                                   const uint32_t L, int32_t *tags,
@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT license.
 
+#include <map>
+
 #include "common_includes.h"
 
 #if defined(RELEASE_UNUSED_TCMALLOC_MEMORY_AT_CHECKPOINTS) && defined(DISKANN_BUILD)
@@ -16,6 +18,7 @@
 #include "percentile_stats.h"
 #include "partition.h"
 #include "pq_flash_index.h"
+#include "sector_labels.h"
 #include "timer.h"
 #include "tsl/robin_set.h"
 
@@ -824,9 +827,19 @@ uint32_t optimize_beamwidth(std::unique_ptr<diskann::PQFlashIndex<T, LabelT>> &p
     return best_bw;
 }
 
+// Reads the next point's labels from a label file into its label block.
+static void read_node_labels(std::ifstream &label_reader, uint32_t *label_block, const uint64_t max_node_labels)
+{
+    std::string line;
+    if (!std::getline(label_reader, line))
+        throw ANNException("Label file has fewer lines than the index has points", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    write_label_block(parse_label_line<uint32_t>(line), label_block, max_node_labels);
+}
+
 template <typename T>
 void create_disk_layout(const std::string base_file, const std::string mem_index_file, const std::string output_file,
-                        const std::string reorder_data_file)
+                        const std::string reorder_data_file, const std::string label_file)
 {
     uint32_t npts, ndims;
 
@@ -902,6 +915,42 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
     if (vamana_frozen_num == 1)
         vamana_frozen_loc = medoid;
     max_node_len = (((uint64_t)width_u32 + 1) * sizeof(uint32_t)) + (ndims_64 * sizeof(T));
+
+    // Optionally store every node's labels after its neighbors, as a count
+    // and max_node_labels label slots, so filters can be checked on the
+    // sector instead of an in-memory label list. Every node pays for the
+    // slots, so they cover SECTOR_LABELS_COVERAGE of the nodes rather than
+    // the node with the most labels; the labels of the other nodes spill to
+    // memory when the index is loaded.
+    uint64_t max_node_labels = 0;
+    std::ifstream label_reader;
+    if (label_file != std::string(""))
+    {
+        std::ifstream label_scanner(label_file);
+        if (label_scanner.fail())
+            throw ANNException("Failed to open label file " + label_file, -1, __FUNCSIG__, __FILE__, __LINE__);
+        std::map<uint64_t, uint64_t> label_count_hist;
+        uint64_t num_label_lines = 0;
+        std::string line;
+        while (std::getline(label_scanner, line))
+        {
+            label_count_hist[parse_label_line<uint32_t>(line).size()]++;
+            num_label_lines++;
+        }
+        uint64_t covered = 0;
+        for (const auto &count_nodes : label_count_hist)
+        {
+            max_node_labels = count_nodes.first;
+            covered += count_nodes.second;
+            if ((double)covered >= SECTOR_LABELS_COVERAGE * (double)num_label_lines)
+                break;
+        }
+        max_node_len += (1 + max_node_labels) * sizeof(uint32_t);
+        label_reader.open(label_file);
+        diskann::cout << "label slots per node: " << max_node_labels << ", nodes with spilled labels: "
+                      << num_label_lines - covered << std::endl;
+    }
+    const uint64_t label_block_offset = ndims_64 * sizeof(T) + ((uint64_t)width_u32 + 1) * sizeof(uint32_t);
     nnodes_per_sector = defaults::SECTOR_LEN / max_node_len; // 0 if max_node_len > SECTOR_LEN
 
     diskann::cout << "medoid: " << medoid << "B" << std::endl;
@@ -944,6 +993,8 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
         output_file_meta.push_back(n_data_nodes_per_sector);
     }
     output_file_meta.push_back(disk_index_file_size);
+    if (max_node_labels > 0)
+        output_file_meta.push_back(max_node_labels);
 
     diskann_writer.write(sector_buf.get(), defaults::SECTOR_LEN);
 
@@ -990,6 +1041,11 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
                 memcpy(node_buf.get() + ndims_64 * sizeof(T) + sizeof(uint32_t), nhood_buf,
                        (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
 
+                // labels last
+                if (max_node_labels > 0)
+                    read_node_labels(label_reader, (uint32_t *)(node_buf.get() + label_block_offset),
+                                     max_node_labels);
+
                 // get offset into sector_buf
                 char *sector_node_buf = sector_buf.get() + (sector_node_id * max_node_len);
 
@@ -1039,6 +1095,11 @@ void create_disk_layout(const std::string base_file, const std::string mem_index
             memcpy(multisector_buf.get() + ndims_64 * sizeof(T) + sizeof(uint32_t), nhood_buf,
                    (std::min)(nnbrs, width_u32) * sizeof(uint32_t));
 
+            // labels last
+            if (max_node_labels > 0)
+                read_node_labels(label_reader, (uint32_t *)(multisector_buf.get() + label_block_offset),
+                                 max_node_labels);
+
             // flush sector to disk
             diskann_writer.write(multisector_buf.get(), nsectors_per_node * defaults::SECTOR_LEN);
         }
@@ -1338,17 +1399,125 @@ int build_disk_index(const char *dataFilePath, const char *indexFilePath, const
     return 0;
 }
 
+template <typename T>
+int create_disk_index_from_mem_index(const std::string &mem_index_path, const std::string &index_prefix_path,
+                                     const size_t num_pq_chunks, const bool use_opq, const std::string &data_file,
+                                     const bool labels_in_sectors, const bool pq_fast_scan,
+                                     const diskann::Metric metric)
+{
+    if (metric != diskann::Metric::L2)
+    {
+        // the PQ pivots and the disk layout below are built for L2 only
+        throw diskann::ANNException("create_disk_index_from_mem_index supports only L2 indices", -1, __FUNCSIG__,
+                                    __FILE__, __LINE__);
+    }
+
+    std::string data_file_to_use = data_file.empty() ? mem_index_path + ".data" : data_file;
+    std::string pq_pivots_path = index_prefix_path + "_pq_pivots.bin";
+    std::string pq_compressed_vectors_path = index_prefix_path + "_pq_compressed.bin";
+    std::string disk_index_path = index_prefix_path + "_disk.index";
+    std::string sample_base_prefix = index_prefix_path + "_sample";
+
+    std::string mem_labels_file = mem_index_path + "_labels.txt";
+    std::string mem_labels_to_medoids_file = mem_index_path + "_labels_to_medoids.txt";
+    std::string mem_univ_label_file = mem_index_path + "_universal_label.txt";
+    std::string mem_labels_map_file = mem_index_path + "_labels_map.txt";
+
+    if (!file_exists(mem_index_path) || !file_exists(data_file_to_use))
+    {
+        diskann::cerr << "Index " << mem_index_path << " or data file " << data_file_to_use << " not found"
+                      << std::endl;
+        return -1;
+    }
+
+    size_t points_num, dim;
+    diskann::get_bin_metadata(data_file_to_use, points_num, dim);
+    if (num_pq_chunks == 0 || num_pq_chunks > dim || num_pq_chunks > MAX_PQ_CHUNKS)
+    {
+        diskann::cerr << "Number of PQ chunks must be in [1, min(dim, " << MAX_PQ_CHUNKS << ")]" << std::endl;
+        return -1;
+    }
+
+    Timer timer;
+    const double p_val = ((double)MAX_PQ_TRAINING_SET_SIZE / (double)points_num);
+    diskann::cout << "Compressing " << dim << "-dimensional data into " << num_pq_chunks
+                  << (pq_fast_scan ? " 4-bit" : "") << " PQ codes per vector." << std::endl;
+    generate_quantized_data<T>(data_file_to_use, pq_pivots_path, pq_compressed_vectors_path, diskann::Metric::L2,
+                               p_val, num_pq_chunks, use_opq, "", pq_fast_scan ? NUM_PQ4_CENTROIDS : NUM_PQ_CENTROIDS);
+    diskann::cout << timer.elapsed_seconds_for_step("generating quantized data") << std::endl;
+
+    timer.reset();
+    std::string sector_labels_file = (labels_in_sectors && file_exists(mem_labels_file)) ? mem_labels_file : "";
+    diskann::create_disk_layout<T>(data_file_to_use, mem_index_path, disk_index_path, "", sector_labels_file);
+    diskann::cout << timer.elapsed_seconds_for_step("generating disk layout") << std::endl;
+
+    double ten_percent_points = std::ceil(points_num * 0.1);
+    double num_sample_points =
+        ten_percent_points > MAX_SAMPLE_POINTS_FOR_WARMUP ? MAX_SAMPLE_POINTS_FOR_WARMUP : ten_percent_points;
+    gen_random_slice<T>(data_file_to_use.c_str(), sample_base_prefix, num_sample_points / points_num);
+
+    if (file_exists(mem_labels_file))
+        copy_file(mem_labels_file, disk_index_path + "_labels.txt");
+    if (file_exists(mem_univ_label_file))
+        copy_file(mem_univ_label_file, disk_index_path + "_universal_label.txt");
+    if (file_exists(mem_labels_map_file))
+        copy_file(mem_labels_map_file, disk_index_path + "_labels_map.txt");
+
+    // In-memory indices write "label:m1,m2,..."; PQFlashIndex reads
+    // comma separated "label,m1,m2,...".
+    if (file_exists(mem_labels_to_medoids_file))
+    {
+        std::ifstream medoid_reader(mem_labels_to_medoids_file);
+        std::ofstream medoid_writer(disk_index_path + "_labels_to_medoids.txt");
+        std::string line;
+        while (std::getline(medoid_reader, line))
+        {
+            line.erase(std::remove(line.begin(), line.end(), '\r'), line.end());
+            if (line.empty())
+                continue;
+            std::replace(line.begin(), line.end(), ':', ',');
+            medoid_writer << line << std::endl;
+        }
+    }
+    return 0;
+}
+
 template DISKANN_DLLEXPORT void create_disk_layout<int8_t>(const std::string base_file,
                                                            const std::string mem_index_file,
                                                            const std::string output_file,
-                                                           const std::string reorder_data_file);
+                                                           const std::string reorder_data_file,
+                                                           const std::string label_file);
 template DISKANN_DLLEXPORT void create_disk_layout<uint8_t>(const std::string base_file,
                                                             const std::string mem_index_file,
                                                             const std::string output_file,
-                                                            const std::string reorder_data_file);
+                                                            const std::string reorder_data_file,
+                                                            const std::string label_file);
 template DISKANN_DLLEXPORT void create_disk_layout<float>(const std::string base_file, const std::string mem_index_file,
                                                           const std::string output_file,
-                                                          const std::string reorder_data_file);
+                                                          const std::string reorder_data_file,
+                                                          const std::string label_file);
+
+template DISKANN_DLLEXPORT int create_disk_index_from_mem_index<int8_t>(const std::string &mem_index_path,
+                                                                        const std::string &index_prefix_path,
+                                                                        const size_t num_pq_chunks, const bool use_opq,
+                                                                        const std::string &data_file,
+                                                                        const bool labels_in_sectors,
+                                                                        const bool pq_fast_scan,
+                                                                        const diskann::Metric metric);
+template DISKANN_DLLEXPORT int create_disk_index_from_mem_index<uint8_t>(const std::string &mem_index_path,
+                                                                         const std::string &index_prefix_path,
+                                                                         const size_t num_pq_chunks, const bool use_opq,
+                                                                         const std::string &data_file,
+                                                                         const bool labels_in_sectors,
+                                                                         const bool pq_fast_scan,
+                                                                        const diskann::Metric metric);
+template DISKANN_DLLEXPORT int create_disk_index_from_mem_index<float>(const std::string &mem_index_path,
+                                                                       const std::string &index_prefix_path,
+                                                                       const size_t num_pq_chunks, const bool use_opq,
+                                                                       const std::string &data_file,
+                                                                       const bool labels_in_sectors,
+                                                                       const bool pq_fast_scan,
+                                                                       const diskann::Metric metric);
 
 template DISKANN_DLLEXPORT int8_t *load_warmup<int8_t>(const std::string &cache_warmup_file, uint64_t &warmup_num,
                                                        uint64_t warmup_dim, uint64_t warmup_aligned_dim);
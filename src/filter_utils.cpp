@@ -11,6 +11,8 @@
 #include <omp.h>
 #include "filter_utils.h"
 #include "index.h"
+#include "instrumentation.h"
+#include "math_utils.h"
 #include "parameters.h"
 #include "utils.h"
 
@@ -149,6 +151,56 @@ void load_sparse_matrix(const std::string &filename, std::vector<std::vector<std
 
 namespace diskann
 {
+namespace
+{
+// Silences std::cout and diskann::cout, e.g. over the per-label index
+// builds, and restores their states when it goes out of scope, also when a
+// build throws.
+class ScopedMuteCout
+{
+  public:
+    ScopedMuteCout() : _cout_state(std::cout.rdstate()), _diskann_cout_state(diskann::cout.rdstate())
+    {
+        std::cout.setstate(std::ios_base::failbit);
+        diskann::cout.setstate(std::ios_base::failbit);
+    }
+
+    ~ScopedMuteCout()
+    {
+        std::cout.clear(_cout_state);
+        diskann::cout.clear(_diskann_cout_state);
+    }
+
+    ScopedMuteCout(const ScopedMuteCout &) = delete;
+    ScopedMuteCout &operator=(const ScopedMuteCout &) = delete;
+
+  private:
+    const std::ios_base::iostate _cout_state;
+    const std::ios_base::iostate _diskann_cout_state;
+};
+
+// Index::build sets the OpenMP team size of the calling thread to its
+// build threads; this puts back the caller's setting.
+class ScopedOmpMaxThreads
+{
+  public:
+    ScopedOmpMaxThreads() : _max_threads(omp_get_max_threads())
+    {
+    }
+
+    ~ScopedOmpMaxThreads()
+    {
+        omp_set_num_threads(_max_threads);
+    }
+
+    ScopedOmpMaxThreads(const ScopedOmpMaxThreads &) = delete;
+    ScopedOmpMaxThreads &operator=(const ScopedOmpMaxThreads &) = delete;
+
+  private:
+    const int _max_threads;
+};
+} // namespace
+
 /*
  * Using passed in parameters and files generated from step 3,
  * builds a vanilla diskANN index for each label.
@@ -169,39 +221,240 @@ void generate_label_indices(path input_data_path, path final_index_path_prefix,
     std::cout << "Generating indices per label..." << std::endl;
     // for each label, build an index on resp. points
     double total_indexing_time = 0.0, indexing_percentage = 0.0;
-    std::cout.setstate(std::ios_base::failbit);
-    diskann::cout.setstate(std::ios_base::failbit);
-    for (const auto &bl : all_labels)
     {
-        std::string lbl = std::to_string(bl);
-        path curr_label_input_data_path(input_data_path + "_" + lbl);
-        path curr_label_index_path(final_index_path_prefix + "_" + lbl);
-
-        size_t number_of_label_points, dimension;
-        diskann::get_bin_metadata(curr_label_input_data_path, number_of_label_points, dimension);
-        if (number_of_label_points < 1000) continue;
-        std::cout<<"Build Graph for label "<<lbl<<std::endl;
-        diskann::Index<T> index(diskann::Metric::L2, dimension, number_of_label_points,
-                                std::make_shared<diskann::IndexWriteParameters>(label_index_build_parameters), nullptr,
-                                0, false, false);
-
-        auto index_build_timer = std::chrono::high_resolution_clock::now();
-        index.build(curr_label_input_data_path.c_str(), number_of_label_points);
-        std::chrono::duration<double> current_indexing_time =
-            std::chrono::high_resolution_clock::now() - index_build_timer;
-
-        total_indexing_time += current_indexing_time.count();
-        indexing_percentage += (1 / (double)all_labels.size());
-        // print_progress(indexing_percentage);
-
-        index.save(curr_label_index_path.c_str());
+        ScopedMuteCout mute_cout;
+        for (const auto &bl : all_labels)
+        {
+            std::string lbl = std::to_string(bl);
+            path curr_label_input_data_path(input_data_path + "_" + lbl);
+            path curr_label_index_path(final_index_path_prefix + "_" + lbl);
+
+            size_t number_of_label_points, dimension;
+            diskann::get_bin_metadata(curr_label_input_data_path, number_of_label_points, dimension);
+            if (number_of_label_points < 1000) continue;
+            std::cout<<"Build Graph for label "<<lbl<<std::endl;
+            diskann::Index<T> index(diskann::Metric::L2, dimension, number_of_label_points,
+                                    std::make_shared<diskann::IndexWriteParameters>(label_index_build_parameters),
+                                    nullptr, 0, false, false);
+
+            auto index_build_timer = std::chrono::high_resolution_clock::now();
+            index.build(curr_label_input_data_path.c_str(), number_of_label_points);
+            std::chrono::duration<double> current_indexing_time =
+                std::chrono::high_resolution_clock::now() - index_build_timer;
+
+            total_indexing_time += current_indexing_time.count();
+            indexing_percentage += (1 / (double)all_labels.size());
+            // print_progress(indexing_percentage);
+
+            index.save(curr_label_index_path.c_str());
+        }
     }
-    std::cout.clear();
-    diskann::cout.clear();
 
     std::cout << "\nDone. Generated per-label indices in " << total_indexing_time << " seconds\n" << std::endl;
 }
 
+/*
+ * Labels with fewer than 1000 points get no index of their own, as in
+ * generate_label_indices, and enter the stitched graph at their first point.
+ * The entry points of the other labels are random members of the k-means
+ * clusters of their points, as in the build_stitched_index app.
+ */
+template <typename T>
+void build_stitched_index(const T *data, size_t num_points, size_t dim,
+                          const std::vector<std::vector<uint32_t>> &point_labels, path final_index_path_prefix,
+                          uint32_t R, uint32_t L, uint32_t stitched_R, float alpha, uint32_t num_threads)
+{
+    const uint32_t MIN_LABEL_INDEX_POINTS = 1000, NUM_START_POINTS = 5;
+    if (point_labels.size() != num_points)
+        throw diskann::ANNException("Number of label rows does not match the number of points", -1, __FUNCSIG__,
+                                    __FILE__, __LINE__);
+
+    auto index_timer = std::chrono::high_resolution_clock::now();
+
+    // label ids are given from 1 in order of first use
+    tsl::robin_map<uint32_t, uint32_t> raw_to_label_id;
+    std::vector<uint32_t> label_id_to_raw(1, 0);
+    std::vector<std::vector<uint32_t>> label_id_to_points(1);
+    std::vector<std::vector<uint32_t>> point_label_ids(num_points);
+    for (uint32_t point = 0; point < num_points; point++)
+    {
+        if (point_labels[point].empty())
+            throw diskann::ANNException("Point " + std::to_string(point) + " has no label", -1, __FUNCSIG__, __FILE__,
+                                        __LINE__);
+        for (const auto raw_label : point_labels[point])
+        {
+            uint32_t label_id;
+            auto iter = raw_to_label_id.find(raw_label);
+            if (iter == raw_to_label_id.end())
+            {
+                label_id = (uint32_t)label_id_to_raw.size();
+                raw_to_label_id[raw_label] = label_id;
+                label_id_to_raw.push_back(raw_label);
+                label_id_to_points.emplace_back();
+            }
+            else
+            {
+                label_id = iter->second;
+            }
+            // skip a label repeated within the row
+            if (label_id_to_points[label_id].empty() || label_id_to_points[label_id].back() != point)
+            {
+                label_id_to_points[label_id].push_back(point);
+                point_label_ids[point].push_back(label_id);
+            }
+        }
+    }
+    std::cout << "Identified " << label_id_to_raw.size() - 1 << " distinct label(s) for " << num_points << " points"
+              << std::endl;
+
+    // build an index per label from a copy of its points and union the
+    // graphs, with at most one edge between two points
+    diskann::IndexWriteParameters label_index_build_parameters = diskann::IndexWriteParametersBuilder(L, R)
+                                                                     .with_saturate_graph(false)
+                                                                     .with_alpha(alpha)
+                                                                     .with_num_threads(num_threads)
+                                                                     .build();
+    std::vector<std::vector<uint32_t>> stitched_graph(num_points);
+    std::vector<std::vector<uint32_t>> label_entry_points(label_id_to_points.size());
+    std::mt19937 gen(std::random_device{}());
+
+    ScopedOmpMaxThreads restore_omp_max_threads;
+    {
+        ScopedMuteCout mute_cout;
+        for (uint32_t label_id = 1; label_id < label_id_to_points.size(); label_id++)
+        {
+            const auto &label_points = label_id_to_points[label_id];
+            const size_t label_num_points = label_points.size();
+            if (label_num_points < MIN_LABEL_INDEX_POINTS)
+            {
+                label_entry_points[label_id].push_back(label_points[0]);
+                continue;
+            }
+
+            std::vector<T> label_data(label_num_points * dim);
+#pragma omp parallel for schedule(static, 4096) num_threads(num_threads)
+            for (int64_t i = 0; i < (int64_t)label_num_points; i++)
+                std::memcpy(label_data.data() + i * dim, data + (size_t)label_points[i] * dim, dim * sizeof(T));
+
+            {
+                diskann::Index<T> index(diskann::Metric::L2, dim, label_num_points,
+                                        std::make_shared<diskann::IndexWriteParameters>(label_index_build_parameters),
+                                        nullptr, 0, false, false);
+                index.build(label_data.data(), label_num_points, std::vector<uint32_t>());
+
+                DISKANN_PROBE_SCOPE(StitchLabelGraph);
+                for (uint32_t node = 0; node < label_num_points; node++)
+                {
+                    auto &point_neighbors = stitched_graph[label_points[node]];
+                    for (const auto neighbor : index.get_neighbor(node))
+                    {
+                        const uint32_t original_neighbor = label_points[neighbor];
+                        if (std::find(point_neighbors.begin(), point_neighbors.end(), original_neighbor) ==
+                            point_neighbors.end())
+                        {
+                            point_neighbors.push_back(original_neighbor);
+                            DISKANN_PROBE_COUNT(StitchedEdges, 1);
+                        }
+                    }
+                }
+            }
+
+            std::vector<float> float_label_data(label_data.begin(), label_data.end());
+            std::vector<float> pivot_data((size_t)NUM_START_POINTS * dim);
+            std::vector<std::vector<size_t>> clusters(NUM_START_POINTS);
+            kmeans::selecting_pivots(float_label_data.data(), label_num_points, dim, pivot_data.data(),
+                                     NUM_START_POINTS);
+            kmeans::run_lloyds(float_label_data.data(), label_num_points, dim, pivot_data.data(), NUM_START_POINTS, 30,
+                               clusters.data(), nullptr);
+            for (const auto &cluster : clusters)
+            {
+                if (cluster.empty())
+                    continue;
+                const size_t member = std::uniform_int_distribution<size_t>(0, cluster.size() - 1)(gen);
+                label_entry_points[label_id].push_back(label_points[cluster[member]]);
+            }
+            if (label_entry_points[label_id].empty())
+                label_entry_points[label_id].push_back(label_points[0]);
+        }
+    }
+
+    // write the unpruned index in the layout Index::load reads; it is only
+    // kept until the pruned index is saved
+    const path full_index_path_prefix = final_index_path_prefix + "_full";
+    {
+        const size_t METADATA = 2 * sizeof(uint64_t) + 2 * sizeof(uint32_t);
+        uint64_t index_size = METADATA, index_num_frozen_points = 0;
+        uint32_t index_max_observed_degree = 0, index_entry_point = 0;
+        for (const auto &point_neighbors : stitched_graph)
+        {
+            index_size += (point_neighbors.size() + 1) * sizeof(uint32_t);
+            index_max_observed_degree = std::max(index_max_observed_degree, (uint32_t)point_neighbors.size());
+        }
+
+        std::ofstream graph_writer;
+        graph_writer.exceptions(std::ios::badbit | std::ios::failbit);
+        graph_writer.open(full_index_path_prefix, std::ios_base::binary);
+        graph_writer.write((char *)&index_size, sizeof(uint64_t));
+        graph_writer.write((char *)&index_max_observed_degree, sizeof(uint32_t));
+        graph_writer.write((char *)&index_entry_point, sizeof(uint32_t));
+        graph_writer.write((char *)&index_num_frozen_points, sizeof(uint64_t));
+        for (const auto &point_neighbors : stitched_graph)
+        {
+            const uint32_t num_neighbors = (uint32_t)point_neighbors.size();
+            graph_writer.write((char *)&num_neighbors, sizeof(uint32_t));
+            graph_writer.write((char *)point_neighbors.data(), num_neighbors * sizeof(uint32_t));
+        }
+        graph_writer.close();
+    }
+    stitched_graph.clear();
+    stitched_graph.shrink_to_fit();
+    diskann::save_bin<T>(full_index_path_prefix + ".data", const_cast<T *>(data), num_points, dim);
+
+    std::ofstream labels_writer;
+    labels_writer.exceptions(std::ios::badbit | std::ios::failbit);
+    labels_writer.open(full_index_path_prefix + "_labels.txt");
+    for (const auto &label_ids : point_label_ids)
+    {
+        for (size_t j = 0; j < label_ids.size(); j++)
+            labels_writer << label_ids[j] << (j + 1 < label_ids.size() ? "," : "\n");
+    }
+    labels_writer.close();
+
+    std::ofstream medoids_writer;
+    medoids_writer.exceptions(std::ios::badbit | std::ios::failbit);
+    medoids_writer.open(full_index_path_prefix + "_labels_to_medoids.txt");
+    for (uint32_t label_id = 1; label_id < label_entry_points.size(); label_id++)
+    {
+        const auto &medoids = label_entry_points[label_id];
+        medoids_writer << label_id << ":";
+        for (size_t j = 0; j < medoids.size(); j++)
+            medoids_writer << medoids[j] << (j + 1 < medoids.size() ? "," : "\n");
+    }
+    medoids_writer.close();
+
+    // prune the stitched graph as the app's prune_and_save does
+    {
+        diskann::Index<T> index(diskann::Metric::L2, dim, num_points, nullptr, nullptr, 0, false, false);
+        // not searching this index, set search_l to 1
+        index.load(full_index_path_prefix.c_str(), num_threads, 1);
+        index.prune_all_neighbors(stitched_R, 750, 1.2f);
+        index.save(final_index_path_prefix.c_str());
+    }
+
+    std::ofstream map_writer;
+    map_writer.exceptions(std::ios::badbit | std::ios::failbit);
+    map_writer.open(final_index_path_prefix + "_labels_map.txt");
+    for (uint32_t label_id = 1; label_id < label_id_to_raw.size(); label_id++)
+        map_writer << label_id_to_raw[label_id] << "\t" << label_id << "\n";
+    map_writer.close();
+
+    for (const auto &suffix : {"", ".data", "_labels.txt", "_labels_to_medoids.txt"})
+        std::remove((full_index_path_prefix + suffix).c_str());
+
+    std::chrono::duration<double> index_time = std::chrono::high_resolution_clock::now() - index_timer;
+    std::cout << "pruned/stitched graph generated in " << index_time.count() << " seconds" << std::endl;
+}
+
 // for use on systems without writev (i.e. Windows)
 template <typename T>
 tsl::robin_map<std::string, std::vector<uint32_t>> generate_label_specific_vector_files_compat(
@@ -409,6 +662,19 @@ template DISKANN_DLLEXPORT void generate_label_indices<int8_t>(path input_data_p
                                                                label_set all_labels, uint32_t R, uint32_t L,
                                                                float alpha, uint32_t num_threads);
 
+template DISKANN_DLLEXPORT void build_stitched_index<float>(const float *data, size_t num_points, size_t dim,
+                                                           const std::vector<std::vector<uint32_t>> &point_labels,
+                                                           path final_index_path_prefix, uint32_t R, uint32_t L,
+                                                           uint32_t stitched_R, float alpha, uint32_t num_threads);
+template DISKANN_DLLEXPORT void build_stitched_index<uint8_t>(const uint8_t *data, size_t num_points, size_t dim,
+                                                             const std::vector<std::vector<uint32_t>> &point_labels,
+                                                             path final_index_path_prefix, uint32_t R, uint32_t L,
+                                                             uint32_t stitched_R, float alpha, uint32_t num_threads);
+template DISKANN_DLLEXPORT void build_stitched_index<int8_t>(const int8_t *data, size_t num_points, size_t dim,
+                                                            const std::vector<std::vector<uint32_t>> &point_labels,
+                                                            path final_index_path_prefix, uint32_t R, uint32_t L,
+                                                            uint32_t stitched_R, float alpha, uint32_t num_threads);
+
 template DISKANN_DLLEXPORT tsl::robin_map<std::string, std::vector<uint32_t>>
 generate_label_specific_vector_files_compat<float>(path input_data_path,
                                                    tsl::robin_map<std::string, uint32_t> &labels_to_number_of_points,
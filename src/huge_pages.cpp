@@ -0,0 +1,129 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <atomic>
+#include <cstdint>
+
+#ifndef _WINDOWS
+#include <sys/mman.h>
+#endif
+
+#include "ann_exception.h"
+#include "huge_pages.h"
+#include "logger.h"
+#include "utils.h"
+
+namespace diskann
+{
+namespace
+{
+constexpr size_t HUGE_PAGE_2MB = (size_t)1 << 21;
+constexpr size_t HUGE_PAGE_1GB = (size_t)1 << 30;
+
+#ifndef _WINDOWS
+size_t huge_page_size(const HugePagePolicy policy)
+{
+    return policy == HugePagePolicy::Explicit1GB ? HUGE_PAGE_1GB : HUGE_PAGE_2MB;
+}
+
+// The policy an allocation of size bytes gets. Rounding a small array up
+// to a whole huge page would mostly waste the page, so 1GB pages apply from
+// 1GB on, 2MB pages below that, and arrays under 2MB keep regular pages.
+// huge_page_free derives the same policy from the same size.
+HugePagePolicy effective_policy(const size_t size, const HugePagePolicy policy)
+{
+    if (policy == HugePagePolicy::Explicit1GB && size < HUGE_PAGE_1GB)
+        return size < HUGE_PAGE_2MB ? HugePagePolicy::None : HugePagePolicy::Explicit2MB;
+    if (size < HUGE_PAGE_2MB)
+        return HugePagePolicy::None;
+    return policy;
+}
+
+// Warns once per process, the allocations of a load all fail the same way.
+void warn_once(std::atomic<bool> &warned, const char *message)
+{
+    if (!warned.exchange(true))
+        diskann::cerr << message << std::endl;
+}
+
+void *map_transparent(const size_t length)
+{
+    static std::atomic<bool> warned{false};
+
+    // over-reserve by one huge page and trim to a 2MB aligned range, so that
+    // every 2MB of the array can be a single huge page
+    const size_t reserve = length + HUGE_PAGE_2MB;
+    char *base = (char *)mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED)
+        report_memory_allocation_failure();
+    char *aligned = (char *)ROUND_UP((uintptr_t)base, HUGE_PAGE_2MB);
+    if (aligned > base)
+        munmap(base, aligned - base);
+    const size_t tail = (size_t)((base + reserve) - (aligned + length));
+    if (tail > 0)
+        munmap(aligned + length, tail);
+
+    if (madvise(aligned, length, MADV_HUGEPAGE) != 0)
+        warn_once(warned, "madvise(MADV_HUGEPAGE) failed, check /sys/kernel/mm/transparent_hugepage/enabled");
+    return aligned;
+}
+#endif
+} // namespace
+
+HugePagePolicy get_huge_page_policy(const std::string &policy)
+{
+    if (policy == "none")
+        return HugePagePolicy::None;
+    if (policy == "thp")
+        return HugePagePolicy::Transparent;
+    if (policy == "2mb")
+        return HugePagePolicy::Explicit2MB;
+    if (policy == "1gb")
+        return HugePagePolicy::Explicit1GB;
+    throw ANNException("Unknown huge page policy " + policy + ", expected none, thp, 2mb or 1gb", -1, __FUNCSIG__,
+                       __FILE__, __LINE__);
+}
+
+void *huge_page_alloc(const size_t size, const size_t alignment, const HugePagePolicy requested_policy)
+{
+#ifndef _WINDOWS
+    const HugePagePolicy policy = effective_policy(size, requested_policy);
+    if (policy != HugePagePolicy::None)
+    {
+        const size_t length = ROUND_UP(size, huge_page_size(policy));
+        if (policy == HugePagePolicy::Explicit2MB || policy == HugePagePolicy::Explicit1GB)
+        {
+            static std::atomic<bool> warned{false};
+            const int page_shift = policy == HugePagePolicy::Explicit1GB ? 30 : 21;
+            void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT), -1, 0);
+            if (ptr != MAP_FAILED)
+                return ptr;
+            warn_once(warned, "Not enough free hugetlbfs pages (see /proc/sys/vm/nr_hugepages), "
+                              "falling back to transparent huge pages");
+        }
+        // the mapping is length bytes either way, so huge_page_free needs only
+        // the size and policy
+        return map_transparent(length);
+    }
+#endif
+    void *ptr;
+    alloc_aligned(&ptr, size, alignment);
+    return ptr;
+}
+
+void huge_page_free(void *ptr, const size_t size, const HugePagePolicy requested_policy)
+{
+    if (ptr == nullptr)
+        return;
+#ifndef _WINDOWS
+    const HugePagePolicy policy = effective_policy(size, requested_policy);
+    if (policy != HugePagePolicy::None)
+    {
+        munmap(ptr, ROUND_UP(size, huge_page_size(policy)));
+        return;
+    }
+#endif
+    aligned_free(ptr);
+}
+} // namespace diskann
@@ -11,20 +11,18 @@ namespace diskann
 
 template <typename data_t>
 InMemDataStore<data_t>::InMemDataStore(const location_t num_points, const size_t dim,
-                                       std::unique_ptr<Distance<data_t>> distance_fn)
-    : AbstractDataStore<data_t>(num_points, dim), _distance_fn(std::move(distance_fn))
+                                       std::unique_ptr<Distance<data_t>> distance_fn, const HugePagePolicy huge_pages)
+    : AbstractDataStore<data_t>(num_points, dim), _huge_pages(huge_pages), _distance_fn(std::move(distance_fn))
 {
     _aligned_dim = ROUND_UP(dim, _distance_fn->get_required_alignment());
-    alloc_aligned(((void **)&_data), this->_capacity * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
+    _data = (data_t *)huge_page_alloc(this->_capacity * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t),
+                                      _huge_pages);
     std::memset(_data, 0, this->_capacity * _aligned_dim * sizeof(data_t));
 }
 
 template <typename data_t> InMemDataStore<data_t>::~InMemDataStore()
 {
-    if (_data != nullptr)
-    {
-        aligned_free(this->_data);
-    }
+    huge_page_free(this->_data, this->_capacity * _aligned_dim * sizeof(data_t), _huge_pages);
 }
 
 template <typename data_t> size_t InMemDataStore<data_t>::get_aligned_dim() const
@@ -55,7 +53,8 @@ template <typename data_t> location_t InMemDataStore<data_t>::load_impl(AlignedF
         stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
                << "but file has " << file_dim << " dimension." << std::endl;
         diskann::cerr << stream.str() << std::endl;
-        aligned_free(_data);
+        huge_page_free(_data, this->_capacity * _aligned_dim * sizeof(data_t), _huge_pages);
+        _data = nullptr;
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
@@ -77,7 +76,8 @@ template <typename data_t> location_t InMemDataStore<data_t>::load_impl(const st
         std::stringstream stream;
         stream << "ERROR: data file " << filename << " does not exist." << std::endl;
         diskann::cerr << stream.str() << std::endl;
-        aligned_free(_data);
+        huge_page_free(_data, this->_capacity * _aligned_dim * sizeof(data_t), _huge_pages);
+        _data = nullptr;
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
     diskann::get_bin_metadata(filename, file_num_points, file_dim);
@@ -88,7 +88,8 @@ template <typename data_t> location_t InMemDataStore<data_t>::load_impl(const st
         stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
                << "but file has " << file_dim << " dimension." << std::endl;
         diskann::cerr << stream.str() << std::endl;
-        aligned_free(_data);
+        huge_page_free(_data, this->_capacity * _aligned_dim * sizeof(data_t), _huge_pages);
+        _data = nullptr;
         throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
@@ -212,10 +213,10 @@ template <typename data_t> location_t InMemDataStore<data_t>::expand(const locat
         throw diskann::ANNException(ss.str(), -1);
     }
 #ifndef _WINDOWS
-    data_t *new_data;
-    alloc_aligned((void **)&new_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
+    data_t *new_data =
+        (data_t *)huge_page_alloc(new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t), _huge_pages);
     memcpy(new_data, _data, this->capacity() * _aligned_dim * sizeof(data_t));
-    aligned_free(_data);
+    huge_page_free(_data, this->capacity() * _aligned_dim * sizeof(data_t), _huge_pages);
     _data = new_data;
 #else
     realloc_aligned((void **)&_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
@@ -238,10 +239,10 @@ template <typename data_t> location_t InMemDataStore<data_t>::shrink(const locat
         throw diskann::ANNException(ss.str(), -1);
     }
 #ifndef _WINDOWS
-    data_t *new_data;
-    alloc_aligned((void **)&new_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
+    data_t *new_data =
+        (data_t *)huge_page_alloc(new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t), _huge_pages);
     memcpy(new_data, _data, new_size * _aligned_dim * sizeof(data_t));
-    aligned_free(_data);
+    huge_page_free(_data, this->capacity() * _aligned_dim * sizeof(data_t), _huge_pages);
     _data = new_data;
 #else
     realloc_aligned((void **)&_data, new_size * _aligned_dim * sizeof(data_t), 8 * sizeof(data_t));
@@ -250,6 +251,13 @@ template <typename data_t> location_t InMemDataStore<data_t>::shrink(const locat
     return this->_capacity;
 }
 
+template <typename data_t> void InMemDataStore<data_t>::release_vectors()
+{
+    huge_page_free(_data, this->_capacity * _aligned_dim * sizeof(data_t), _huge_pages);
+    _data = nullptr;
+    this->_capacity = 0;
+}
+
 template <typename data_t>
 void InMemDataStore<data_t>::move_vectors(const location_t old_location_start, const location_t new_location_start,
                                           const location_t num_locations)
@@ -0,0 +1,527 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <immintrin.h>
+#include <limits>
+#include <memory>
+#include "in_mem_sq_data_store.h"
+#include "sq_distance.h"
+
+#include "utils.h"
+
+namespace diskann
+{
+
+namespace
+{
+// Rows are converted and encoded in blocks of roughly this many bytes of
+// float data to bound the temporary memory used while training.
+const size_t SQ_ENCODE_BLOCK_BYTES = 64 * 1024 * 1024;
+} // namespace
+
+template <typename data_t>
+InMemSQDataStore<data_t>::InMemSQDataStore(const location_t num_points, const size_t dim,
+                                           std::unique_ptr<Distance<data_t>> distance_fn, const uint32_t num_bits,
+                                           const HugePagePolicy huge_pages)
+    : AbstractDataStore<data_t>(num_points, dim), _huge_pages(huge_pages), _num_bits(num_bits),
+      _distance_fn(std::move(distance_fn))
+{
+    if (_num_bits != 8 && _num_bits != 4)
+    {
+        std::stringstream stream;
+        stream << "ERROR: scalar quantization supports 8 or 4 bits per dimension, got " << _num_bits << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _metric = _distance_fn->get_metric();
+    _num_levels = (1u << _num_bits) - 1;
+    _aligned_dim = ROUND_UP(dim, std::max<size_t>(16, _distance_fn->get_required_alignment()));
+    _code_size = _aligned_dim * _num_bits / 8;
+
+    _codes = (uint8_t *)huge_page_alloc(codes_bytes(this->_capacity), 64, _huge_pages);
+    std::memset(_codes, 0, codes_bytes(this->_capacity));
+
+    alloc_aligned(((void **)&_vmin), _aligned_dim * sizeof(float), 8 * sizeof(float));
+    alloc_aligned(((void **)&_delta), _aligned_dim * sizeof(float), 8 * sizeof(float));
+    std::memset(_vmin, 0, _aligned_dim * sizeof(float));
+    std::memset(_delta, 0, _aligned_dim * sizeof(float));
+}
+
+template <typename data_t> size_t InMemSQDataStore<data_t>::codes_bytes(const location_t num_pts) const
+{
+    // aligned allocations must be a multiple of the alignment, which 4-bit
+    // codes of an odd number of points are not
+    return ROUND_UP((size_t)num_pts * _code_size, 64);
+}
+
+template <typename data_t> InMemSQDataStore<data_t>::~InMemSQDataStore()
+{
+    huge_page_free(_codes, codes_bytes(this->_capacity), _huge_pages);
+    if (_vmin != nullptr)
+        aligned_free(_vmin);
+    if (_delta != nullptr)
+        aligned_free(_delta);
+}
+
+template <typename data_t> size_t InMemSQDataStore<data_t>::get_aligned_dim() const
+{
+    return _aligned_dim;
+}
+
+template <typename data_t> size_t InMemSQDataStore<data_t>::get_alignment_factor() const
+{
+    return _distance_fn->get_required_alignment();
+}
+
+template <typename data_t> uint32_t InMemSQDataStore<data_t>::get_num_bits() const
+{
+    return _num_bits;
+}
+
+template <typename data_t> location_t InMemSQDataStore<data_t>::load(const std::string &filename)
+{
+    if (!file_exists(filename))
+    {
+        std::stringstream stream;
+        stream << "ERROR: data file " << filename << " does not exist." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    return populate_from_file(filename, 0);
+}
+
+template <typename data_t>
+location_t InMemSQDataStore<data_t>::populate_from_file(const std::string &filename, const size_t offset)
+{
+    std::ifstream reader;
+    reader.exceptions(std::ios::badbit | std::ios::failbit);
+    reader.open(filename, std::ios::binary);
+    reader.seekg(offset, reader.beg);
+
+    int npts_i32, dim_i32;
+    reader.read((char *)&npts_i32, sizeof(int));
+    reader.read((char *)&dim_i32, sizeof(int));
+    const size_t file_num_points = (size_t)npts_i32;
+
+    if ((size_t)dim_i32 != this->_dim)
+    {
+        std::stringstream stream;
+        stream << "ERROR: Driver requests loading " << this->_dim << " dimension,"
+               << "but file has " << dim_i32 << " dimension." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    if (file_num_points > this->capacity())
+    {
+        this->resize((location_t)file_num_points);
+    }
+
+    const size_t block_size = std::max<size_t>(1, SQ_ENCODE_BLOCK_BYTES / (_aligned_dim * sizeof(float)));
+    std::vector<data_t> raw(block_size * this->_dim);
+    std::vector<float> buffer(block_size * _aligned_dim);
+    const std::streampos data_start = reader.tellg();
+
+    // Two passes over the file: ranges first, then codes.
+    reset_ranges();
+    for (size_t start = 0; start < file_num_points; start += block_size)
+    {
+        const size_t cur = std::min(block_size, file_num_points - start);
+        reader.read((char *)raw.data(), cur * this->_dim * sizeof(data_t));
+        prepare_batch(raw.data(), cur, buffer.data());
+        update_ranges(buffer.data(), cur);
+    }
+    finalize_ranges();
+
+    reader.seekg(data_start);
+    for (size_t start = 0; start < file_num_points; start += block_size)
+    {
+        const size_t cur = std::min(block_size, file_num_points - start);
+        reader.read((char *)raw.data(), cur * this->_dim * sizeof(data_t));
+        prepare_batch(raw.data(), cur, buffer.data());
+        for (size_t i = 0; i < cur; i++)
+            encode(buffer.data() + i * _aligned_dim, _codes + (start + i) * _code_size);
+    }
+
+    diskann::cout << "Scalar quantized " << file_num_points << " vectors to " << _num_bits << " bits per dimension"
+                  << std::endl;
+    return (location_t)file_num_points;
+}
+
+template <typename data_t>
+void InMemSQDataStore<data_t>::prepare_batch(const data_t *vectors, const size_t num_pts, float *buffer)
+{
+    std::memset(buffer, 0, num_pts * _aligned_dim * sizeof(float));
+    for (size_t i = 0; i < num_pts; i++)
+    {
+        for (size_t d = 0; d < this->_dim; d++)
+            buffer[i * _aligned_dim + d] = (float)vectors[i * this->_dim + d];
+    }
+    if (_distance_fn->preprocessing_required())
+    {
+        // only float data stores are constructed for scalar quantization
+        _distance_fn->preprocess_base_points((data_t *)buffer, _aligned_dim, num_pts);
+    }
+}
+
+// While training, _delta holds the running per-dimension maximum;
+// finalize_ranges() turns it into the quantization step.
+template <typename data_t> void InMemSQDataStore<data_t>::reset_ranges()
+{
+    for (size_t d = 0; d < this->_dim; d++)
+    {
+        _vmin[d] = std::numeric_limits<float>::max();
+        _delta[d] = std::numeric_limits<float>::lowest();
+    }
+    _trained = false;
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::update_ranges(const float *vectors, const size_t num_pts)
+{
+    for (size_t i = 0; i < num_pts; i++)
+    {
+        const float *vec = vectors + i * _aligned_dim;
+        for (size_t d = 0; d < this->_dim; d++)
+        {
+            _vmin[d] = std::min(_vmin[d], vec[d]);
+            _delta[d] = std::max(_delta[d], vec[d]);
+        }
+    }
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::finalize_ranges()
+{
+    for (size_t d = 0; d < this->_dim; d++)
+    {
+        if (_delta[d] < _vmin[d])
+        {
+            // no points seen
+            _vmin[d] = 0;
+            _delta[d] = 0;
+        }
+        else
+        {
+            _delta[d] = (_delta[d] - _vmin[d]) / (float)_num_levels;
+        }
+    }
+    _trained = true;
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::encode(const float *vector, uint8_t *code) const
+{
+    std::memset(code, 0, _code_size);
+    for (size_t d = 0; d < this->_dim; d++)
+    {
+        uint32_t q = 0;
+        if (_delta[d] > 0)
+        {
+            float level = std::round((vector[d] - _vmin[d]) / _delta[d]);
+            q = (uint32_t)std::min<float>(std::max<float>(level, 0.0f), (float)_num_levels);
+        }
+        if (_num_bits == 8)
+        {
+            code[d] = (uint8_t)q;
+        }
+        else
+        {
+            const size_t j = d & 15;
+            code[(d >> 4) * 8 + (j & 7)] |= (uint8_t)(j < 8 ? q : (q << 4));
+        }
+    }
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::decode(const uint8_t *code, float *vector) const
+{
+    for (size_t d = 0; d < _aligned_dim; d++)
+        vector[d] = _vmin[d] + (float)sq_code_at(code, _num_bits, d) * _delta[d];
+}
+
+template <typename data_t> size_t InMemSQDataStore<data_t>::save(const std::string &filename, const location_t)
+{
+    // de-quantized vectors in the .data format would silently replace the
+    // full precision vectors the codes were trained from
+    throw diskann::ANNException("ERROR: a scalar quantized data store cannot be saved to " + filename +
+                                    ", build and save the index with a full precision data store",
+                                -1, __FUNCSIG__, __FILE__, __LINE__);
+}
+
+template <typename data_t>
+void InMemSQDataStore<data_t>::populate_data(const data_t *vectors, const location_t num_pts)
+{
+    const size_t block_size = std::max<size_t>(1, SQ_ENCODE_BLOCK_BYTES / (_aligned_dim * sizeof(float)));
+    std::vector<float> buffer(block_size * _aligned_dim);
+
+    reset_ranges();
+    for (size_t start = 0; start < num_pts; start += block_size)
+    {
+        const size_t cur = std::min(block_size, (size_t)num_pts - start);
+        prepare_batch(vectors + start * this->_dim, cur, buffer.data());
+        update_ranges(buffer.data(), cur);
+    }
+    finalize_ranges();
+
+    for (size_t start = 0; start < num_pts; start += block_size)
+    {
+        const size_t cur = std::min(block_size, (size_t)num_pts - start);
+        prepare_batch(vectors + start * this->_dim, cur, buffer.data());
+        for (size_t i = 0; i < cur; i++)
+            encode(buffer.data() + i * _aligned_dim, _codes + (start + i) * _code_size);
+    }
+}
+
+template <typename data_t>
+void InMemSQDataStore<data_t>::populate_data(const std::string &filename, const size_t offset)
+{
+    size_t npts, ndim;
+    diskann::get_bin_metadata(filename, npts, ndim, offset);
+    if ((location_t)npts > this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Number of points in the file: " << filename
+           << " is greater than the capacity of data store: " << this->capacity()
+           << ". Must invoke resize before calling populate_data()" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    populate_from_file(filename, offset);
+}
+
+template <typename data_t>
+void InMemSQDataStore<data_t>::extract_data_to_bin(const std::string &filename, const location_t num_points)
+{
+    save(filename, num_points);
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::get_vector(const location_t i, data_t *dest) const
+{
+    std::vector<float> vec(_aligned_dim);
+    decode(_codes + (size_t)i * _code_size, vec.data());
+    for (size_t d = 0; d < this->_dim; d++)
+        dest[d] = (data_t)vec[d];
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::set_vector(const location_t loc, const data_t *const vector)
+{
+    if (!_trained)
+    {
+        throw diskann::ANNException("ERROR: populate or load the scalar quantized data store before setting vectors",
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    std::vector<float> buffer(_aligned_dim);
+    prepare_batch(vector, 1, buffer.data());
+    encode(buffer.data(), _codes + (size_t)loc * _code_size);
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::prefetch_vector(const location_t loc)
+{
+    diskann::prefetch_vector((const char *)_codes + _code_size * (size_t)loc, _code_size);
+}
+
+template <typename data_t> float InMemSQDataStore<data_t>::to_distance(const float raw) const
+{
+    // Matches the conventions of the float distance functions the store is
+    // constructed with: L2 is squared distance, inner product is negated and
+    // normalized cosine is 1 - <q, x>.
+    switch (_metric)
+    {
+    case diskann::Metric::INNER_PRODUCT:
+        return -raw;
+    case diskann::Metric::COSINE:
+        return 1.0f - raw;
+    default:
+        return raw;
+    }
+}
+
+template <typename data_t>
+float InMemSQDataStore<data_t>::asymmetric_distance(const float *query, const uint8_t *code) const
+{
+    const bool ip = _metric == diskann::Metric::INNER_PRODUCT || _metric == diskann::Metric::COSINE;
+    float raw;
+#ifdef USE_AVX2
+    if (_num_bits == 8)
+        raw = ip ? sq8_distance_avx2<true>(query, code, _vmin, _delta, _aligned_dim)
+                 : sq8_distance_avx2<false>(query, code, _vmin, _delta, _aligned_dim);
+    else
+        raw = ip ? sq4_distance_avx2<true>(query, code, _vmin, _delta, _aligned_dim)
+                 : sq4_distance_avx2<false>(query, code, _vmin, _delta, _aligned_dim);
+#else
+    raw = ip ? sq_distance_scalar<true>(query, code, _num_bits, _vmin, _delta, _aligned_dim)
+             : sq_distance_scalar<false>(query, code, _num_bits, _vmin, _delta, _aligned_dim);
+#endif
+    return to_distance(raw);
+}
+
+template <typename data_t> float InMemSQDataStore<data_t>::get_distance(const data_t *query, const location_t loc) const
+{
+    return asymmetric_distance((const float *)query, _codes + _code_size * (size_t)loc);
+}
+
+template <typename data_t>
+void InMemSQDataStore<data_t>::get_distance(const data_t *query, const location_t *locations,
+                                            const uint32_t location_count, float *distances) const
+{
+    for (location_t i = 0; i < location_count; i++)
+    {
+        if (i + 1 < location_count)
+            diskann::prefetch_vector((const char *)_codes + _code_size * (size_t)locations[i + 1], _code_size);
+        distances[i] = asymmetric_distance((const float *)query, _codes + _code_size * (size_t)locations[i]);
+    }
+}
+
+template <typename data_t>
+float InMemSQDataStore<data_t>::get_distance(const location_t loc1, const location_t loc2) const
+{
+    // Symmetric case (graph pruning): reconstruct on the fly.
+    const uint8_t *code1 = _codes + _code_size * (size_t)loc1;
+    const uint8_t *code2 = _codes + _code_size * (size_t)loc2;
+    const bool ip = _metric == diskann::Metric::INNER_PRODUCT || _metric == diskann::Metric::COSINE;
+    float raw = 0;
+    for (size_t d = 0; d < this->_dim; d++)
+    {
+        const float c1 = (float)sq_code_at(code1, _num_bits, d);
+        const float c2 = (float)sq_code_at(code2, _num_bits, d);
+        if (ip)
+        {
+            raw += (_vmin[d] + c1 * _delta[d]) * (_vmin[d] + c2 * _delta[d]);
+        }
+        else
+        {
+            const float diff = (c1 - c2) * _delta[d];
+            raw += diff * diff;
+        }
+    }
+    return to_distance(raw);
+}
+
+template <typename data_t> location_t InMemSQDataStore<data_t>::expand(const location_t new_size)
+{
+    if (new_size == this->capacity())
+    {
+        return this->capacity();
+    }
+    else if (new_size < this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Cannot 'expand' datastore when new capacity (" << new_size << ") < existing capacity("
+           << this->capacity() << ")" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    uint8_t *new_codes = (uint8_t *)huge_page_alloc(codes_bytes(new_size), 64, _huge_pages);
+    memcpy(new_codes, _codes, (size_t)this->capacity() * _code_size);
+    memset(new_codes + (size_t)this->capacity() * _code_size, 0, (size_t)(new_size - this->capacity()) * _code_size);
+    huge_page_free(_codes, codes_bytes(this->capacity()), _huge_pages);
+    _codes = new_codes;
+    this->_capacity = new_size;
+    return this->_capacity;
+}
+
+template <typename data_t> location_t InMemSQDataStore<data_t>::shrink(const location_t new_size)
+{
+    if (new_size == this->capacity())
+    {
+        return this->capacity();
+    }
+    else if (new_size > this->capacity())
+    {
+        std::stringstream ss;
+        ss << "Cannot 'shrink' datastore when new capacity (" << new_size << ") > existing capacity("
+           << this->capacity() << ")" << std::endl;
+        throw diskann::ANNException(ss.str(), -1);
+    }
+    uint8_t *new_codes = (uint8_t *)huge_page_alloc(codes_bytes(new_size), 64, _huge_pages);
+    memcpy(new_codes, _codes, (size_t)new_size * _code_size);
+    huge_page_free(_codes, codes_bytes(this->capacity()), _huge_pages);
+    _codes = new_codes;
+    this->_capacity = new_size;
+    return this->_capacity;
+}
+
+template <typename data_t> void InMemSQDataStore<data_t>::release_vectors()
+{
+    huge_page_free(_codes, codes_bytes(this->_capacity), _huge_pages);
+    _codes = nullptr;
+    this->_capacity = 0;
+}
+
+template <typename data_t>
+void InMemSQDataStore<data_t>::move_vectors(const location_t old_location_start, const location_t new_location_start,
+                                            const location_t num_locations)
+{
+    if (num_locations == 0 || old_location_start == new_location_start)
+    {
+        return;
+    }
+
+    // Same overlap handling as InMemDataStore::move_vectors.
+    uint32_t mem_clear_loc_start = old_location_start;
+    uint32_t mem_clear_loc_end_limit = old_location_start + num_locations;
+
+    if (new_location_start < old_location_start)
+    {
+        if (mem_clear_loc_start < new_location_start + num_locations)
+        {
+            mem_clear_loc_start = new_location_start + num_locations;
+        }
+    }
+    else
+    {
+        if (mem_clear_loc_end_limit > new_location_start)
+        {
+            mem_clear_loc_end_limit = new_location_start;
+        }
+    }
+
+    copy_vectors(old_location_start, new_location_start, num_locations);
+    memset(_codes + _code_size * mem_clear_loc_start, 0,
+           _code_size * (mem_clear_loc_end_limit - mem_clear_loc_start));
+}
+
+template <typename data_t>
+void InMemSQDataStore<data_t>::copy_vectors(const location_t from_loc, const location_t to_loc,
+                                            const location_t num_points)
+{
+    assert(from_loc < this->_capacity);
+    assert(to_loc < this->_capacity);
+    assert(num_points < this->_capacity);
+    memmove(_codes + _code_size * to_loc, _codes + _code_size * from_loc, num_points * _code_size);
+}
+
+template <typename data_t> location_t InMemSQDataStore<data_t>::calculate_medoid() const
+{
+    std::vector<float> center(_aligned_dim, 0.0f);
+    std::vector<float> vec(_aligned_dim);
+
+    for (size_t i = 0; i < this->capacity(); i++)
+    {
+        decode(_codes + i * _code_size, vec.data());
+        for (size_t j = 0; j < _aligned_dim; j++)
+            center[j] += vec[j];
+    }
+    for (size_t j = 0; j < _aligned_dim; j++)
+        center[j] /= (float)this->capacity();
+
+    uint32_t min_idx = 0;
+    float min_dist = std::numeric_limits<float>::max();
+    for (uint32_t i = 0; i < this->capacity(); i++)
+    {
+        decode(_codes + (size_t)i * _code_size, vec.data());
+        float dist = 0;
+        for (size_t j = 0; j < _aligned_dim; j++)
+            dist += (center[j] - vec[j]) * (center[j] - vec[j]);
+        if (dist < min_dist)
+        {
+            min_idx = i;
+            min_dist = dist;
+        }
+    }
+    return min_idx;
+}
+
+template <typename data_t> Distance<data_t> *InMemSQDataStore<data_t>::get_dist_fn()
+{
+    return this->_distance_fn.get();
+}
+
+// Asymmetric kernels take the query as float, so only float stores exist.
+template DISKANN_DLLEXPORT class InMemSQDataStore<float>;
+
+} // namespace diskann
@@ -7,7 +7,9 @@
 
 #include "boost/dynamic_bitset.hpp"
 #include "index_factory.h"
+#include "instrumentation.h"
 #include "memory_mapper.h"
+#include "pq_fast_scan.h"
 #include "timer.h"
 #include "tsl/robin_map.h"
 #include "tsl/robin_set.h"
@@ -34,6 +36,9 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::unique_ptr<A
       _num_frozen_pts(index_config.num_frozen_pts), _dynamic_index(index_config.dynamic_index),
       _enable_tags(index_config.enable_tags), _indexingMaxC(DEFAULT_MAXC), _query_scratch(nullptr),
       _pq_dist(index_config.pq_dist_build), _use_opq(index_config.use_opq), _num_pq_chunks(index_config.num_pq_chunks),
+      _pq_search(index_config.pq_dist_search), _pq_fast_scan(index_config.pq_fast_scan),
+      _mmap_full_vectors(index_config.mmap_full_vectors),
+      _rerank_full_precision(index_config.pq_dist_search || index_config.mmap_full_vectors),
       _delete_set(new tsl::robin_set<uint32_t>), _conc_consolidate(index_config.concurrent_consolidate)
 {
     if (_dynamic_index && !_enable_tags)
@@ -41,11 +46,11 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::unique_ptr<A
         throw ANNException("ERROR: Dynamic Indexing must have tags enabled.", -1, __FUNCSIG__, __FILE__, __LINE__);
     }
 
-    if (_pq_dist)
+    if (_pq_dist || _pq_search)
     {
         if (_dynamic_index)
             throw ANNException("ERROR: Dynamic Indexing not supported with PQ distance based "
-                               "index construction",
+                               "index construction or search",
                                -1, __FUNCSIG__, __FILE__, __LINE__);
         if (_dist_metric == diskann::Metric::INNER_PRODUCT)
             throw ANNException("ERROR: Inner product metrics not yet supported "
@@ -59,6 +64,9 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::unique_ptr<A
         this->_normalize_vecs = true;
     }
 
+    _huge_pages = index_config.huge_pages;
+    _pts_to_label_signature = decltype(_pts_to_label_signature)(HugePageAllocator<uint64_t>(_huge_pages));
+
     if (_dynamic_index && _num_frozen_pts == 0)
     {
         _num_frozen_pts = 1;
@@ -70,6 +78,8 @@ Index<T, TagT, LabelT>::Index(const IndexConfig &index_config, std::unique_ptr<A
         _max_points = 1;
     }
     const size_t total_internal_points = _max_points + _num_frozen_pts;
+    if (_pq_search && _num_pq_chunks > _dim)
+        throw diskann::ANNException("ERROR: num_pq_chunks > dim", -1, __FUNCSIG__, __FILE__, __LINE__);
     if (_pq_dist)
     {
         if (_num_pq_chunks > _dim)
@@ -244,9 +254,19 @@ template <typename T, typename TagT, typename LabelT> Index<T, TagT, LabelT>::~I
         LockGuard lg(lock);
     }
 
-    if (_opt_graph != nullptr)
+    huge_page_free(_opt_graph, _opt_graph_size, _huge_pages);
+
+    if (_filter_entry_point_data != nullptr)
+    {
+        aligned_free(_filter_entry_point_data);
+        _filter_entry_point_data = nullptr;
+    }
+
+    // _pq_data of a PQ build is owned by the build path, search data by load()
+    if (_pq_search && _pq_data != nullptr)
     {
-        delete[] _opt_graph;
+        aligned_free(_pq_data);
+        _pq_data = nullptr;
     }
 
     if (!_query_scratch.empty())
@@ -263,7 +283,8 @@ void Index<T, TagT, LabelT>::initialize_query_scratch(uint32_t num_threads, uint
     for (uint32_t i = 0; i < num_threads; i++)
     {
         auto scratch = new InMemQueryScratch<T>(search_l, indexing_l, r, maxc, dim, _data_store->get_aligned_dim(),
-                                                _data_store->get_alignment_factor(), _pq_dist);
+                                                _data_store->get_alignment_factor(),
+                                                _pq_dist || _rerank_full_precision);
         _query_scratch.push(scratch);
     }
 }
@@ -615,7 +636,12 @@ void Index<T, TagT, LabelT>::load(const char *filename, uint32_t num_threads, ui
         std::string tags_file = std::string(filename) + ".tags";
         std::string delete_set_file = std::string(filename) + ".del";
         std::string graph_file = std::string(filename);
-        data_file_num_pts = load_data(data_file);
+        if (_pq_search && _mmap_full_vectors)
+            data_file_num_pts = map_full_vectors(data_file);
+        else
+            data_file_num_pts = load_data(data_file);
+        if (!_pq_search && _mmap_full_vectors)
+            map_full_vectors(data_file);
         if (file_exists(delete_set_file))
         {
             load_delete_set(delete_set_file);
@@ -625,6 +651,10 @@ void Index<T, TagT, LabelT>::load(const char *filename, uint32_t num_threads, ui
             tags_file_num_pts = load_tags(tags_file);
         }
         graph_num_pts = load_graph(graph_file, data_file_num_pts);
+        if (_pq_search)
+        {
+            load_pq_search_data(mem_index_file, data_file_num_pts);
+        }
 #endif
     }
     else
@@ -683,6 +713,7 @@ void Index<T, TagT, LabelT>::load(const char *filename, uint32_t num_threads, ui
                 // _label_to_medoid_id[label] = medoid;
                 line_cnt++;
             }
+            build_filter_entry_points();
         }
 
         std::string universal_label_file(filename);
@@ -929,6 +960,7 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
     const T *query, const uint32_t Lsize, const std::vector<uint32_t> &init_ids, InMemQueryScratch<T> *scratch,
     bool use_filter, const std::vector<LabelT> &filter_label, bool search_invocation, uint32_t location)
 {
+    DISKANN_PROBE_SCOPE(IterateToFixedPoint);
     std::vector<Neighbor> &expanded_nodes = scratch->pool();
     NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
     best_L_nodes.reserve(Lsize);
@@ -944,6 +976,8 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
     float *query_rotated = nullptr;
     float *pq_dists = nullptr;
     uint8_t *pq_coord_scratch = nullptr;
+    uint8_t *fast_scan_lut = nullptr;
+    float fast_scan_scale = 1.0f, fast_scan_bias = 0;
     // Intialize PQ related scratch to use PQ based distances
     if (_pq_dist)
     {
@@ -965,6 +999,9 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
         _pq_table.populate_chunk_distances(query_rotated, pq_dists);
 
         pq_coord_scratch = pq_query_scratch->aligned_pq_coord_scratch;
+        fast_scan_lut = pq_query_scratch->aligned_fast_scan_lut;
+        if (_pq_fast_scan)
+            quantize_fast_scan_lut(pq_dists, _num_pq_chunks, fast_scan_lut, fast_scan_scale, fast_scan_bias);
     }
 
     if (expanded_nodes.size() > 0 || id_scratch.size() > 0)
@@ -994,8 +1031,17 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
     };
 
     // Lambda to batch compute query<-> node distances in PQ space
-    auto compute_dists = [this, pq_coord_scratch, pq_dists](const std::vector<uint32_t> &ids,
-                                                            std::vector<float> &dists_out) {
+    auto compute_dists = [this, pq_coord_scratch, pq_dists, fast_scan_lut, fast_scan_scale,
+                          fast_scan_bias](const std::vector<uint32_t> &ids, std::vector<float> &dists_out) {
+        if (_pq_fast_scan)
+        {
+            dists_out.resize(ids.size());
+            diskann::aggregate_fast_scan_codes(ids.data(), ids.size(), this->_pq_data, this->_num_pq_chunks,
+                                               pq_coord_scratch);
+            diskann::fast_scan_dist_lookup(pq_coord_scratch, ids.size(), this->_num_pq_chunks, fast_scan_lut,
+                                           fast_scan_scale, fast_scan_bias, dists_out.data());
+            return;
+        }
         diskann::aggregate_coords(ids, this->_pq_data, this->_num_pq_chunks, pq_coord_scratch);
         diskann::pq_dist_lookup(pq_coord_scratch, ids.size(), this->_num_pq_chunks, pq_dists, dists_out);
     };
@@ -1028,8 +1074,15 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
             }
 
             float distance;
-            if (_pq_dist)
+            if (_pq_dist && _pq_fast_scan)
+            {
+                aggregate_fast_scan_codes(&id, 1, this->_pq_data, this->_num_pq_chunks, pq_coord_scratch);
+                fast_scan_dist_lookup(pq_coord_scratch, 1, this->_num_pq_chunks, fast_scan_lut, fast_scan_scale,
+                                      fast_scan_bias, &distance);
+            }
+            else if (_pq_dist)
             {
+                aggregate_coords(&id, 1, this->_pq_data, this->_num_pq_chunks, pq_coord_scratch);
                 pq_dist_lookup(pq_coord_scratch, 1, this->_num_pq_chunks, pq_dists, &distance);
             }
             else
@@ -1049,6 +1102,13 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
         auto nbr = best_L_nodes.closest_unexpanded();
         auto n = nbr.id;
         if (n==location) continue;
+        hops++;
+
+        // The next node to expand is most likely the current runner-up, fetch
+        // its adjacency list while this node's neighbors are evaluated. Skipped
+        // for dynamic indices, whose lists may be resized under their locks.
+        if (_prefetch_distance > 0 && !_dynamic_index && best_L_nodes.has_unexpanded_node())
+            prefetch_neighbours(best_L_nodes.peek_closest_unexpanded().id);
 
         // Add node to expanded nodes to create pool for prune later
         if (!search_invocation)
@@ -1074,12 +1134,15 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
         {
             if (_dynamic_index)
                 _locks[n].lock();
-            for (auto id : _graph_store->get_neighbours(n))
+            const auto &neighbours = _graph_store->get_neighbours(n);
+            for (size_t j = 0; j < neighbours.size(); j++)
             {
+                const uint32_t id = neighbours[j];
                 assert(id < _max_points + _num_frozen_pts);
 
                 if (use_filter)
                 {
+                    prefetch_labels_ahead(neighbours.data(), neighbours.size(), j);
                     // NOTE: NEED TO CHECK IF THIS CORRECT WITH NEW LOCKS.
                     if (!detect_common_filters(id, search_invocation, filter_label))
                         continue;
@@ -1121,11 +1184,7 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
             {
                 uint32_t id = id_scratch[m];
 
-                if (m + 1 < id_scratch.size())
-                {
-                    auto nextn = id_scratch[m + 1];
-                    _data_store->prefetch_vector(nextn);
-                }
+                prefetch_vectors_ahead(id_scratch.data(), id_scratch.size(), m);
 
                 dist_scratch.push_back(_data_store->get_distance(aligned_query, id));
             }
@@ -1138,14 +1197,18 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point(
             best_L_nodes.insert(Neighbor(id_scratch[m], dist_scratch[m]));
         }
     }
+    DISKANN_PROBE_COUNT(Hops, hops);
+    DISKANN_PROBE_COUNT(DistanceCmps, cmps);
     return std::make_pair(hops, cmps);
 }
 
 template <typename T, typename TagT, typename LabelT>
 std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
     const T *query, const uint32_t Lsize, const std::vector<uint32_t> &init_ids, InMemQueryScratch<T> *scratch,
-    bool use_filter, const std::vector<LabelT> &filter_label, bool search_invocation, uint32_t location, uint32_t K)
+    bool use_filter, const std::vector<LabelT> &filter_label, bool search_invocation, uint32_t location, uint32_t K,
+    QueryStats *stats)
 {
+    DISKANN_PROBE_SCOPE(IterateToFixedPointV2);
     assert(use_filter);
     std::vector<Neighbor> &expanded_nodes = scratch->pool();
     NeighborPriorityQueue &final_result = scratch->best_l_nodes();
@@ -1156,14 +1219,20 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
     std::vector<uint32_t> &id_scratch = scratch->id_scratch();
     std::vector<float> &dist_scratch = scratch->dist_scratch();
     std::vector<uint32_t> commmon_filter_size_scratch;
+    std::vector<uint32_t> candidate_scratch;
+    std::vector<uint8_t> label_hit_scratch;
     assert(id_scratch.size() == 0);
 
+    const LabelSignaturePredicate label_predicate = prepare_label_predicate(search_invocation, filter_label);
+
     T *aligned_query = scratch->aligned_query();
 
     float *query_float = nullptr;
     float *query_rotated = nullptr;
     float *pq_dists = nullptr;
     uint8_t *pq_coord_scratch = nullptr;
+    uint8_t *fast_scan_lut = nullptr;
+    float fast_scan_scale = 1.0f, fast_scan_bias = 0;
     // Intialize PQ related scratch to use PQ based distances
     if (_pq_dist)
     {
@@ -1185,6 +1254,9 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
         _pq_table.populate_chunk_distances(query_rotated, pq_dists);
 
         pq_coord_scratch = pq_query_scratch->aligned_pq_coord_scratch;
+        fast_scan_lut = pq_query_scratch->aligned_fast_scan_lut;
+        if (_pq_fast_scan)
+            quantize_fast_scan_lut(pq_dists, _num_pq_chunks, fast_scan_lut, fast_scan_scale, fast_scan_bias);
     }
 
     if (expanded_nodes.size() > 0 || id_scratch.size() > 0)
@@ -1214,12 +1286,24 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
     };
 
     // Lambda to batch compute query<-> node distances in PQ space
-    auto compute_dists = [this, pq_coord_scratch, pq_dists](const std::vector<uint32_t> &ids,
-                                                            std::vector<float> &dists_out) {
+    auto compute_dists = [this, pq_coord_scratch, pq_dists, fast_scan_lut, fast_scan_scale,
+                          fast_scan_bias](const std::vector<uint32_t> &ids, std::vector<float> &dists_out) {
+        if (_pq_fast_scan)
+        {
+            dists_out.resize(ids.size());
+            diskann::aggregate_fast_scan_codes(ids.data(), ids.size(), this->_pq_data, this->_num_pq_chunks,
+                                               pq_coord_scratch);
+            diskann::fast_scan_dist_lookup(pq_coord_scratch, ids.size(), this->_num_pq_chunks, fast_scan_lut,
+                                           fast_scan_scale, fast_scan_bias, dists_out.data());
+            return;
+        }
         diskann::aggregate_coords(ids, this->_pq_data, this->_num_pq_chunks, pq_coord_scratch);
         diskann::pq_dist_lookup(pq_coord_scratch, ids.size(), this->_num_pq_chunks, pq_dists, dists_out);
     };
 
+    // only read when stats are requested
+    Timer phase_timer;
+
     // Initialize the candidate pool with starting points
     for (auto id : init_ids)
     {
@@ -1232,8 +1316,14 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
 
         if (use_filter)
         {
+            if (stats != nullptr)
+                stats->n_filter_checks++;
             if (!detect_common_filters(id, search_invocation, filter_label))
+            {
+                if (stats != nullptr)
+                    stats->n_filter_rejects++;
                 continue;
+            }
         }
 
         if (is_not_visited(id))
@@ -1248,8 +1338,15 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
             }
 
             float distance;
-            if (_pq_dist)
+            if (_pq_dist && _pq_fast_scan)
+            {
+                aggregate_fast_scan_codes(&id, 1, this->_pq_data, this->_num_pq_chunks, pq_coord_scratch);
+                fast_scan_dist_lookup(pq_coord_scratch, 1, this->_num_pq_chunks, fast_scan_lut, fast_scan_scale,
+                                      fast_scan_bias, &distance);
+            }
+            else if (_pq_dist)
             {
+                aggregate_coords(&id, 1, this->_pq_data, this->_num_pq_chunks, pq_coord_scratch);
                 pq_dist_lookup(pq_coord_scratch, 1, this->_num_pq_chunks, pq_dists, &distance);
             }
             else
@@ -1261,6 +1358,8 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
             if (match_all_filters(id,search_invocation,filter_label)){
                 final_result.insert(nn);
             }
+            if (stats != nullptr)
+                stats->n_init_ids++;
         }
     }
 
@@ -1272,6 +1371,13 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
         auto nbr = best_L_nodes.closest_unexpanded();
         auto n = nbr.id;
         if (n==location) continue;
+        hops++;
+
+        // The next node to expand is most likely the current runner-up, fetch
+        // its adjacency list while this node's neighbors are evaluated. Skipped
+        // for dynamic indices, whose lists may be resized under their locks.
+        if (_prefetch_distance > 0 && !_dynamic_index && best_L_nodes.has_unexpanded_node())
+            prefetch_neighbours(best_L_nodes.peek_closest_unexpanded().id);
 
         // Add node to expanded nodes to create pool for prune later
         if (!search_invocation)
@@ -1298,24 +1404,36 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
         {
             if (_dynamic_index)
                 _locks[n].lock();
+            candidate_scratch.clear();
             for (auto id : _graph_store->get_neighbours(n))
             {
                 assert(id < _max_points + _num_frozen_pts);
 
-                if (is_not_visited(id) && use_filter)
+                if (is_not_visited(id))
                 {
-                    // NOTE: NEED TO CHECK IF THIS CORRECT WITH NEW LOCKS.
-                    uint32_t common_size = common_filter_size(id,search_invocation,filter_label);
-                    if (common_size == 0)
-                        continue;
-                    id_scratch.push_back(id);
-                    commmon_filter_size_scratch.push_back(common_size);
+                    candidate_scratch.push_back(id);
                 }
-                else if (is_not_visited(id))
+            }
+            if (use_filter)
+            {
+                // NOTE: NEED TO CHECK IF THIS CORRECT WITH NEW LOCKS.
+                if (stats != nullptr)
+                    phase_timer.reset();
+                filter_candidates_by_labels(candidate_scratch, search_invocation, filter_label, label_predicate,
+                                            label_hit_scratch, id_scratch, commmon_filter_size_scratch);
+                DISKANN_PROBE_COUNT(FilterChecks, candidate_scratch.size());
+                DISKANN_PROBE_COUNT(FilterRejects, candidate_scratch.size() - id_scratch.size());
+                if (stats != nullptr)
                 {
-                    id_scratch.push_back(id);
+                    stats->filter_us += phase_timer.elapsed_us();
+                    stats->n_filter_checks += (unsigned)candidate_scratch.size();
+                    stats->n_filter_rejects += (unsigned)(candidate_scratch.size() - id_scratch.size());
                 }
             }
+            else
+            {
+                id_scratch.insert(id_scratch.end(), candidate_scratch.begin(), candidate_scratch.end());
+            }
 
             if (_dynamic_index)
                 _locks[n].unlock();
@@ -1335,6 +1453,8 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
         }
 
         // Compute distances to unvisited nodes in the expansion
+        if (stats != nullptr)
+            phase_timer.reset();
         if (_pq_dist)
         {
             assert(dist_scratch.capacity() >= id_scratch.size());
@@ -1348,16 +1468,17 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
             {
                 uint32_t id = id_scratch[m];
 
-                if (m + 1 < id_scratch.size())
-                {
-                    auto nextn = id_scratch[m + 1];
-                    _data_store->prefetch_vector(nextn);
-                }
+                prefetch_vectors_ahead(id_scratch.data(), id_scratch.size(), m);
 
                 dist_scratch.push_back(_data_store->get_distance(aligned_query, id));
             }
         }
         cmps += (uint32_t)id_scratch.size();
+        if (stats != nullptr)
+        {
+            stats->dist_us += phase_timer.elapsed_us();
+            phase_timer.reset();
+        }
 
         // Insert <id, dist> pairs into the pool of candidates
         for (size_t m = 0; m < id_scratch.size(); ++m)
@@ -1371,7 +1492,11 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::iterate_to_fixed_point_v2(
                 final_result.insert(nn);
             }
         }
+        if (stats != nullptr)
+            stats->queue_us += phase_timer.elapsed_us();
     }
+    DISKANN_PROBE_COUNT(Hops, hops);
+    DISKANN_PROBE_COUNT(DistanceCmps, cmps);
     return std::make_pair(hops, cmps);
 }
 
@@ -1437,9 +1562,11 @@ void Index<T, TagT, LabelT>::occlude_list(const uint32_t location, std::vector<N
                                           InMemQueryScratch<T> *scratch,
                                           const tsl::robin_set<uint32_t> *const delete_set_ptr)
 {
+    DISKANN_PROBE_SCOPE(OccludeList);
     assert(pool.size() > 0);
     if (pool.size() == 0)
         return;
+    DISKANN_PROBE_COUNT(OccludeCandidates, pool.size());
 
     // Truncate pool at maxc and initialize scratch spaces
     assert(std::is_sorted(pool.begin(), pool.end()));
@@ -1677,7 +1804,9 @@ template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::inter_insert(uint32_t n, std::vector<uint32_t> &pruned_list, const uint32_t range,
                                           InMemQueryScratch<T> *scratch)
 {
+    DISKANN_PROBE_SCOPE(InterInsert);
     const auto &src_pool = pruned_list;
+    DISKANN_PROBE_COUNT(ReverseEdges, src_pool.size());
 
     // assert(!src_pool.empty());
 
@@ -2326,6 +2455,22 @@ LabelT Index<T, TagT, LabelT>::get_converted_label(const std::string &raw_label)
     throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
 }
 
+template <typename T, typename TagT, typename LabelT>
+bool Index<T, TagT, LabelT>::is_searchable_label(const std::string &raw_label)
+{
+    LabelT label;
+    auto iter = _label_map.find(raw_label);
+    if (iter != _label_map.end())
+        label = iter->second;
+    else if (_use_universal_label)
+        label = _universal_label;
+    else
+        return false;
+
+    std::shared_lock<std::shared_timed_mutex> lock(_update_lock);
+    return _label_to_medoid_id.find(label) != _label_to_medoid_id.end();
+}
+
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::parse_label_file(const std::string &label_file, size_t &num_points)
 {
@@ -2387,6 +2532,7 @@ void Index<T, TagT, LabelT>::parse_label_file(const std::string &label_file, siz
             }
         }
     }
+    build_label_signatures();
 }
 
 template <typename T, typename TagT, typename LabelT>
@@ -2396,6 +2542,363 @@ void Index<T, TagT, LabelT>::set_universal_label(const LabelT &label)
     _universal_label = label;
 }
 
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::set_num_filter_entry_points(uint32_t num_entry_points)
+{
+    _num_filter_entry_points = num_entry_points;
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::set_prefetch_distance(uint32_t prefetch_distance)
+{
+    _prefetch_distance = prefetch_distance;
+}
+
+template <typename T, typename TagT, typename LabelT>
+size_t Index<T, TagT, LabelT>::map_full_vectors(const std::string &data_file)
+{
+    size_t file_dim, file_num_points;
+    if (!file_exists(data_file))
+    {
+        std::stringstream stream;
+        stream << "ERROR: data file " << data_file << " does not exist." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    diskann::get_bin_metadata(data_file, file_num_points, file_dim);
+
+    _empty_slots.clear();
+
+    if (file_dim != _dim)
+    {
+        std::stringstream stream;
+        stream << "ERROR: Driver requests loading " << _dim << " dimension,"
+               << "but file has " << file_dim << " dimension." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    if (file_num_points > _max_points + _num_frozen_pts)
+    {
+        // update and tag lock acquired in load() before calling map_full_vectors
+        resize(file_num_points - _num_frozen_pts);
+    }
+
+    if (_num_frozen_pts > 0 && file_num_points != _max_points + _num_frozen_pts)
+    {
+        // reposition_frozen_point_to_end() would have to move mapped vectors
+        throw diskann::ANNException("ERROR: memory mapped vectors require frozen points at the end of the data file",
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    // With PQ search the vectors are served from the mapping, so release the
+    // data store buffer sized in the constructor/resize. A quantized data store
+    // keeps its codes for traversal. The index is read-only from here on.
+    if (_pq_search)
+        _data_store->release_vectors();
+
+    _full_vectors_mapper = std::make_unique<MemoryMapper>(data_file);
+    _full_vectors = (const T *)(_full_vectors_mapper->getBuf() + 2 * sizeof(uint32_t));
+
+    diskann::cout << "Memory mapped " << file_num_points << " full precision vectors from " << data_file << std::endl;
+    return file_num_points;
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::load_pq_search_data(const std::string &index_file, size_t num_points)
+{
+    const std::string prefix = get_pq_search_prefix(index_file, _num_pq_chunks, _use_opq, _pq_fast_scan);
+    auto pq_pivots_file = prefix + "_pivots.bin";
+    auto pq_compressed_file = prefix + "_compressed.bin";
+
+    // training PQ on load would write next to the index, possibly from
+    // several readers at once; it is a separate step (generate_pq_search_data)
+    if (!file_exists(pq_pivots_file) || !file_exists(pq_compressed_file))
+    {
+        std::stringstream stream;
+        stream << "ERROR: PQ search data " << pq_pivots_file << " or " << pq_compressed_file
+               << " not found. Generate it first, e.g. with search_multi_tag --generate_pq." << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    if (_pq_data != nullptr)
+        aligned_free(_pq_data);
+    const size_t total_internal_points = _max_points + _num_frozen_pts;
+    const size_t code_bytes = _pq_fast_scan ? pq4_code_bytes(_num_pq_chunks) : _num_pq_chunks;
+    alloc_aligned(((void **)&_pq_data), total_internal_points * code_bytes * sizeof(char), 8 * sizeof(char));
+    std::memset(_pq_data, 0, total_internal_points * code_bytes * sizeof(char));
+
+    size_t file_num_points, file_num_chunks;
+    if (_pq_fast_scan)
+    {
+        // the file keeps one 4-bit code per byte, pack them two per byte
+        uint8_t *codes = nullptr;
+        diskann::load_bin<uint8_t>(pq_compressed_file, codes, file_num_points, file_num_chunks);
+        if (file_num_points <= total_internal_points && file_num_chunks == _num_pq_chunks)
+            pack_pq4_codes(codes, file_num_points, file_num_chunks, _pq_data);
+        delete[] codes;
+    }
+    else
+    {
+        copy_aligned_data_from_file<uint8_t>(pq_compressed_file.c_str(), _pq_data, file_num_points, file_num_chunks,
+                                             _num_pq_chunks);
+    }
+    if (file_num_points != num_points || file_num_chunks != _num_pq_chunks)
+    {
+        std::stringstream stream;
+        stream << "ERROR: PQ file " << pq_compressed_file << " has " << file_num_points << " points and "
+               << file_num_chunks << " chunks, expected " << num_points << " and " << _num_pq_chunks << std::endl;
+        diskann::cerr << stream.str() << std::endl;
+        throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _pq_table.load_pq_centroid_bin(pq_pivots_file.c_str(), _num_pq_chunks);
+    if (_pq_table.get_num_centers() != (_pq_fast_scan ? NUM_PQ4_CENTROIDS : NUM_PQ_CENTROIDS))
+        throw diskann::ANNException("ERROR: PQ pivots " + pq_pivots_file + " have " +
+                                        std::to_string(_pq_table.get_num_centers()) + " centroids per chunk",
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
+
+    // iterate_to_fixed_point* switch to PQ distances on _pq_dist
+    _pq_dist = true;
+    _pq_generated = true;
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::get_full_precision_vector(uint32_t location, T *dest)
+{
+    if (_full_vectors == nullptr)
+    {
+        _data_store->get_vector(location, dest);
+        return;
+    }
+    memcpy(dest, _full_vectors + (size_t)location * _dim, _dim * sizeof(T));
+    // the data file keeps raw vectors, e.g. unnormalized ones for cosine
+    if (_data_store->get_dist_fn()->preprocessing_required())
+        _data_store->get_dist_fn()->preprocess_base_points(dest, _dim, 1);
+}
+
+template <typename T, typename TagT, typename LabelT>
+float Index<T, TagT, LabelT>::get_full_precision_distance(const T *aligned_query, uint32_t location,
+                                                          T *vector_scratch)
+{
+    if (_full_vectors == nullptr)
+        return _data_store->get_distance(aligned_query, location);
+
+    // vector_scratch is aligned_dim long with zero padding past _dim
+    get_full_precision_vector(location, vector_scratch);
+    return _data_store->get_dist_fn()->compare(aligned_query, vector_scratch,
+                                               (uint32_t)_data_store->get_aligned_dim());
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::rerank_with_full_precision(InMemQueryScratch<T> *scratch)
+{
+    NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
+    std::vector<Neighbor> &reranked = scratch->pool();
+    T *aligned_query = scratch->aligned_query();
+    T *rerank_vector = scratch->rerank_vector();
+
+    reranked.clear();
+    for (size_t i = 0; i < best_L_nodes.size(); ++i)
+    {
+        const uint32_t id = best_L_nodes[i].id;
+        if (i + 1 < best_L_nodes.size() && _full_vectors == nullptr)
+            _data_store->prefetch_vector(best_L_nodes[i + 1].id);
+        reranked.emplace_back(id, get_full_precision_distance(aligned_query, id, rerank_vector));
+    }
+
+    best_L_nodes.clear();
+    for (auto &nn : reranked)
+        best_L_nodes.insert(nn);
+    reranked.clear();
+}
+
+template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT>::build_filter_entry_points()
+{
+    if (_filter_entry_point_data != nullptr)
+    {
+        aligned_free(_filter_entry_point_data);
+        _filter_entry_point_data = nullptr;
+    }
+    _filter_entry_point_ids.clear();
+    _label_to_entry_point_range.clear();
+
+    for (auto &label_medoids : _label_to_medoid_id)
+    {
+        const uint32_t offset = (uint32_t)_filter_entry_point_ids.size();
+        for (auto medoid : label_medoids.second)
+        {
+            if (medoid < _max_points + _num_frozen_pts)
+                _filter_entry_point_ids.push_back(medoid);
+        }
+        _label_to_entry_point_range[label_medoids.first] =
+            std::make_pair(offset, (uint32_t)_filter_entry_point_ids.size() - offset);
+    }
+
+    if (_filter_entry_point_ids.empty())
+        return;
+
+    const size_t aligned_dim = _data_store->get_aligned_dim();
+    alloc_aligned(((void **)&_filter_entry_point_data), _filter_entry_point_ids.size() * aligned_dim * sizeof(T),
+                  8 * sizeof(T));
+    std::memset(_filter_entry_point_data, 0, _filter_entry_point_ids.size() * aligned_dim * sizeof(T));
+    for (size_t i = 0; i < _filter_entry_point_ids.size(); i++)
+    {
+        get_full_precision_vector(_filter_entry_point_ids[i], _filter_entry_point_data + i * aligned_dim);
+    }
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::select_filter_entry_points(const T *aligned_query, const LabelT &best_filter,
+                                                        const std::vector<LabelT> &filters,
+                                                        std::vector<uint32_t> &init_ids)
+{
+    auto range_iter = _label_to_entry_point_range.find(best_filter);
+    if (range_iter == _label_to_entry_point_range.end() || _filter_entry_point_data == nullptr)
+    {
+        // entry point store not built (e.g. medoids assigned after load), seed all medoids
+        for (auto &start_point : _label_to_medoid_id[best_filter])
+            init_ids.emplace_back(start_point);
+        return;
+    }
+
+    const uint32_t offset = range_iter->second.first;
+    const uint32_t count = range_iter->second.second;
+    const uint32_t aligned_dim = (uint32_t)_data_store->get_aligned_dim();
+
+    // Medoids carrying every query label are preferred; if none do, any medoid
+    // of the rarest label is still a valid start for the any-match traversal.
+    bool any_match_all = false;
+    std::vector<bool> matches_all(count, false);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        matches_all[i] = match_all_filters(_filter_entry_point_ids[offset + i], true, filters);
+        any_match_all = any_match_all || matches_all[i];
+    }
+
+    std::vector<Neighbor> candidates;
+    candidates.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (any_match_all && !matches_all[i])
+            continue;
+        float dist = _data_store->get_dist_fn()->compare(
+            aligned_query, _filter_entry_point_data + (size_t)(offset + i) * aligned_dim, aligned_dim);
+        candidates.emplace_back(_filter_entry_point_ids[offset + i], dist);
+    }
+
+    size_t num_seeds = candidates.size();
+    if (_num_filter_entry_points > 0 && _num_filter_entry_points < num_seeds)
+        num_seeds = _num_filter_entry_points;
+    std::partial_sort(candidates.begin(), candidates.begin() + num_seeds, candidates.end());
+    for (size_t i = 0; i < num_seeds; i++)
+        init_ids.emplace_back(candidates[i].id);
+}
+
+template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT>::build_label_signatures()
+{
+    // Frozen points and unlabeled slots keep an empty signature.
+    _pts_to_label_signature.assign(std::max(_pts_to_labels.size(), _max_points + _num_frozen_pts), 0);
+    for (size_t i = 0; i < _pts_to_labels.size(); i++)
+        _pts_to_label_signature[i] = label_signature(_pts_to_labels[i]);
+}
+
+template <typename T, typename TagT, typename LabelT>
+LabelSignaturePredicate Index<T, TagT, LabelT>::prepare_label_predicate(bool search_invocation,
+                                                                        const std::vector<LabelT> &filters)
+{
+    // Without signatures every candidate is verified exactly.
+    if (_pts_to_label_signature.empty())
+    {
+        LabelSignaturePredicate predicate;
+        predicate.add_all();
+        return predicate;
+    }
+    return make_label_predicate(filters, search_invocation, _use_universal_label, _universal_label);
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::filter_candidates_by_labels(const std::vector<uint32_t> &candidates,
+                                                         bool search_invocation, const std::vector<LabelT> &filters,
+                                                         const LabelSignaturePredicate &predicate,
+                                                         std::vector<uint8_t> &hits, std::vector<uint32_t> &ids_out,
+                                                         std::vector<uint32_t> &common_sizes_out)
+{
+    hits.resize(candidates.size());
+    if (_pts_to_label_signature.empty())
+        std::fill(hits.begin(), hits.end(), 1);
+    else
+        label_signature_hits(_pts_to_label_signature.data(), candidates.data(), candidates.size(), predicate,
+                             hits.data());
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        prefetch_labels_ahead(candidates.data(), candidates.size(), i, hits.data());
+        if (!hits[i])
+            continue;
+        const uint32_t common_size = common_filter_size(candidates[i], search_invocation, filters);
+        if (common_size == 0)
+            continue;
+        ids_out.push_back(candidates[i]);
+        common_sizes_out.push_back(common_size);
+    }
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::prefetch_vectors_ahead(const uint32_t *ids, size_t count, size_t m)
+{
+    const size_t dist = _prefetch_distance;
+    if (dist == 0)
+        return;
+    if (m == 0)
+    {
+        for (size_t i = 1; i < std::min(dist, count); i++)
+            _data_store->prefetch_vector(ids[i]);
+    }
+    if (m + dist < count)
+        _data_store->prefetch_vector(ids[m + dist]);
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::prefetch_labels_ahead(const uint32_t *ids, size_t count, size_t m, const uint8_t *mask)
+{
+    const size_t dist = _prefetch_distance;
+    if (dist == 0)
+        return;
+    auto wanted = [&](size_t i) { return i < count && (mask == nullptr || mask[i]) && ids[i] < _pts_to_labels.size(); };
+    auto prefetch_record = [&](size_t i) {
+        if (wanted(i))
+            _mm_prefetch((const char *)&_pts_to_labels[ids[i]], _MM_HINT_T0);
+    };
+    auto prefetch_list = [&](size_t i) {
+        if (wanted(i))
+            _mm_prefetch((const char *)_pts_to_labels[ids[i]].data(), _MM_HINT_T0);
+    };
+
+    if (m == 0)
+    {
+        for (size_t i = 0; i < 2 * dist; i++)
+            prefetch_record(i);
+        for (size_t i = 0; i < dist; i++)
+            prefetch_list(i);
+    }
+    prefetch_record(m + 2 * dist);
+    prefetch_list(m + dist);
+}
+
+template <typename T, typename TagT, typename LabelT>
+void Index<T, TagT, LabelT>::prefetch_neighbours(uint32_t location)
+{
+    // _mm_prefetch on every cache line the list touches, including a partial
+    // last one; diskann::prefetch_vector rounds down to whole cache lines and
+    // would skip lists shorter than one
+    const auto &neighbours = _graph_store->get_neighbours(location);
+    const char *begin = (const char *)neighbours.data();
+    const size_t num_bytes = neighbours.size() * sizeof(uint32_t);
+    for (size_t offset = 0; offset < num_bytes; offset += 64)
+        _mm_prefetch(begin + offset, _MM_HINT_T0);
+}
+
 template <typename T, typename TagT, typename LabelT>
 void Index<T, TagT, LabelT>::build_filtered_index(const char *filename, const std::string &label_file,
                                                   const size_t num_points_to_load, const std::vector<TagT> &tags)
@@ -2464,6 +2967,7 @@ void Index<T, TagT, LabelT>::build_filtered_index(const char *filename, const st
 
 
     this->build(filename, num_points_to_load, tags);
+    build_filter_entry_points();
 }
 
 template <typename T, typename TagT, typename LabelT>
@@ -2528,6 +3032,8 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search(const T *query, con
 
     auto retval =
         iterate_to_fixed_point(scratch->aligned_query(), L, init_ids, scratch, false, unused_filter_label, true);
+    if (_rerank_full_precision)
+        rerank_with_full_precision(scratch);
 
     NeighborPriorityQueue &best_L_nodes = scratch->best_l_nodes();
 
@@ -2589,17 +3095,17 @@ template <typename T, typename TagT, typename LabelT>
 std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::_search_with_multi_filters(const DataType &query,
                                                                            const std::vector<std::string> &query_filters, const size_t &K,
                                                                            const uint32_t &L, std::any &indices,
-                                                                           float *distances)
+                                                                           float *distances, QueryStats *stats)
 {
     if (typeid(uint64_t *) == indices.type())
     {
         auto ptr = std::any_cast<uint64_t *>(indices);
-        return this->search_with_multi_filters(std::any_cast<T *>(query), query_filters, K, L, ptr, distances);
+        return this->search_with_multi_filters(std::any_cast<T *>(query), query_filters, K, L, ptr, distances, stats);
     }
     else if (typeid(uint32_t *) == indices.type())
     {
         auto ptr = std::any_cast<uint32_t *>(indices);
-        return this->search_with_multi_filters(std::any_cast<T *>(query), query_filters, K, L, ptr, distances);
+        return this->search_with_multi_filters(std::any_cast<T *>(query), query_filters, K, L, ptr, distances, stats);
     }
     else
     {
@@ -2651,6 +3157,8 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_filters(const
 
     _data_store->get_dist_fn()->preprocess_query(query, _data_store->get_dims(), scratch->aligned_query());
     auto retval = iterate_to_fixed_point(scratch->aligned_query(), L, init_ids, scratch, true, filter_vec, true);
+    if (_rerank_full_precision)
+        rerank_with_full_precision(scratch);
 
     auto best_L_nodes = scratch->best_l_nodes();
 
@@ -2689,12 +3197,14 @@ template <typename T, typename TagT, typename LabelT>
 template <typename IdType>
 std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_multi_filters(const T *query, const std::vector<std::string> &query_filters,
                                                                           const size_t &K, const uint32_t &L,
-                                                                          IdType *indices, float *distances)
+                                                                          IdType *indices, float *distances,
+                                                                          QueryStats *stats)
 {
     if (K > (uint64_t)L)
     {
         throw ANNException("Set L to a value of at least K", -1, __FUNCSIG__, __FILE__, __LINE__);
     }
+    Timer query_timer;
 
     ScratchStoreManager<InMemQueryScratch<T>> manager(_query_scratch);
     auto scratch = manager.scratch_space();
@@ -2716,13 +3226,7 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_multi_filters(
     std::shared_lock<std::shared_timed_mutex> lock(_update_lock);
     for (auto filter_name:query_filters){
         LabelT filter_label = get_converted_label(filter_name);
-        if (_label_to_medoid_id.find(filter_label) != _label_to_medoid_id.end())
-        {
-            for (auto& start_point: _label_to_medoid_id[filter_label]){
-                init_ids.emplace_back(start_point);
-            }
-        }
-        else
+        if (_label_to_medoid_id.find(filter_label) == _label_to_medoid_id.end())
         {
             diskann::cout << "No filtered medoid found. exitting "
                         << std::endl; // RKNOTE: If universal label found start there
@@ -2757,34 +3261,64 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_multi_filters(
         std::vector<uint32_t> &id_scratch = scratch->id_scratch();
         std::vector<float> &dist_scratch = scratch->dist_scratch();
         T *aligned_query = scratch->aligned_query();
+        T *rerank_vector = scratch->rerank_vector();
         assert(dist_scratch.size() == 0);
+        Timer phase_timer;
         for (uint32_t id: _label_to_pts[actual_filter]){
             if (match_all_filters(id,true,filter_vec)){
                 id_scratch.push_back(id);
             }
         }
+        if (stats != nullptr)
+        {
+            stats->brute_force = true;
+            stats->n_filter_checks += (unsigned)_label_to_pts[actual_filter].size();
+            stats->n_filter_rejects += (unsigned)(_label_to_pts[actual_filter].size() - id_scratch.size());
+            stats->filter_us += phase_timer.elapsed_us();
+            phase_timer.reset();
+        }
         dist_scratch.reserve(id_scratch.size());
         for (size_t m = 0; m < id_scratch.size(); ++m)
         {
             uint32_t id = id_scratch[m];
 
-            if (m + 1 < id_scratch.size())
+            if (m + 1 < id_scratch.size() && _full_vectors == nullptr)
             {
                 auto nextn = id_scratch[m + 1];
                 _data_store->prefetch_vector(nextn);
             }
 
-            dist_scratch.push_back(_data_store->get_distance(aligned_query, id));
+            dist_scratch.push_back(get_full_precision_distance(aligned_query, id, rerank_vector));
+        }
+        if (stats != nullptr)
+        {
+            stats->dist_us += phase_timer.elapsed_us();
+            phase_timer.reset();
         }
         for (size_t m = 0; m < id_scratch.size(); ++m){
             Neighbor nn(id_scratch[m],dist_scratch[m]);
             best_L_nodes.insert(nn);
         }
+        if (stats != nullptr)
+            stats->queue_us += phase_timer.elapsed_us();
         retval = std::pair<uint32_t,uint32_t>(0,id_scratch.size());
         
     }
     else{
-        retval = iterate_to_fixed_point_v2(scratch->aligned_query(), L, init_ids, scratch, true, filter_vec, true);
+        select_filter_entry_points(scratch->aligned_query(), best_filter, filter_vec, init_ids);
+        if (_rerank_full_precision)
+        {
+            // keep all L all-match candidates so re-ranking can recover from
+            // PQ or scalar quantization error
+            retval = iterate_to_fixed_point_v2(scratch->aligned_query(), L, init_ids, scratch, true, filter_vec, true,
+                                               std::numeric_limits<uint32_t>::max(), L, stats);
+            rerank_with_full_precision(scratch);
+        }
+        else
+        {
+            retval = iterate_to_fixed_point_v2(scratch->aligned_query(), L, init_ids, scratch, true, filter_vec, true,
+                                               std::numeric_limits<uint32_t>::max(), 10, stats);
+        }
     }   
 
 
@@ -2816,6 +3350,12 @@ std::pair<uint32_t, uint32_t> Index<T, TagT, LabelT>::search_with_multi_filters(
         // diskann::cerr << "Found fewer than K elements for query" << std::endl;
     }
 
+    if (stats != nullptr)
+    {
+        stats->n_hops += retval.first;
+        stats->n_cmps += retval.second;
+        stats->total_us += query_timer.elapsed_us();
+    }
     return retval;    
 }
 
@@ -3778,7 +4318,8 @@ template <typename T, typename TagT, typename LabelT> void Index<T, TagT, LabelT
     _data_len = (_data_store->get_aligned_dim() + 1) * sizeof(float);
     _neighbor_len = (_graph_store->get_max_observed_degree() + 1) * sizeof(uint32_t);
     _node_size = _data_len + _neighbor_len;
-    _opt_graph = new char[_node_size * _nd];
+    _opt_graph_size = _node_size * _nd;
+    _opt_graph = (char *)huge_page_alloc(_opt_graph_size, sizeof(float), _huge_pages);
     DistanceFastL2<T> *dist_fast = (DistanceFastL2<T> *)_data_store->get_dist_fn();
     for (uint32_t i = 0; i < _nd; i++)
     {
@@ -4073,76 +4614,76 @@ template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t,
 
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint32_t>::search_with_multi_filters<
     uint64_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint32_t>::search_with_multi_filters<
     uint32_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint32_t>::search_with_multi_filters<
     uint64_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint32_t>::search_with_multi_filters<
     uint32_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint32_t>::search_with_multi_filters<
     uint64_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint32_t>::search_with_multi_filters<
     uint32_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 // TagT==uint32_t
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint32_t>::search_with_multi_filters<
     uint64_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint32_t>::search_with_multi_filters<
     uint32_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint32_t>::search_with_multi_filters<
     uint64_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint32_t>::search_with_multi_filters<
     uint32_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint32_t>::search_with_multi_filters<
     uint64_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint32_t>::search_with_multi_filters<
     uint32_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint16_t>::search_with_multi_filters<
     uint64_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint64_t, uint16_t>::search_with_multi_filters<
     uint32_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint16_t>::search_with_multi_filters<
     uint64_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint64_t, uint16_t>::search_with_multi_filters<
     uint32_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint16_t>::search_with_multi_filters<
     uint64_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint64_t, uint16_t>::search_with_multi_filters<
     uint32_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 // TagT==uint32_t
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint16_t>::search_with_multi_filters<
     uint64_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<float, uint32_t, uint16_t>::search_with_multi_filters<
     uint32_t>(const float *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint16_t>::search_with_multi_filters<
     uint64_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<uint8_t, uint32_t, uint16_t>::search_with_multi_filters<
     uint32_t>(const uint8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint16_t>::search_with_multi_filters<
     uint64_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint64_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 template DISKANN_DLLEXPORT std::pair<uint32_t, uint32_t> Index<int8_t, uint32_t, uint16_t>::search_with_multi_filters<
     uint32_t>(const int8_t *query, const std::vector<std::string> &query_filters, const size_t &K, const uint32_t &L, uint32_t *indices,
-              float *distances);
+              float *distances, QueryStats *stats);
 } // namespace diskann
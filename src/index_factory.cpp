@@ -40,6 +40,14 @@ void IndexFactory::check_config()
                            -1);
     }
 
+    if ((_config->data_strategy == DataStoreStrategy::MEMORY_SQ8 ||
+         _config->data_strategy == DataStoreStrategy::MEMORY_SQ4) &&
+        _config->data_type != "float")
+    {
+        throw ANNException("ERROR: scalar quantized data stores only support float data", -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+    }
+
     if (_config->tag_type != "int32" && _config->tag_type != "uint32" && _config->tag_type != "int64" &&
         _config->tag_type != "uint64")
     {
@@ -52,7 +60,7 @@ void IndexFactory::check_config()
 template <typename T>
 std::unique_ptr<AbstractDataStore<T>> IndexFactory::construct_datastore(const DataStoreStrategy strategy,
                                                                         const size_t num_points, const size_t dimension,
-                                                                        const Metric m)
+                                                                        const Metric m, const HugePagePolicy huge_pages)
 {
     std::unique_ptr<Distance<T>> distance;
     switch (strategy)
@@ -61,12 +69,32 @@ std::unique_ptr<AbstractDataStore<T>> IndexFactory::construct_datastore(const Da
         if (m == diskann::Metric::COSINE && std::is_same<T, float>::value)
         {
             distance.reset((Distance<T> *)new AVXNormalizedCosineDistanceFloat());
-            return std::make_unique<diskann::InMemDataStore<T>>((location_t)num_points, dimension, std::move(distance));
+            return std::make_unique<diskann::InMemDataStore<T>>((location_t)num_points, dimension, std::move(distance),
+                                                                huge_pages);
         }
         else
         {
             distance.reset((Distance<T> *)get_distance_function<T>(m));
-            return std::make_unique<diskann::InMemDataStore<T>>((location_t)num_points, dimension, std::move(distance));
+            return std::make_unique<diskann::InMemDataStore<T>>((location_t)num_points, dimension, std::move(distance),
+                                                                huge_pages);
+        }
+        break;
+    case diskann::DataStoreStrategy::MEMORY_SQ8:
+    case diskann::DataStoreStrategy::MEMORY_SQ4:
+        if constexpr (std::is_same<T, float>::value)
+        {
+            const uint32_t num_bits = strategy == diskann::DataStoreStrategy::MEMORY_SQ8 ? 8 : 4;
+            if (m == diskann::Metric::COSINE)
+                distance.reset((Distance<T> *)new AVXNormalizedCosineDistanceFloat());
+            else
+                distance.reset((Distance<T> *)get_distance_function<T>(m));
+            return std::make_unique<diskann::InMemSQDataStore<T>>((location_t)num_points, dimension,
+                                                                  std::move(distance), num_bits, huge_pages);
+        }
+        else
+        {
+            throw ANNException("ERROR: scalar quantized data stores only support float data", -1, __FUNCSIG__,
+                               __FILE__, __LINE__);
         }
         break;
     default:
@@ -96,7 +124,8 @@ std::unique_ptr<AbstractIndex> IndexFactory::create_instance()
     size_t max_reserve_degree =
         (size_t)(defaults::GRAPH_SLACK_FACTOR * 1.05 *
                  (_config->index_write_params == nullptr ? 0 : _config->index_write_params->max_degree));
-    auto data_store = construct_datastore<data_type>(_config->data_strategy, num_points, dim, _config->metric);
+    auto data_store = construct_datastore<data_type>(_config->data_strategy, num_points, dim, _config->metric,
+                                                     _config->huge_pages);
     auto graph_store =
         construct_graphstore(_config->graph_strategy, num_points + _config->num_frozen_pts, max_reserve_degree);
     return std::make_unique<diskann::Index<data_type, tag_type, label_type>>(*_config, std::move(data_store),
@@ -161,10 +190,10 @@ std::unique_ptr<AbstractIndex> IndexFactory::create_instance(const std::string &
 }
 
 template DISKANN_DLLEXPORT std::unique_ptr<AbstractDataStore<uint8_t>> IndexFactory::construct_datastore(
-    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m);
+    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m, HugePagePolicy huge_pages);
 template DISKANN_DLLEXPORT std::unique_ptr<AbstractDataStore<int8_t>> IndexFactory::construct_datastore(
-    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m);
+    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m, HugePagePolicy huge_pages);
 template DISKANN_DLLEXPORT std::unique_ptr<AbstractDataStore<float>> IndexFactory::construct_datastore(
-    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m);
+    DataStoreStrategy stratagy, size_t num_points, size_t dimension, Metric m, HugePagePolicy huge_pages);
 
 } // namespace diskann
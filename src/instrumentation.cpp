@@ -0,0 +1,105 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "instrumentation.h"
+
+#ifdef DISKANN_INSTRUMENT
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ann_exception.h"
+#include "logger.h"
+
+namespace diskann
+{
+namespace instrumentation
+{
+namespace
+{
+const char *PROBE_NAMES[NUM_PROBES] = {"iterate_to_fixed_point", "iterate_to_fixed_point_v2", "occlude_list",
+                                       "inter_insert", "stitch_label_graph"};
+const char *COUNTER_NAMES[NUM_COUNTERS] = {"hops", "distance_cmps", "filter_checks", "filter_rejects",
+                                           "occlude_candidates", "reverse_edges", "stitched_edges"};
+
+struct Registry
+{
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadProbes>> threads;
+    // the TSC rate is measured between these and the report
+    uint64_t start_cycles = __rdtsc();
+    std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+} // namespace
+
+ThreadProbes *register_thread()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.threads.emplace_back(new ThreadProbes());
+    return reg.threads.back().get();
+}
+
+void reset()
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto &probes : reg.threads)
+        *probes = ThreadProbes();
+    reg.start_cycles = __rdtsc();
+    reg.start_time = std::chrono::steady_clock::now();
+}
+
+void write_report(const std::string &report_file)
+{
+    Registry &reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+
+    const double elapsed_us =
+        std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - reg.start_time).count();
+    const double cycles_per_us = elapsed_us > 0 ? (double)(__rdtsc() - reg.start_cycles) / elapsed_us : 1.0;
+
+    std::ofstream out(report_file);
+    if (!out.is_open())
+        throw ANNException("Could not open instrumentation report " + report_file, -1, __FUNCSIG__, __FILE__,
+                           __LINE__);
+
+    out << "{\n  \"threads\": " << reg.threads.size() << ",\n  \"elapsed_us\": " << elapsed_us
+        << ",\n  \"cycles_per_us\": " << cycles_per_us << ",\n  \"probes\": {";
+    for (size_t p = 0; p < NUM_PROBES; p++)
+    {
+        uint64_t calls = 0, cycles = 0, max_thread_cycles = 0;
+        for (const auto &probes : reg.threads)
+        {
+            calls += probes->calls[p];
+            cycles += probes->cycles[p];
+            max_thread_cycles = std::max(max_thread_cycles, probes->cycles[p]);
+        }
+        // max_thread_us against total_us / threads shows how evenly the work was spread
+        out << (p == 0 ? "\n" : ",\n") << "    \"" << PROBE_NAMES[p] << "\": {\"calls\": " << calls
+            << ", \"cycles\": " << cycles << ", \"total_us\": " << cycles / cycles_per_us
+            << ", \"max_thread_us\": " << max_thread_cycles / cycles_per_us << "}";
+    }
+    out << "\n  },\n  \"counters\": {";
+    for (size_t c = 0; c < NUM_COUNTERS; c++)
+    {
+        uint64_t count = 0;
+        for (const auto &probes : reg.threads)
+            count += probes->counts[c];
+        out << (c == 0 ? "\n" : ",\n") << "    \"" << COUNTER_NAMES[c] << "\": " << count;
+    }
+    out << "\n  }\n}\n";
+    diskann::cout << "Wrote instrumentation report to " << report_file << std::endl;
+}
+} // namespace instrumentation
+} // namespace diskann
+#endif
@@ -0,0 +1,321 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#if !defined(_WINDOWS) && defined(USE_IO_URING)
+
+#include "io_uring_aligned_file_reader.h"
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include "tsl/robin_map.h"
+#include "utils.h"
+
+// idle time in milliseconds before the SQPOLL kernel thread goes to sleep
+#define SQPOLL_IDLE_MS 2000
+
+IoUringAlignedFileReader::IoUringAlignedFileReader(const bool sqpoll, const uint32_t queue_depth)
+    : queue_depth(queue_depth), sqpoll(sqpoll)
+{
+    this->file_desc = -1;
+}
+
+IoUringAlignedFileReader::~IoUringAlignedFileReader()
+{
+    this->deregister_all_threads();
+    if (this->file_desc != -1 && ::fcntl(this->file_desc, F_GETFD) != -1)
+    {
+        std::cerr << "close() not called" << std::endl;
+        ::close(this->file_desc);
+    }
+}
+
+IoUringAlignedFileReader::ThreadRing *IoUringAlignedFileReader::to_ring(io_context_t ctx)
+{
+    return reinterpret_cast<ThreadRing *>(ctx);
+}
+
+void IoUringAlignedFileReader::register_file(ThreadRing *thread_ring)
+{
+    if (this->file_desc == -1 || thread_ring->file_registered)
+        return;
+    int ret = io_uring_register_files(&thread_ring->ring, &this->file_desc, 1);
+    if (ret < 0)
+    {
+        // reads fall back to the plain file descriptor
+        std::cerr << "io_uring_register_files() failed; returned " << ret << ":" << ::strerror(-ret) << std::endl;
+        return;
+    }
+    thread_ring->file_registered = true;
+}
+
+void IoUringAlignedFileReader::prep_read(ThreadRing *thread_ring, struct io_uring_sqe *sqe, const AlignedRead &req)
+{
+    // the registered file is always at index 0 of the ring's file table
+    const int fd = thread_ring->file_registered ? 0 : this->file_desc;
+    char *buf = (char *)req.buf;
+    if (thread_ring->fixed_buf != nullptr && buf >= thread_ring->fixed_buf &&
+        buf + req.len <= thread_ring->fixed_buf + thread_ring->fixed_len)
+        io_uring_prep_read_fixed(sqe, fd, req.buf, (unsigned)req.len, req.offset, 0);
+    else
+        io_uring_prep_read(sqe, fd, req.buf, (unsigned)req.len, req.offset);
+    if (thread_ring->file_registered)
+        sqe->flags |= IOSQE_FIXED_FILE;
+    io_uring_sqe_set_data(sqe, req.buf);
+    thread_ring->pending_len[req.buf] = req.len;
+}
+
+void *IoUringAlignedFileReader::complete_read(ThreadRing *thread_ring, struct io_uring_cqe *cqe)
+{
+    void *buf = io_uring_cqe_get_data(cqe);
+    const int res = cqe->res;
+    io_uring_cqe_seen(&thread_ring->ring, cqe);
+
+    auto iter = thread_ring->pending_len.find(buf);
+    assert(iter != thread_ring->pending_len.end());
+    const uint64_t len = iter->second;
+    thread_ring->pending_len.erase(iter);
+    if (res < 0)
+    {
+        std::cerr << "io_uring read failed; returned " << res << ":" << ::strerror(-res) << std::endl;
+        exit(-1);
+    }
+    // a short read, e.g. past the end of the file, would leave stale bytes in buf
+    if ((uint64_t)res != len)
+        throw diskann::ANNException("io_uring short read: " + std::to_string(res) + " of " + std::to_string(len) +
+                                        " bytes",
+                                    -1, __FUNCSIG__, __FILE__, __LINE__);
+    return buf;
+}
+
+io_context_t &IoUringAlignedFileReader::get_ctx()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(std::this_thread::get_id()) == ctx_map.end())
+    {
+        std::cerr << "bad thread access; returning -1 as io_context_t" << std::endl;
+        return this->bad_ctx;
+    }
+    else
+    {
+        return ctx_map[std::this_thread::get_id()];
+    }
+}
+
+void IoUringAlignedFileReader::register_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(my_id) != ctx_map.end())
+    {
+        std::cerr << "multiple calls to register_thread from the same thread" << std::endl;
+        return;
+    }
+
+    ThreadRing *thread_ring = new ThreadRing();
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    if (this->sqpoll)
+    {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = SQPOLL_IDLE_MS;
+    }
+    int ret = io_uring_queue_init_params(this->queue_depth, &thread_ring->ring, &params);
+    if (ret < 0)
+    {
+        std::cerr << "io_uring_queue_init_params() failed; returned " << ret << ":" << ::strerror(-ret) << std::endl;
+        delete thread_ring;
+        return;
+    }
+    register_file(thread_ring);
+
+    io_context_t ctx = reinterpret_cast<io_context_t>(thread_ring);
+    diskann::cout << "allocating io_uring ctx: " << ctx << " to thread-id:" << my_id << std::endl;
+    ctx_map[my_id] = ctx;
+}
+
+void IoUringAlignedFileReader::deregister_thread()
+{
+    auto my_id = std::this_thread::get_id();
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    auto iter = ctx_map.find(my_id);
+    assert(iter != ctx_map.end());
+    if (iter == ctx_map.end())
+        return;
+
+    ThreadRing *thread_ring = to_ring(iter->second);
+    io_uring_queue_exit(&thread_ring->ring);
+    delete thread_ring;
+    ctx_map.erase(my_id);
+    std::cerr << "returned io_uring ctx from thread-id:" << my_id << std::endl;
+}
+
+void IoUringAlignedFileReader::deregister_all_threads()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+    {
+        ThreadRing *thread_ring = to_ring(x.value());
+        io_uring_queue_exit(&thread_ring->ring);
+        delete thread_ring;
+    }
+    ctx_map.clear();
+}
+
+void IoUringAlignedFileReader::register_buffer(void *buf, uint64_t len)
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    auto iter = ctx_map.find(std::this_thread::get_id());
+    if (iter == ctx_map.end())
+        return;
+
+    ThreadRing *thread_ring = to_ring(iter->second);
+    if (thread_ring->fixed_buf != nullptr)
+        io_uring_unregister_buffers(&thread_ring->ring);
+    thread_ring->fixed_buf = nullptr;
+    thread_ring->fixed_len = 0;
+
+    struct iovec iov;
+    iov.iov_base = buf;
+    iov.iov_len = len;
+    int ret = io_uring_register_buffers(&thread_ring->ring, &iov, 1);
+    if (ret < 0)
+    {
+        // usually RLIMIT_MEMLOCK; reads into buf are issued as regular reads
+        std::cerr << "io_uring_register_buffers() failed; returned " << ret << ":" << ::strerror(-ret) << std::endl;
+        return;
+    }
+    thread_ring->fixed_buf = (char *)buf;
+    thread_ring->fixed_len = len;
+}
+
+void IoUringAlignedFileReader::open(const std::string &fname)
+{
+    int flags = O_DIRECT | O_RDONLY | O_LARGEFILE;
+    this->file_desc = ::open(fname.c_str(), flags);
+    // error checks
+    assert(this->file_desc != -1);
+    std::cerr << "Opened file : " << fname << std::endl;
+
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+        register_file(to_ring(x.value()));
+}
+
+void IoUringAlignedFileReader::close()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    for (auto x = ctx_map.begin(); x != ctx_map.end(); x++)
+    {
+        ThreadRing *thread_ring = to_ring(x.value());
+        if (thread_ring->file_registered)
+        {
+            io_uring_unregister_files(&thread_ring->ring);
+            thread_ring->file_registered = false;
+        }
+    }
+    ::close(this->file_desc);
+    this->file_desc = -1;
+}
+
+void IoUringAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_context_t &ctx, bool async)
+{
+    if (async == true)
+    {
+        diskann::cout << "Async currently not supported in linux." << std::endl;
+    }
+    assert(this->file_desc != -1);
+    ThreadRing *thread_ring = to_ring(ctx);
+    struct io_uring *ring = &thread_ring->ring;
+
+    // break-up requests into chunks no larger than the submission queue
+    uint64_t n_iters = ROUND_UP(read_reqs.size(), this->queue_depth) / this->queue_depth;
+    for (uint64_t iter = 0; iter < n_iters; iter++)
+    {
+        uint64_t base = iter * this->queue_depth;
+        uint64_t n_ops = std::min((uint64_t)read_reqs.size() - base, (uint64_t)this->queue_depth);
+        for (uint64_t j = 0; j < n_ops; j++)
+        {
+            AlignedRead &req = read_reqs[base + j];
+            struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+            assert(sqe != nullptr);
+            prep_read(thread_ring, sqe, req);
+        }
+
+        int ret = io_uring_submit_and_wait(ring, (unsigned)n_ops);
+        if (ret != (int)n_ops)
+        {
+            std::cerr << "io_uring_submit_and_wait() failed; returned " << ret << ", expected=" << n_ops << ":"
+                      << ::strerror(ret < 0 ? -ret : EIO) << std::endl;
+            exit(-1);
+        }
+
+        uint64_t n_done = 0;
+        while (n_done < n_ops)
+        {
+            struct io_uring_cqe *cqe = nullptr;
+            ret = io_uring_wait_cqe(ring, &cqe);
+            if (ret < 0)
+            {
+                std::cerr << "io_uring_wait_cqe() failed; returned " << ret << ":" << ::strerror(-ret) << std::endl;
+                exit(-1);
+            }
+            complete_read(thread_ring, cqe);
+            n_done++;
+        }
+    }
+}
+
+bool IoUringAlignedFileReader::supports_async() const
+{
+    return true;
+}
+
+void IoUringAlignedFileReader::submit_reqs(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    assert(this->file_desc != -1);
+    ThreadRing *thread_ring = to_ring(ctx);
+    struct io_uring *ring = &thread_ring->ring;
+
+    for (auto &req : read_reqs)
+    {
+        struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+        if (sqe == nullptr)
+        {
+            // submission queue full, hand the queued entries to the kernel
+            io_uring_submit(ring);
+            sqe = io_uring_get_sqe(ring);
+            assert(sqe != nullptr);
+        }
+        prep_read(thread_ring, sqe, req);
+    }
+    int ret = io_uring_submit(ring);
+    if (ret < 0)
+    {
+        std::cerr << "io_uring_submit() failed; returned " << ret << ":" << ::strerror(-ret) << std::endl;
+        exit(-1);
+    }
+}
+
+void IoUringAlignedFileReader::poll_reqs(io_context_t &ctx, uint64_t min_done, std::vector<void *> &done_bufs)
+{
+    ThreadRing *thread_ring = to_ring(ctx);
+    struct io_uring *ring = &thread_ring->ring;
+    uint64_t n_done = 0;
+    while (true)
+    {
+        struct io_uring_cqe *cqe = nullptr;
+        int ret = n_done < min_done ? io_uring_wait_cqe(ring, &cqe) : io_uring_peek_cqe(ring, &cqe);
+        if (ret == -EAGAIN && n_done >= min_done)
+            break;
+        if (ret < 0)
+        {
+            std::cerr << "io_uring_wait_cqe() failed; returned " << ret << ":" << ::strerror(-ret) << std::endl;
+            exit(-1);
+        }
+        done_bufs.push_back(complete_read(thread_ring, cqe));
+        n_done++;
+    }
+}
+
+#endif
@@ -5,9 +5,12 @@
 
 #include <cassert>
 #include <cstdio>
+#include <cstdlib>
 #include <iostream>
 #include "tsl/robin_map.h"
 #include "utils.h"
+#include "ann_exception.h"
+#include "io_uring_aligned_file_reader.h"
 #define MAX_EVENTS 1024
 
 namespace
@@ -222,3 +225,85 @@ void LinuxAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, io_contex
     assert(this->file_desc != -1);
     execute_io(ctx, this->file_desc, read_reqs);
 }
+
+bool LinuxAlignedFileReader::supports_async() const
+{
+    return true;
+}
+
+void LinuxAlignedFileReader::submit_reqs(std::vector<AlignedRead> &read_reqs, io_context_t &ctx)
+{
+    assert(this->file_desc != -1);
+    uint64_t n_ops = read_reqs.size();
+    if (n_ops == 0)
+        return;
+    // the kernel copies the control blocks during io_submit, only the buf
+    // pointer carried in cb.data has to outlive the call
+    std::vector<struct iocb> cb(n_ops);
+    std::vector<iocb_t *> cbs(n_ops, nullptr);
+    for (uint64_t j = 0; j < n_ops; j++)
+    {
+        io_prep_pread(cb.data() + j, this->file_desc, read_reqs[j].buf, read_reqs[j].len, read_reqs[j].offset);
+        cb[j].data = read_reqs[j].buf;
+        cbs[j] = cb.data() + j;
+    }
+
+    uint64_t n_submitted = 0;
+    while (n_submitted < n_ops)
+    {
+        int64_t ret = io_submit(ctx, (int64_t)(n_ops - n_submitted), cbs.data() + n_submitted);
+        if (ret <= 0)
+        {
+            std::cerr << "io_submit() failed; returned " << ret << ", expected=" << n_ops - n_submitted
+                      << ", ernno=" << errno << "=" << ::strerror(-ret) << std::endl;
+            exit(-1);
+        }
+        n_submitted += ret;
+    }
+}
+
+void LinuxAlignedFileReader::poll_reqs(io_context_t &ctx, uint64_t min_done, std::vector<void *> &done_bufs)
+{
+    io_event_t evts[MAX_EVENTS];
+    int64_t ret = io_getevents(ctx, (int64_t)min_done, MAX_EVENTS, evts, nullptr);
+    if (ret < (int64_t)min_done)
+    {
+        std::cerr << "io_getevents() failed; returned " << ret << ", expected at least " << min_done
+                  << ", ernno=" << errno << "=" << ::strerror(-ret) << std::endl;
+        exit(-1);
+    }
+    for (int64_t i = 0; i < ret; i++)
+    {
+        if ((int64_t)evts[i].res < 0)
+        {
+            std::cerr << "read failed; returned " << (int64_t)evts[i].res << std::endl;
+            exit(-1);
+        }
+        done_bufs.push_back(evts[i].data);
+    }
+}
+
+std::shared_ptr<AlignedFileReader> create_linux_aligned_file_reader(const std::string &backend)
+{
+    std::string name = backend;
+    if (name.empty())
+    {
+        const char *env = std::getenv("DISKANN_IO_BACKEND");
+        name = (env != nullptr) ? env : "aio";
+    }
+
+    if (name == "aio")
+        return std::make_shared<LinuxAlignedFileReader>();
+#ifdef USE_IO_URING
+    if (name == "io_uring")
+        return std::make_shared<IoUringAlignedFileReader>(false);
+    if (name == "io_uring_sqpoll")
+        return std::make_shared<IoUringAlignedFileReader>(true);
+#else
+    if (name == "io_uring" || name == "io_uring_sqpoll")
+        throw diskann::ANNException("I/O backend " + name + " requires building with DISKANN_USE_IO_URING", -1,
+                                    __FUNCSIG__, __FILE__, __LINE__);
+#endif
+    throw diskann::ANNException("Unknown I/O backend " + name + ", expected one of aio, io_uring, io_uring_sqpoll", -1,
+                                __FUNCSIG__, __FILE__, __LINE__);
+}
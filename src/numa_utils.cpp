@@ -0,0 +1,154 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <sstream>
+#include <omp.h>
+
+#ifndef _WINDOWS
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "ann_exception.h"
+#include "logger.h"
+#include "numa_utils.h"
+
+namespace diskann
+{
+namespace
+{
+#ifndef _WINDOWS
+constexpr size_t MAX_NUMA_NODES = 1024;
+constexpr size_t BITS_PER_WORD = 8 * sizeof(unsigned long);
+
+// Reads a sysfs list such as "0-3,8-11". Returns an empty list if the file
+// does not exist.
+std::vector<uint32_t> read_sysfs_list(const std::string &path)
+{
+    std::vector<uint32_t> values;
+    std::ifstream in(path);
+    std::string range;
+    while (std::getline(in, range, ','))
+    {
+        range.erase(std::remove_if(range.begin(), range.end(), ::isspace), range.end());
+        if (range.empty())
+            continue;
+        const size_t dash = range.find('-');
+        const uint32_t first = (uint32_t)std::stoul(range.substr(0, dash));
+        const uint32_t last = dash == std::string::npos ? first : (uint32_t)std::stoul(range.substr(dash + 1));
+        for (uint32_t v = first; v <= last; v++)
+            values.push_back(v);
+    }
+    return values;
+}
+
+bool set_thread_mempolicy(const int mode, const std::vector<unsigned long> &mask)
+{
+    return syscall(SYS_set_mempolicy, mode, mask.empty() ? nullptr : mask.data(),
+                   mask.empty() ? 0 : (unsigned long)(mask.size() * BITS_PER_WORD)) == 0;
+}
+
+// Applies the policy to the calling thread and its OpenMP team. Threads
+// that OpenMP starts later inherit the policy of the calling thread.
+bool set_team_mempolicy(const int mode, const std::vector<unsigned long> &mask)
+{
+    std::atomic<bool> ok{set_thread_mempolicy(mode, mask)};
+#pragma omp parallel
+    {
+        if (!set_thread_mempolicy(mode, mask))
+            ok = false;
+    }
+    return ok;
+}
+#endif
+} // namespace
+
+NumaPlacement get_numa_placement(const std::string &placement)
+{
+    if (placement == "none")
+        return NumaPlacement::None;
+    if (placement == "interleave")
+        return NumaPlacement::Interleave;
+    if (placement == "replicate")
+        return NumaPlacement::Replicate;
+    throw ANNException("Unknown NUMA placement " + placement + ", expected none, interleave or replicate", -1,
+                       __FUNCSIG__, __FILE__, __LINE__);
+}
+
+std::vector<int> get_allowed_cpus()
+{
+    std::vector<int> cpus;
+#ifndef _WINDOWS
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    if (sched_getaffinity(0, sizeof(mask), &mask) != 0)
+        return cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if (CPU_ISSET(cpu, &mask))
+            cpus.push_back(cpu);
+#endif
+    return cpus;
+}
+
+std::vector<uint32_t> get_numa_nodes()
+{
+    std::vector<uint32_t> nodes;
+#ifndef _WINDOWS
+    for (const uint32_t node : read_sysfs_list("/sys/devices/system/node/online"))
+        if (node < MAX_NUMA_NODES && !get_numa_node_cpus(node).empty())
+            nodes.push_back(node);
+#endif
+    if (nodes.empty())
+        nodes.push_back(0);
+    return nodes;
+}
+
+std::vector<int> get_numa_node_cpus(const uint32_t node)
+{
+    std::vector<int> cpus;
+#ifndef _WINDOWS
+    const std::vector<int> allowed = get_allowed_cpus();
+    std::vector<uint32_t> node_cpus =
+        read_sysfs_list("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    // without sysfs node information every CPU is on node 0
+    if (node_cpus.empty() && node == 0)
+        return allowed;
+    for (const uint32_t cpu : node_cpus)
+        if (std::binary_search(allowed.begin(), allowed.end(), (int)cpu))
+            cpus.push_back((int)cpu);
+#endif
+    return cpus;
+}
+
+ScopedNumaMemoryPolicy::ScopedNumaMemoryPolicy(const std::vector<uint32_t> &nodes, const bool interleave)
+{
+#ifndef _WINDOWS
+    std::vector<unsigned long> mask(MAX_NUMA_NODES / BITS_PER_WORD, 0);
+    for (size_t i = 0; i < (interleave ? nodes.size() : std::min<size_t>(nodes.size(), 1)); i++)
+        if (nodes[i] < MAX_NUMA_NODES)
+            mask[nodes[i] / BITS_PER_WORD] |= 1UL << (nodes[i] % BITS_PER_WORD);
+
+    _set = set_team_mempolicy(interleave ? MPOL_INTERLEAVE : MPOL_PREFERRED, mask);
+    if (!_set)
+    {
+        diskann::cerr << "Could not set the NUMA memory policy, the index is placed by first touch" << std::endl;
+        set_team_mempolicy(MPOL_DEFAULT, {});
+    }
+#else
+    diskann::cerr << "NUMA placement is only available on Linux, the index is placed by first touch" << std::endl;
+#endif
+}
+
+ScopedNumaMemoryPolicy::~ScopedNumaMemoryPolicy()
+{
+#ifndef _WINDOWS
+    if (_set)
+        set_team_mempolicy(MPOL_DEFAULT, {});
+#endif
+}
+} // namespace diskann
@@ -2,6 +2,8 @@
 // Licensed under the MIT license.
 
 #include "mkl.h"
+#include <numeric>
+#include <omp.h>
 
 #include "pq.h"
 #include "partition.h"
@@ -10,6 +12,10 @@
 
 // block size for reading/processing large files and matrices in blocks
 #define BLOCK_SIZE 5000000
+// memory that chunks trained at the same time may use together
+#define PQ_TRAINING_MEMORY_BUDGET ((size_t)8 << 30)
+// mini-batches of k-means per Lloyds iteration it replaces
+#define MINIBATCH_ITERS_PER_KMEANS_REP 10
 
 namespace diskann
 {
@@ -87,14 +93,15 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     diskann::load_bin<float>(pq_table_file, tables, nr, nc, file_offset_data[0]);
 #endif
 
-    if ((nr != NUM_PQ_CENTROIDS))
+    if (nr != NUM_PQ_CENTROIDS && nr != NUM_PQ4_CENTROIDS)
     {
         diskann::cout << "Error reading pq_pivots file " << pq_table_file << ". file_num_centers  = " << nr
-                      << " but expecting " << NUM_PQ_CENTROIDS << " centers";
+                      << " but expecting " << NUM_PQ_CENTROIDS << " or " << NUM_PQ4_CENTROIDS << " centers";
         throw diskann::ANNException("Error reading pq_pivots file at pivots data.", -1, __FUNCSIG__, __FILE__,
                                     __LINE__);
     }
 
+    this->num_centers = (uint32_t)nr;
     this->ndims = nc;
 
 #ifdef EXEC_ENV_OLS
@@ -130,7 +137,7 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     }
 
     this->n_chunks = nr - 1;
-    diskann::cout << "Loaded PQ Pivots: #ctrs: " << NUM_PQ_CENTROIDS << ", #dims: " << this->ndims
+    diskann::cout << "Loaded PQ Pivots: #ctrs: " << num_centers << ", #dims: " << this->ndims
                   << ", #chunks: " << this->n_chunks << std::endl;
 
     if (file_exists(rotmat_file))
@@ -149,12 +156,12 @@ void FixedChunkPQTable::load_pq_centroid_bin(const char *pq_table_file, size_t n
     }
 
     // alloc and compute transpose
-    tables_tr = new float[256 * this->ndims];
-    for (size_t i = 0; i < 256; i++)
+    tables_tr = new float[num_centers * this->ndims];
+    for (size_t i = 0; i < num_centers; i++)
     {
         for (size_t j = 0; j < this->ndims; j++)
         {
-            tables_tr[j * 256 + i] = tables[i * this->ndims + j];
+            tables_tr[j * num_centers + i] = tables[i * this->ndims + j];
         }
     }
 }
@@ -164,6 +171,11 @@ uint32_t FixedChunkPQTable::get_num_chunks()
     return static_cast<uint32_t>(n_chunks);
 }
 
+uint32_t FixedChunkPQTable::get_num_centers()
+{
+    return num_centers;
+}
+
 void FixedChunkPQTable::preprocess_query(float *query_vec)
 {
     for (uint32_t d = 0; d < ndims; d++)
@@ -187,16 +199,16 @@ void FixedChunkPQTable::preprocess_query(float *query_vec)
 // assumes pre-processed query
 void FixedChunkPQTable::populate_chunk_distances(const float *query_vec, float *dist_vec)
 {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (size_t chunk = 0; chunk < n_chunks; chunk++)
     {
         // sum (q-c)^2 for the dimensions associated with this chunk
-        float *chunk_dists = dist_vec + (256 * chunk);
+        float *chunk_dists = dist_vec + (num_centers * chunk);
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
-            for (size_t idx = 0; idx < 256; idx++)
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
+            for (size_t idx = 0; idx < num_centers; idx++)
             {
                 double diff = centers_dim_vec[idx] - (query_vec[j]);
                 chunk_dists[idx] += (float)(diff * diff);
@@ -212,7 +224,7 @@ float FixedChunkPQTable::l2_distance(const float *query_vec, uint8_t *base_vec)
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             float diff = centers_dim_vec[base_vec[chunk]] - (query_vec[j]);
             res += diff * diff;
         }
@@ -227,7 +239,7 @@ float FixedChunkPQTable::inner_product(const float *query_vec, uint8_t *base_vec
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             float diff = centers_dim_vec[base_vec[chunk]] * query_vec[j]; // assumes centroid is 0 to
                                                                           // prevent translation errors
             res += diff;
@@ -244,7 +256,7 @@ void FixedChunkPQTable::inflate_vector(uint8_t *base_vec, float *out_vec)
     {
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
             out_vec[j] = centers_dim_vec[base_vec[chunk]] + centroid[j];
         }
     }
@@ -252,16 +264,16 @@ void FixedChunkPQTable::inflate_vector(uint8_t *base_vec, float *out_vec)
 
 void FixedChunkPQTable::populate_chunk_inner_products(const float *query_vec, float *dist_vec)
 {
-    memset(dist_vec, 0, 256 * n_chunks * sizeof(float));
+    memset(dist_vec, 0, num_centers * n_chunks * sizeof(float));
     // chunk wise distance computation
     for (size_t chunk = 0; chunk < n_chunks; chunk++)
     {
         // sum (q-c)^2 for the dimensions associated with this chunk
-        float *chunk_dists = dist_vec + (256 * chunk);
+        float *chunk_dists = dist_vec + (num_centers * chunk);
         for (size_t j = chunk_offsets[chunk]; j < chunk_offsets[chunk + 1]; j++)
         {
-            const float *centers_dim_vec = tables_tr + (256 * j);
-            for (size_t idx = 0; idx < 256; idx++)
+            const float *centers_dim_vec = tables_tr + (num_centers * j);
+            for (size_t idx = 0; idx < num_centers; idx++)
             {
                 double prod = centers_dim_vec[idx] * query_vec[j]; // assumes that we are not
                                                                    // shifting the vectors to
@@ -340,6 +352,119 @@ void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_n
     }
 }
 
+// Trains the pivots of every chunk on its columns [chunk_offsets[i],
+// chunk_offsets[i + 1]) of train_data and writes them to the same columns of
+// full_pivot_data (num_centers * dim). Chunks are trained concurrently, as
+// many as the threads and PQ_TRAINING_MEMORY_BUDGET allow, and the k-means of
+// each chunk runs on its share of the threads. With kmeans_batch_size > 0,
+// mini-batch k-means replaces Lloyds. With warm_start the pivots already in
+// full_pivot_data seed k-means, else k-means++ does. If quantized_data is not
+// null, each training point's chunk is replaced there by its closest pivot.
+static void train_chunk_pivots(const float *train_data, const size_t num_train, const uint32_t dim,
+                               const uint32_t num_centers, const std::vector<uint32_t> &chunk_offsets,
+                               const size_t max_k_means_reps, const size_t kmeans_batch_size, const bool warm_start,
+                               float *full_pivot_data, float *quantized_data)
+{
+    const size_t num_pq_chunks = chunk_offsets.size() - 1;
+    size_t max_chunk_size = 0;
+    for (size_t i = 0; i < num_pq_chunks; i++)
+        max_chunk_size = (std::max)(max_chunk_size, (size_t)(chunk_offsets[i + 1] - chunk_offsets[i]));
+
+    // working memory of one chunk: its columns, closest centers and norms of
+    // the points, and the distance matrix of the points assigned at once
+    const size_t batch_size = kmeans_batch_size > 0 ? (std::max)(kmeans_batch_size, (size_t)num_centers) : 0;
+    const bool minibatch = batch_size > 0 && batch_size < num_train;
+    const size_t assigned_pts = minibatch ? batch_size : num_train;
+    const size_t chunk_bytes =
+        num_train * (max_chunk_size + 2) * sizeof(float) + assigned_pts * num_centers * sizeof(float);
+    const int num_threads = omp_get_max_threads();
+    const int chunk_threads = (int)(std::max)(
+        (size_t)1, (std::min)({(size_t)num_threads, num_pq_chunks, PQ_TRAINING_MEMORY_BUDGET / chunk_bytes}));
+    const int inner_threads = (std::max)(1, num_threads / chunk_threads);
+    const int max_active_levels = omp_get_max_active_levels();
+    if (chunk_threads > 1 && inner_threads > 1)
+        omp_set_max_active_levels(2);
+
+    diskann::cout << "Training " << num_pq_chunks << " chunks, " << chunk_threads << " at a time on "
+                  << inner_threads << " threads each" << (minibatch ? ", with mini-batch k-means" : "") << std::endl;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(chunk_threads)
+    for (int64_t i = 0; i < (int64_t)num_pq_chunks; i++)
+    {
+        omp_set_num_threads(inner_threads);
+        size_t cur_chunk_size = chunk_offsets[i + 1] - chunk_offsets[i];
+        if (cur_chunk_size == 0)
+            continue;
+        std::unique_ptr<float[]> cur_pivot_data = std::make_unique<float[]>(num_centers * cur_chunk_size);
+        std::unique_ptr<float[]> cur_data = std::make_unique<float[]>(num_train * cur_chunk_size);
+        std::unique_ptr<uint32_t[]> closest_center = std::make_unique<uint32_t[]>(num_train);
+
+#pragma omp parallel for schedule(static, 65536)
+        for (int64_t j = 0; j < (int64_t)num_train; j++)
+        {
+            std::memcpy(cur_data.get() + j * cur_chunk_size, train_data + j * dim + chunk_offsets[i],
+                        cur_chunk_size * sizeof(float));
+        }
+
+        if (warm_start)
+        {
+            for (uint64_t j = 0; j < num_centers; j++)
+            {
+                std::memcpy(cur_pivot_data.get() + j * cur_chunk_size, full_pivot_data + j * dim + chunk_offsets[i],
+                            cur_chunk_size * sizeof(float));
+            }
+        }
+        else if (minibatch)
+        {
+            // seed from a random mini-batch rather than the whole set
+            std::vector<uint32_t> seed_ids(num_train);
+            std::iota(seed_ids.begin(), seed_ids.end(), 0);
+            std::random_device rd;
+            std::mt19937 generator(rd());
+            std::shuffle(seed_ids.begin(), seed_ids.end(), generator);
+            std::unique_ptr<float[]> seed_data = std::make_unique<float[]>(batch_size * cur_chunk_size);
+            for (size_t j = 0; j < batch_size; j++)
+            {
+                std::memcpy(seed_data.get() + j * cur_chunk_size,
+                            cur_data.get() + (size_t)seed_ids[j] * cur_chunk_size, cur_chunk_size * sizeof(float));
+            }
+            kmeans::kmeanspp_selecting_pivots(seed_data.get(), batch_size, cur_chunk_size,
+                                              cur_pivot_data.get(), num_centers);
+        }
+        else
+        {
+            kmeans::kmeanspp_selecting_pivots(cur_data.get(), num_train, cur_chunk_size, cur_pivot_data.get(),
+                                              num_centers);
+        }
+
+        if (minibatch)
+            kmeans::run_minibatch_kmeans(cur_data.get(), num_train, cur_chunk_size, cur_pivot_data.get(), num_centers,
+                                         batch_size, max_k_means_reps * MINIBATCH_ITERS_PER_KMEANS_REP, warm_start,
+                                         quantized_data != nullptr ? closest_center.get() : NULL);
+        else
+            kmeans::run_lloyds(cur_data.get(), num_train, cur_chunk_size, cur_pivot_data.get(), num_centers,
+                               max_k_means_reps, NULL, closest_center.get());
+
+        for (uint64_t j = 0; j < num_centers; j++)
+        {
+            std::memcpy(full_pivot_data + j * dim + chunk_offsets[i], cur_pivot_data.get() + j * cur_chunk_size,
+                        cur_chunk_size * sizeof(float));
+        }
+
+        if (quantized_data != nullptr)
+        {
+            for (size_t j = 0; j < num_train; j++)
+            {
+                std::memcpy(quantized_data + j * dim + chunk_offsets[i],
+                            cur_pivot_data.get() + (size_t)closest_center[j] * cur_chunk_size,
+                            cur_chunk_size * sizeof(float));
+            }
+        }
+    }
+
+    omp_set_max_active_levels(max_active_levels);
+}
+
 // given training data in train_data of dimensions num_train * dim, generate
 // PQ pivots using k-means algorithm to partition the co-ordinates into
 // num_pq_chunks (if it divides dimension, else rounded) chunks, and runs
@@ -347,7 +472,7 @@ void pq_dist_lookup(const uint8_t *pq_ids, const size_t n_pts, const size_t pq_n
 // file pq_pivots_path as a s num_centers*dim floating point binary file
 int generate_pq_pivots(const float *const passed_train_data, size_t num_train, uint32_t dim, uint32_t num_centers,
                        uint32_t num_pq_chunks, uint32_t max_k_means_reps, std::string pq_pivots_path,
-                       bool make_zero_mean)
+                       bool make_zero_mean, size_t kmeans_batch_size)
 {
     if (num_pq_chunks > dim)
     {
@@ -448,38 +573,8 @@ int generate_pq_pivots(const float *const passed_train_data, size_t num_train, u
     chunk_offsets.push_back(dim);
 
     full_pivot_data.reset(new float[num_centers * dim]);
-
-    for (size_t i = 0; i < num_pq_chunks; i++)
-    {
-        size_t cur_chunk_size = chunk_offsets[i + 1] - chunk_offsets[i];
-
-        if (cur_chunk_size == 0)
-            continue;
-        std::unique_ptr<float[]> cur_pivot_data = std::make_unique<float[]>(num_centers * cur_chunk_size);
-        std::unique_ptr<float[]> cur_data = std::make_unique<float[]>(num_train * cur_chunk_size);
-        std::unique_ptr<uint32_t[]> closest_center = std::make_unique<uint32_t[]>(num_train);
-
-        diskann::cout << "Processing chunk " << i << " with dimensions [" << chunk_offsets[i] << ", "
-                      << chunk_offsets[i + 1] << ")" << std::endl;
-
-#pragma omp parallel for schedule(static, 65536)
-        for (int64_t j = 0; j < (int64_t)num_train; j++)
-        {
-            std::memcpy(cur_data.get() + j * cur_chunk_size, train_data.get() + j * dim + chunk_offsets[i],
-                        cur_chunk_size * sizeof(float));
-        }
-
-        kmeans::kmeanspp_selecting_pivots(cur_data.get(), num_train, cur_chunk_size, cur_pivot_data.get(), num_centers);
-
-        kmeans::run_lloyds(cur_data.get(), num_train, cur_chunk_size, cur_pivot_data.get(), num_centers,
-                           max_k_means_reps, NULL, closest_center.get());
-
-        for (uint64_t j = 0; j < num_centers; j++)
-        {
-            std::memcpy(full_pivot_data.get() + j * dim + chunk_offsets[i], cur_pivot_data.get() + j * cur_chunk_size,
-                        cur_chunk_size * sizeof(float));
-        }
-    }
+    train_chunk_pivots(train_data.get(), num_train, dim, num_centers, chunk_offsets, max_k_means_reps,
+                       kmeans_batch_size, false, full_pivot_data.get(), nullptr);
 
     std::vector<size_t> cumul_bytes(4, 0);
     cumul_bytes[0] = METADATA_SIZE;
@@ -498,7 +593,8 @@ int generate_pq_pivots(const float *const passed_train_data, size_t num_train, u
 }
 
 int generate_opq_pivots(const float *passed_train_data, size_t num_train, uint32_t dim, uint32_t num_centers,
-                        uint32_t num_pq_chunks, std::string opq_pivots_path, bool make_zero_mean)
+                        uint32_t num_pq_chunks, std::string opq_pivots_path, bool make_zero_mean,
+                        size_t kmeans_batch_size)
 {
     if (num_pq_chunks > dim)
     {
@@ -613,57 +709,9 @@ int generate_opq_pivots(const float *passed_train_data, size_t num_train, uint32
                     (MKL_INT)dim);
 
         // compute the PQ pivots on the rotated space
-        for (size_t i = 0; i < num_pq_chunks; i++)
-        {
-            size_t cur_chunk_size = chunk_offsets[i + 1] - chunk_offsets[i];
-
-            if (cur_chunk_size == 0)
-                continue;
-            std::unique_ptr<float[]> cur_pivot_data = std::make_unique<float[]>(num_centers * cur_chunk_size);
-            std::unique_ptr<float[]> cur_data = std::make_unique<float[]>(num_train * cur_chunk_size);
-            std::unique_ptr<uint32_t[]> closest_center = std::make_unique<uint32_t[]>(num_train);
-
-            diskann::cout << "Processing chunk " << i << " with dimensions [" << chunk_offsets[i] << ", "
-                          << chunk_offsets[i + 1] << ")" << std::endl;
-
-#pragma omp parallel for schedule(static, 65536)
-            for (int64_t j = 0; j < (int64_t)num_train; j++)
-            {
-                std::memcpy(cur_data.get() + j * cur_chunk_size, rotated_train_data.get() + j * dim + chunk_offsets[i],
-                            cur_chunk_size * sizeof(float));
-            }
-
-            if (rnd == 0)
-            {
-                kmeans::kmeanspp_selecting_pivots(cur_data.get(), num_train, cur_chunk_size, cur_pivot_data.get(),
-                                                  num_centers);
-            }
-            else
-            {
-                for (uint64_t j = 0; j < num_centers; j++)
-                {
-                    std::memcpy(cur_pivot_data.get() + j * cur_chunk_size,
-                                full_pivot_data.get() + j * dim + chunk_offsets[i], cur_chunk_size * sizeof(float));
-                }
-            }
-
-            uint32_t num_lloyds_iters = 8;
-            kmeans::run_lloyds(cur_data.get(), num_train, cur_chunk_size, cur_pivot_data.get(), num_centers,
-                               num_lloyds_iters, NULL, closest_center.get());
-
-            for (uint64_t j = 0; j < num_centers; j++)
-            {
-                std::memcpy(full_pivot_data.get() + j * dim + chunk_offsets[i],
-                            cur_pivot_data.get() + j * cur_chunk_size, cur_chunk_size * sizeof(float));
-            }
-
-            for (size_t j = 0; j < num_train; j++)
-            {
-                std::memcpy(rotated_and_quantized_train_data.get() + j * dim + chunk_offsets[i],
-                            cur_pivot_data.get() + (size_t)closest_center[j] * cur_chunk_size,
-                            cur_chunk_size * sizeof(float));
-            }
-        }
+        const uint32_t num_lloyds_iters = 8;
+        train_chunk_pivots(rotated_train_data.get(), num_train, dim, num_centers, chunk_offsets, num_lloyds_iters,
+                           kmeans_batch_size, rnd > 0, full_pivot_data.get(), rotated_and_quantized_train_data.get());
 
         // compute the correlation matrix between the original data and the
         // quantized data to compute the new rotation
@@ -963,7 +1011,7 @@ template <typename T>
 void generate_quantized_data(const std::string &data_file_to_use, const std::string &pq_pivots_path,
                              const std::string &pq_compressed_vectors_path, diskann::Metric compareMetric,
                              const double p_val, const size_t num_pq_chunks, const bool use_opq,
-                             const std::string &codebook_prefix)
+                             const std::string &codebook_prefix, const uint32_t num_centers)
 {
     size_t train_size, train_dim;
     float *train_data;
@@ -981,12 +1029,12 @@ void generate_quantized_data(const std::string &data_file_to_use, const std::str
 
         if (!use_opq)
         {
-            generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks,
+            generate_pq_pivots(train_data, train_size, (uint32_t)train_dim, num_centers, (uint32_t)num_pq_chunks,
                                NUM_KMEANS_REPS_PQ, pq_pivots_path, make_zero_mean);
         }
         else
         {
-            generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks,
+            generate_opq_pivots(train_data, train_size, (uint32_t)train_dim, num_centers, (uint32_t)num_pq_chunks,
                                 pq_pivots_path, make_zero_mean);
         }
         delete[] train_data;
@@ -995,7 +1043,7 @@ void generate_quantized_data(const std::string &data_file_to_use, const std::str
     {
         diskann::cout << "Skip Training with predefined pivots in: " << pq_pivots_path << std::endl;
     }
-    generate_pq_data_from_pivots<T>(data_file_to_use, NUM_PQ_CENTROIDS, (uint32_t)num_pq_chunks, pq_pivots_path,
+    generate_pq_data_from_pivots<T>(data_file_to_use, num_centers, (uint32_t)num_pq_chunks, pq_pivots_path,
                                     pq_compressed_vectors_path, use_opq);
 }
 
@@ -1034,24 +1082,63 @@ template DISKANN_DLLEXPORT void generate_disk_quantized_data<float>(const std::s
                                                                     diskann::Metric compareMetric, const double p_val,
                                                                     size_t &disk_pq_dims);
 
+std::string get_pq_search_prefix(const std::string &index_file, const uint64_t num_pq_chunks, const bool use_opq,
+                                 const bool fast_scan)
+{
+    std::string suffix = use_opq ? "_opq" : "_pq";
+    if (fast_scan)
+        suffix += "4b";
+    return index_file + suffix + std::to_string(num_pq_chunks);
+}
+
+template <typename T>
+void generate_pq_search_data(const std::string &index_file, const diskann::Metric metric,
+                             const uint64_t num_pq_chunks, const bool use_opq, const bool fast_scan)
+{
+    const std::string data_file = index_file + ".data";
+    const std::string prefix = get_pq_search_prefix(index_file, num_pq_chunks, use_opq, fast_scan);
+    size_t num_points, dim;
+    diskann::get_bin_metadata(data_file, num_points, dim);
+
+    const double p_val = std::min(1.0, ((double)MAX_PQ_TRAINING_SET_SIZE / (double)num_points));
+    generate_quantized_data<T>(data_file, prefix + "_pivots.bin", prefix + "_compressed.bin", metric, p_val,
+                               num_pq_chunks, use_opq, "", fast_scan ? NUM_PQ4_CENTROIDS : NUM_PQ_CENTROIDS);
+}
+
+template DISKANN_DLLEXPORT void generate_pq_search_data<int8_t>(const std::string &index_file,
+                                                                const diskann::Metric metric,
+                                                                const uint64_t num_pq_chunks, const bool use_opq,
+                                                                const bool fast_scan);
+template DISKANN_DLLEXPORT void generate_pq_search_data<uint8_t>(const std::string &index_file,
+                                                                 const diskann::Metric metric,
+                                                                 const uint64_t num_pq_chunks, const bool use_opq,
+                                                                 const bool fast_scan);
+template DISKANN_DLLEXPORT void generate_pq_search_data<float>(const std::string &index_file,
+                                                               const diskann::Metric metric,
+                                                               const uint64_t num_pq_chunks, const bool use_opq,
+                                                               const bool fast_scan);
+
 template DISKANN_DLLEXPORT void generate_quantized_data<int8_t>(const std::string &data_file_to_use,
                                                                 const std::string &pq_pivots_path,
                                                                 const std::string &pq_compressed_vectors_path,
                                                                 diskann::Metric compareMetric, const double p_val,
                                                                 const size_t num_pq_chunks, const bool use_opq,
-                                                                const std::string &codebook_prefix);
+                                                                const std::string &codebook_prefix,
+                                                               const uint32_t num_centers);
 
 template DISKANN_DLLEXPORT void generate_quantized_data<uint8_t>(const std::string &data_file_to_use,
                                                                  const std::string &pq_pivots_path,
                                                                  const std::string &pq_compressed_vectors_path,
                                                                  diskann::Metric compareMetric, const double p_val,
                                                                  const size_t num_pq_chunks, const bool use_opq,
-                                                                 const std::string &codebook_prefix);
+                                                                 const std::string &codebook_prefix,
+                                                                 const uint32_t num_centers);
 
 template DISKANN_DLLEXPORT void generate_quantized_data<float>(const std::string &data_file_to_use,
                                                                const std::string &pq_pivots_path,
                                                                const std::string &pq_compressed_vectors_path,
                                                                diskann::Metric compareMetric, const double p_val,
                                                                const size_t num_pq_chunks, const bool use_opq,
-                                                               const std::string &codebook_prefix);
+                                                               const std::string &codebook_prefix,
+                                                               const uint32_t num_centers);
 } // namespace diskann
@@ -0,0 +1,152 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include "pq_fast_scan.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifdef USE_AVX2
+#include <immintrin.h>
+#endif
+
+namespace diskann
+{
+void pack_pq4_codes(const uint8_t *codes, const size_t n_pts, const size_t n_chunks, uint8_t *packed)
+{
+    const size_t code_bytes = pq4_code_bytes(n_chunks);
+    memset(packed, 0, n_pts * code_bytes);
+    for (size_t i = 0; i < n_pts; i++)
+    {
+        const uint8_t *point_codes = codes + i * n_chunks;
+        uint8_t *point_packed = packed + i * code_bytes;
+        for (size_t c = 0; c < n_chunks; c++)
+            point_packed[c / 2] |= (uint8_t)((point_codes[c] & 0x0f) << (4 * (c % 2)));
+    }
+}
+
+void quantize_fast_scan_lut(const float *chunk_dists, const size_t n_chunks, uint8_t *lut, float &scale, float &bias)
+{
+    // one scale for all chunks, so that quantized entries can be summed, and
+    // one offset per chunk, folded into bias
+    float max_range = 0;
+    bias = 0;
+    for (size_t c = 0; c < n_chunks; c++)
+    {
+        const float *dists = chunk_dists + c * NUM_PQ4_CENTROIDS;
+        const auto min_max = std::minmax_element(dists, dists + NUM_PQ4_CENTROIDS);
+        bias += *min_max.first;
+        max_range = (std::max)(max_range, *min_max.second - *min_max.first);
+    }
+    scale = max_range > 0 ? max_range / 255.0f : 1.0f;
+
+    memset(lut, 0, 2 * NUM_PQ4_CENTROIDS * pq4_code_bytes(n_chunks));
+    for (size_t c = 0; c < n_chunks; c++)
+    {
+        const float *dists = chunk_dists + c * NUM_PQ4_CENTROIDS;
+        const float min_dist = *std::min_element(dists, dists + NUM_PQ4_CENTROIDS);
+        uint8_t *chunk_lut = lut + c * NUM_PQ4_CENTROIDS;
+        for (size_t k = 0; k < NUM_PQ4_CENTROIDS; k++)
+            chunk_lut[k] = (uint8_t)(std::min)(255.0f, std::round((dists[k] - min_dist) / scale));
+    }
+}
+
+void aggregate_fast_scan_codes(const uint32_t *ids, const size_t n_ids, const uint8_t *packed_codes,
+                               const size_t n_chunks, uint8_t *out)
+{
+    const size_t code_bytes = pq4_code_bytes(n_chunks);
+    const size_t block_bytes = FAST_SCAN_BLOCK_SIZE * code_bytes;
+    memset(out, 0, fast_scan_codes_bytes(n_ids, n_chunks));
+    for (size_t i = 0; i < n_ids; i++)
+    {
+        const uint8_t *point_packed = packed_codes + (size_t)ids[i] * code_bytes;
+        const size_t slot = i % FAST_SCAN_BLOCK_SIZE;
+        const uint32_t shift = slot < 16 ? 0 : 4;
+        uint8_t *block = out + (i / FAST_SCAN_BLOCK_SIZE) * block_bytes + (slot & 15);
+        for (size_t p = 0; p < code_bytes; p++)
+        {
+            block[p * 32] |= (uint8_t)((point_packed[p] & 0x0f) << shift);
+            block[p * 32 + 16] |= (uint8_t)((point_packed[p] >> 4) << shift);
+        }
+    }
+}
+
+void fast_scan_dist_lookup_scalar(const uint8_t *blocked_codes, const size_t n_pts, const size_t n_chunks,
+                                  const uint8_t *lut, const float scale, const float bias, float *dists_out)
+{
+    const size_t code_bytes = pq4_code_bytes(n_chunks);
+    const size_t block_bytes = FAST_SCAN_BLOCK_SIZE * code_bytes;
+    for (size_t i = 0; i < n_pts; i++)
+    {
+        const uint8_t *block = blocked_codes + (i / FAST_SCAN_BLOCK_SIZE) * block_bytes;
+        const size_t slot = i % FAST_SCAN_BLOCK_SIZE;
+        const uint32_t shift = slot < 16 ? 0 : 4;
+        uint32_t sum = 0;
+        for (size_t p = 0; p < code_bytes; p++)
+        {
+            const uint8_t even = (block[p * 32 + (slot & 15)] >> shift) & 0x0f;
+            const uint8_t odd = (block[p * 32 + 16 + (slot & 15)] >> shift) & 0x0f;
+            sum += lut[p * 32 + even] + lut[p * 32 + 16 + odd];
+        }
+        dists_out[i] = bias + scale * (float)sum;
+    }
+}
+
+void fast_scan_dist_lookup(const uint8_t *blocked_codes, const size_t n_pts, const size_t n_chunks, const uint8_t *lut,
+                           const float scale, const float bias, float *dists_out)
+{
+#ifdef USE_AVX2
+    const size_t code_bytes = pq4_code_bytes(n_chunks);
+    const size_t block_bytes = FAST_SCAN_BLOCK_SIZE * code_bytes;
+    const size_t n_blocks = DIV_ROUND_UP(n_pts, FAST_SCAN_BLOCK_SIZE);
+    float block_dists[FAST_SCAN_BLOCK_SIZE];
+
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256 scale_v = _mm256_set1_ps(scale);
+    const __m256 bias_v = _mm256_set1_ps(bias);
+    for (size_t b = 0; b < n_blocks; b++)
+    {
+        const uint8_t *block = blocked_codes + b * block_bytes;
+        // Lane 0 of each 16-bit accumulator sums the even chunks, lane 1 the
+        // odd ones, for 8 points per accumulator. A lane gains at most 255
+        // per code byte, so after FAST_SCAN_FLUSH_BYTES bytes the two lanes
+        // together stay below 65536; they are then folded into 32-bit sums.
+        __m256i sums32[4] = {zero, zero, zero, zero};
+        for (size_t start = 0; start < code_bytes; start += FAST_SCAN_FLUSH_BYTES)
+        {
+            const size_t end = (std::min)(code_bytes, start + FAST_SCAN_FLUSH_BYTES);
+            __m256i acc[4] = {zero, zero, zero, zero};
+            for (size_t p = start; p < end; p++)
+            {
+                const __m256i table = _mm256_loadu_si256((const __m256i *)(lut + p * 32));
+                const __m256i codes = _mm256_loadu_si256((const __m256i *)(block + p * 32));
+                const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(codes, low_mask));
+                const __m256i hi =
+                    _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(codes, 4), low_mask));
+                acc[0] = _mm256_add_epi16(acc[0], _mm256_unpacklo_epi8(lo, zero));
+                acc[1] = _mm256_add_epi16(acc[1], _mm256_unpackhi_epi8(lo, zero));
+                acc[2] = _mm256_add_epi16(acc[2], _mm256_unpacklo_epi8(hi, zero));
+                acc[3] = _mm256_add_epi16(acc[3], _mm256_unpackhi_epi8(hi, zero));
+            }
+            for (size_t a = 0; a < 4; a++)
+            {
+                const __m128i folded =
+                    _mm_add_epi16(_mm256_castsi256_si128(acc[a]), _mm256_extracti128_si256(acc[a], 1));
+                sums32[a] = _mm256_add_epi32(sums32[a], _mm256_cvtepu16_epi32(folded));
+            }
+        }
+        for (size_t a = 0; a < 4; a++)
+        {
+            const __m256 sums_ps = _mm256_cvtepi32_ps(sums32[a]);
+            _mm256_storeu_ps(block_dists + a * 8, _mm256_fmadd_ps(sums_ps, scale_v, bias_v));
+        }
+        const size_t n_block_pts = (std::min)((size_t)FAST_SCAN_BLOCK_SIZE, n_pts - b * FAST_SCAN_BLOCK_SIZE);
+        memcpy(dists_out + b * FAST_SCAN_BLOCK_SIZE, block_dists, n_block_pts * sizeof(float));
+    }
+#else
+    fast_scan_dist_lookup_scalar(blocked_codes, n_pts, n_chunks, lut, scale, bias, dists_out);
+#endif
+}
+} // namespace diskann
@@ -6,6 +6,10 @@
 #include "timer.h"
 #include "pq_flash_index.h"
 #include "cosine_similarity.h"
+#include "label_signature.h"
+#include "sector_labels.h"
+#include "pq_fast_scan.h"
+#include "search_results.h"
 
 #ifdef _WINDOWS
 #include "windows_aligned_file_reader.h"
@@ -58,6 +62,12 @@ template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
     {
         delete[] data;
     }
+#else
+    // packed 4-bit codes are a copy of the mapped file
+    if (_pq_fast_scan && data != nullptr)
+    {
+        delete[] data;
+    }
 #endif
 
     if (_centroid_data != nullptr)
@@ -68,6 +78,10 @@ template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
         delete[] _nhood_cache_buf;
         diskann::aligned_free(_coord_cache_buf);
     }
+    if (_label_cache_buf != nullptr)
+    {
+        delete[] _label_cache_buf;
+    }
 
     if (_load_flag)
     {
@@ -89,6 +103,10 @@ template <typename T, typename LabelT> PQFlashIndex<T, LabelT>::~PQFlashIndex()
     {
         delete[] _pts_to_labels;
     }
+    if (_pts_to_label_signature != nullptr)
+    {
+        delete[] _pts_to_label_signature;
+    }
 }
 
 template <typename T, typename LabelT> inline uint64_t PQFlashIndex<T, LabelT>::get_node_sector(uint64_t node_id)
@@ -113,6 +131,11 @@ template <typename T, typename LabelT> inline T *PQFlashIndex<T, LabelT>::offset
     return (T *)(node_buf);
 }
 
+template <typename T, typename LabelT> inline uint32_t *PQFlashIndex<T, LabelT>::offset_to_node_labels(char *node_buf)
+{
+    return (uint32_t *)(node_buf + _disk_bytes_per_point) + _max_degree + 1;
+}
+
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::setup_thread_data(uint64_t nthreads, uint64_t visited_reserve)
 {
@@ -126,6 +149,8 @@ void PQFlashIndex<T, LabelT>::setup_thread_data(uint64_t nthreads, uint64_t visi
             SSDThreadData<T> *data = new SSDThreadData<T>(this->_aligned_dim, visited_reserve);
             this->reader->register_thread();
             data->ctx = this->reader->get_ctx();
+            this->reader->register_buffer(data->scratch.sector_scratch,
+                                          defaults::MAX_N_SECTOR_READS * defaults::SECTOR_LEN);
             this->_thread_data.push(data);
         }
     }
@@ -135,7 +160,8 @@ void PQFlashIndex<T, LabelT>::setup_thread_data(uint64_t nthreads, uint64_t visi
 template <typename T, typename LabelT>
 std::vector<bool> PQFlashIndex<T, LabelT>::read_nodes(const std::vector<uint32_t> &node_ids,
                                                       std::vector<T *> &coord_buffers,
-                                                      std::vector<std::pair<uint32_t, uint32_t *>> &nbr_buffers)
+                                                      std::vector<std::pair<uint32_t, uint32_t *>> &nbr_buffers,
+                                                      std::vector<uint32_t *> *label_buffers)
 {
     std::vector<AlignedRead> read_reqs;
     std::vector<bool> retval(node_ids.size(), true);
@@ -189,6 +215,11 @@ std::vector<bool> PQFlashIndex<T, LabelT>::read_nodes(const std::vector<uint32_t
             nbr_buffers[i].first = num_nbrs;
             memcpy(nbr_buffers[i].second, node_nhood + 1, num_nbrs * sizeof(uint32_t));
         }
+
+        if (_max_node_labels > 0 && label_buffers != nullptr && (*label_buffers)[i] != nullptr)
+        {
+            memcpy((*label_buffers)[i], offset_to_node_labels(node_buf), (1 + _max_node_labels) * sizeof(uint32_t));
+        }
     }
 
     aligned_free(buf);
@@ -215,6 +246,10 @@ template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::load_cache_
     diskann::alloc_aligned((void **)&_coord_cache_buf, coord_cache_buf_len * sizeof(T), 8 * sizeof(T));
     memset(_coord_cache_buf, 0, coord_cache_buf_len * sizeof(T));
 
+    // Allocate space for label cache, if labels are read from the sectors
+    if (_max_node_labels > 0)
+        _label_cache_buf = new uint32_t[num_cached_nodes * (1 + _max_node_labels)];
+
     size_t BLOCK_SIZE = 8;
     size_t num_blocks = DIV_ROUND_UP(num_cached_nodes, BLOCK_SIZE);
     for (size_t block = 0; block < num_blocks; block++)
@@ -226,15 +261,19 @@ template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::load_cache_
         std::vector<uint32_t> nodes_to_read;
         std::vector<T *> coord_buffers;
         std::vector<std::pair<uint32_t, uint32_t *>> nbr_buffers;
+        std::vector<uint32_t *> label_buffers;
         for (size_t node_idx = start_idx; node_idx < end_idx; node_idx++)
         {
             nodes_to_read.push_back(node_list[node_idx]);
             coord_buffers.push_back(_coord_cache_buf + node_idx * _aligned_dim);
             nbr_buffers.emplace_back(0, _nhood_cache_buf + node_idx * (_max_degree + 1));
+            if (_label_cache_buf != nullptr)
+                label_buffers.push_back(_label_cache_buf + node_idx * (1 + _max_node_labels));
         }
 
         // issue the reads
-        auto read_status = read_nodes(nodes_to_read, coord_buffers, nbr_buffers);
+        auto read_status = read_nodes(nodes_to_read, coord_buffers, nbr_buffers,
+                                      _label_cache_buf != nullptr ? &label_buffers : nullptr);
 
         // check for success and insert into the cache.
         for (size_t i = 0; i < read_status.size(); i++)
@@ -243,6 +282,8 @@ template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::load_cache_
             {
                 _coord_cache.insert(std::make_pair(nodes_to_read[i], coord_buffers[i]));
                 _nhood_cache.insert(std::make_pair(nodes_to_read[i], nbr_buffers[i]));
+                if (_label_cache_buf != nullptr)
+                    _label_cache.insert(std::make_pair(nodes_to_read[i], label_buffers[i]));
             }
         }
     }
@@ -343,6 +384,112 @@ void PQFlashIndex<T, LabelT>::generate_cache_list_from_sample_queries(std::strin
     diskann::aligned_free(samples);
 }
 
+#ifndef EXEC_ENV_OLS
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::generate_cache_list_from_filtered_sample_queries(
+    const std::string &sample_bin, const std::vector<std::vector<std::string>> &sample_filters, uint64_t l_search,
+    uint64_t beamwidth, uint64_t cache_budget_bytes, uint32_t nthreads, std::vector<uint32_t> &node_list)
+{
+    node_list.clear();
+
+    // memory held per cached node by load_cache_list, including the map entries
+    const uint64_t bytes_per_node = (_max_degree + 1) * sizeof(uint32_t) + _aligned_dim * sizeof(T) +
+                                    sizeof(std::pair<uint32_t, std::pair<uint32_t, uint32_t *>>) +
+                                    sizeof(std::pair<uint32_t, T *>) +
+                                    (_max_node_labels > 0 ? (1 + _max_node_labels) * sizeof(uint32_t) +
+                                                                sizeof(std::pair<uint32_t, uint32_t *>)
+                                                          : 0);
+    uint64_t num_nodes_to_cache = std::min(cache_budget_bytes / bytes_per_node, this->_num_points);
+    if (num_nodes_to_cache == 0)
+        return;
+
+    uint64_t sample_num, sample_dim, sample_aligned_dim;
+    T *samples;
+    if (file_exists(sample_bin))
+    {
+        diskann::load_aligned_bin<T>(sample_bin, samples, sample_num, sample_dim, sample_aligned_dim);
+    }
+    else
+    {
+        diskann::cerr << "Sample bin file not found. Not generating cache." << std::endl;
+        return;
+    }
+    if (!sample_filters.empty() && sample_filters.size() != sample_num)
+    {
+        diskann::aligned_free(samples);
+        throw ANNException("Number of sample filters (" + std::to_string(sample_filters.size()) +
+                               ") does not match number of sample queries (" + std::to_string(sample_num) + ")",
+                           -1, __FUNCSIG__, __FILE__, __LINE__);
+    }
+
+    // Queries whose labels are all unknown to the index return nothing and
+    // are skipped; unknown labels of the other queries are dropped.
+    std::vector<std::vector<LabelT>> sample_labels(sample_num);
+    std::vector<bool> skip_sample(sample_num, false);
+    uint64_t num_skipped = 0;
+    for (uint64_t i = 0; i < sample_filters.size(); i++)
+    {
+        for (const auto &raw_label : sample_filters[i])
+        {
+            auto label_iter = _label_map.find(raw_label);
+            if (label_iter != _label_map.end())
+                sample_labels[i].push_back(label_iter->second);
+        }
+        if (!sample_filters[i].empty() && sample_labels[i].empty())
+        {
+            skip_sample[i] = true;
+            num_skipped++;
+        }
+    }
+    if (num_skipped > 0)
+        diskann::cout << "Skipping " << num_skipped << " sample queries with no known label" << std::endl;
+
+    this->_count_visited_nodes = true;
+    this->_node_visit_counter.clear();
+    this->_node_visit_counter.resize(this->_num_points);
+    for (uint32_t i = 0; i < _node_visit_counter.size(); i++)
+    {
+        this->_node_visit_counter[i].first = i;
+        this->_node_visit_counter[i].second = 0;
+    }
+
+    std::vector<uint64_t> tmp_result_ids_64(sample_num, 0);
+    std::vector<float> tmp_result_dists(sample_num, 0);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(nthreads)
+    for (int64_t i = 0; i < (int64_t)sample_num; i++)
+    {
+        if (skip_sample[i])
+            continue;
+        try
+        {
+            cached_beam_search_multi_filters(samples + (i * sample_aligned_dim), 1, l_search,
+                                             tmp_result_ids_64.data() + i, tmp_result_dists.data() + i, beamwidth,
+                                             sample_labels[i]);
+        }
+        catch (const ANNException &)
+        {
+            // no medoid for any of the labels, nothing to count
+        }
+    }
+
+    std::sort(this->_node_visit_counter.begin(), _node_visit_counter.end(),
+              [](std::pair<uint32_t, uint32_t> &left, std::pair<uint32_t, uint32_t> &right) {
+                  return left.second > right.second;
+              });
+    node_list.reserve(num_nodes_to_cache);
+    for (uint64_t i = 0; i < num_nodes_to_cache && this->_node_visit_counter[i].second > 0; i++)
+    {
+        node_list.push_back(this->_node_visit_counter[i].first);
+    }
+    this->_count_visited_nodes = false;
+
+    diskann::cout << "Caching " << node_list.size() << " nodes (" << node_list.size() * bytes_per_node / (1024 * 1024)
+                  << " MB) visited by " << sample_num - num_skipped << " filtered sample queries" << std::endl;
+    diskann::aligned_free(samples);
+}
+#endif
+
 template <typename T, typename LabelT>
 void PQFlashIndex<T, LabelT>::cache_bfs_levels(uint64_t num_nodes_to_cache, std::vector<uint32_t> &node_list,
                                                const bool shuffle)
@@ -547,6 +694,31 @@ void PQFlashIndex<T, LabelT>::generate_random_labels(std::vector<LabelT> &labels
     labels.clear();
     labels.resize(num_labels);
 
+    if (_pts_to_labels == nullptr)
+    {
+        // labels are in the sectors; draw from the per-label point counts,
+        // the same distribution as a random entry of the label lists
+        std::vector<LabelT> label_ids;
+        std::vector<double> label_weights;
+        for (const auto &label_count : _label_num_pts)
+        {
+            label_ids.push_back(label_count.first);
+            label_weights.push_back((double)label_count.second);
+        }
+        if (label_ids.empty())
+        {
+            std::stringstream stream;
+            stream << "No labels found in data. Not sampling random labels ";
+            diskann::cerr << stream.str() << std::endl;
+            throw diskann::ANNException(stream.str(), -1, __FUNCSIG__, __FILE__, __LINE__);
+        }
+        std::mt19937 gen(rd());
+        std::discrete_distribution<size_t> dis(label_weights.begin(), label_weights.end());
+        for (uint32_t i = 0; i < num_labels; i++)
+            labels[i] = label_ids[dis(gen)];
+        return;
+    }
+
     uint64_t num_total_labels = _pts_to_label_offsets[_num_points - 1] + _pts_to_label_counts[_num_points - 1];
     std::mt19937 gen(rd());
     if (num_total_labels == 0)
@@ -630,20 +802,53 @@ void PQFlashIndex<T, LabelT>::get_label_file_metadata(std::string map_file, uint
 }
 
 template <typename T, typename LabelT>
-inline bool PQFlashIndex<T, LabelT>::point_has_label(uint32_t point_id, LabelT label_id)
+inline uint32_t PQFlashIndex<T, LabelT>::common_filter_size(uint32_t point_id, const std::vector<LabelT> &filter_labels)
 {
     uint32_t start_vec = _pts_to_label_offsets[point_id];
     uint32_t num_lbls = _pts_to_label_counts[point_id];
-    bool ret_val = false;
+    uint32_t common_size = 0;
     for (uint32_t i = 0; i < num_lbls; i++)
     {
-        if (_pts_to_labels[start_vec + i] == label_id)
-        {
-            ret_val = true;
-            break;
-        }
+        const LabelT label = _pts_to_labels[start_vec + i];
+        if (_use_universal_label && label == _universal_filter_label)
+            return (uint32_t)filter_labels.size();
+        if (std::binary_search(filter_labels.begin(), filter_labels.end(), label))
+            common_size++;
     }
-    return ret_val;
+    return common_size;
+}
+
+template <typename T, typename LabelT>
+inline uint32_t PQFlashIndex<T, LabelT>::sector_filter_size(uint32_t point_id, const uint32_t *label_block,
+                                                            const std::vector<LabelT> &filter_labels)
+{
+    const std::vector<LabelT> *spilled = nullptr;
+    if (label_block_spilled(label_block, _max_node_labels))
+    {
+        auto iter = _spilled_labels.find(point_id);
+        if (iter != _spilled_labels.end())
+            spilled = &iter->second;
+    }
+    return label_block_filter_size(label_block, _max_node_labels, spilled, filter_labels, _use_universal_label,
+                                   _universal_filter_label);
+}
+
+template <typename T, typename LabelT>
+inline uint32_t PQFlashIndex<T, LabelT>::candidate_filter_size(uint32_t point_id,
+                                                               const std::vector<LabelT> &filter_labels,
+                                                               const std::vector<uint64_t> &label_masks)
+{
+    const uint64_t signature = _pts_to_label_signature[point_id];
+    if (_use_universal_label)
+    {
+        const uint64_t universal_mask = label_signature(_universal_filter_label);
+        if ((signature & universal_mask) == universal_mask)
+            return (uint32_t)filter_labels.size();
+    }
+    uint32_t common_size = 0;
+    for (const auto mask : label_masks)
+        common_size += (signature & mask) == mask;
+    return common_size;
 }
 
 template <typename T, typename LabelT>
@@ -683,20 +888,64 @@ void PQFlashIndex<T, LabelT>::parse_label_file(const std::string &label_file, si
             token.erase(std::remove(token.begin(), token.end(), '\r'), token.end());
             LabelT token_as_num = (LabelT)std::stoul(token);
             _pts_to_labels[labels_seen_so_far++] = (LabelT)token_as_num;
+            _label_num_pts[token_as_num]++;
             num_lbls_in_cur_pt++;
         }
 
         if (num_lbls_in_cur_pt == 0)
-        {
-            diskann::cout << "No label found for point " << line_cnt << std::endl;
-            exit(-1);
-        }
+            throw diskann::ANNException("No label found for point " + std::to_string(line_cnt) + " in " + label_file,
+                                        -1, __FUNCSIG__, __FILE__, __LINE__);
         line_cnt++;
     }
     infile.close();
     num_points_labels = line_cnt;
 }
 
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::parse_label_signatures(const std::string &label_file, size_t &num_points_labels)
+{
+    std::ifstream infile(label_file);
+    if (infile.fail())
+    {
+        throw diskann::ANNException(std::string("Failed to open file ") + label_file, -1);
+    }
+
+    _pts_to_label_signature = new uint64_t[_num_points];
+    memset(_pts_to_label_signature, 0, _num_points * sizeof(uint64_t));
+
+    std::string line;
+    uint32_t line_cnt = 0;
+    while (std::getline(infile, line) && line_cnt < _num_points)
+    {
+        std::vector<LabelT> point_labels = parse_label_line<LabelT>(line);
+        if (point_labels.empty())
+            throw diskann::ANNException("No label found for point " + std::to_string(line_cnt) + " in " + label_file,
+                                        -1, __FUNCSIG__, __FILE__, __LINE__);
+        _pts_to_label_signature[line_cnt] = label_signature(point_labels);
+        for (const LabelT label : point_labels)
+            _label_num_pts[label]++;
+        if (point_labels.size() > _max_node_labels)
+            _spilled_labels[line_cnt] = std::move(point_labels);
+        line_cnt++;
+    }
+    infile.close();
+    num_points_labels = line_cnt;
+}
+
+template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::set_pipelined_search(const bool pipelined)
+{
+    _pipelined_search = pipelined;
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::set_adaptive_search(const bool adaptive_beam_width, const float io_budget_factor)
+{
+    if (io_budget_factor < 0)
+        throw ANNException("io_budget_factor must not be negative", -1, __FUNCSIG__, __FILE__, __LINE__);
+    _adaptive_beam_width = adaptive_beam_width;
+    _io_budget_factor = io_budget_factor;
+}
+
 template <typename T, typename LabelT> void PQFlashIndex<T, LabelT>::set_universal_label(const LabelT &label)
 {
     _use_universal_label = true;
@@ -723,6 +972,31 @@ template <typename T, typename LabelT> int PQFlashIndex<T, LabelT>::load(uint32_
 #endif
 }
 
+#ifndef EXEC_ENV_OLS
+// Returns the number of label slots per node record of the disk index, or 0
+// if its labels are not stored in the sectors. The labels have to be parsed
+// before the rest of the metadata is read, so the header is peeked here.
+static uint64_t get_disk_index_max_node_labels(const std::string &disk_index_file)
+{
+    std::ifstream index_metadata(disk_index_file, std::ios::binary);
+    if (!index_metadata.is_open())
+        return 0;
+
+    uint32_t nr, nc;
+    READ_U32(index_metadata, nr);
+    READ_U32(index_metadata, nc);
+    std::vector<uint64_t> vals(nr);
+    index_metadata.read((char *)vals.data(), nr * sizeof(uint64_t));
+    if (!index_metadata || nr < 8)
+        return 0;
+
+    // npts, ndims, medoid, max_node_len, nnodes_per_sector, frozen_num,
+    // frozen_loc, reorder flag, [3 reorder fields], file size, [max labels]
+    const uint32_t labels_pos = vals[7] ? 12 : 9;
+    return nr > labels_pos ? vals[labels_pos] : 0;
+}
+#endif
+
 #ifdef EXEC_ENV_OLS
 template <typename T, typename LabelT>
 int PQFlashIndex<T, LabelT>::load_from_separate_paths(diskann::MemoryMappedFiles &files, uint32_t num_threads,
@@ -756,11 +1030,12 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
 
     this->_disk_index_file = _disk_index_file;
 
-    if (pq_file_num_centroids != 256)
+    if (pq_file_num_centroids != NUM_PQ_CENTROIDS && pq_file_num_centroids != NUM_PQ4_CENTROIDS)
     {
-        diskann::cout << "Error. Number of PQ centroids is not 256. Exiting." << std::endl;
+        diskann::cout << "Error. Number of PQ centroids is not 256 or 16. Exiting." << std::endl;
         return -1;
     }
+    _pq_fast_scan = pq_file_num_centroids == NUM_PQ4_CENTROIDS;
 
     this->_data_dim = pq_file_dim;
     // will change later if we use PQ on disk or if we are using
@@ -777,9 +1052,26 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
 
     this->_num_points = npts_u64;
     this->_n_chunks = nchunks_u64;
+    if (_pq_fast_scan)
+    {
+        // 4-bit codes are kept packed, two per byte, for fast scan lookups
+        uint8_t *packed_data = new uint8_t[_num_points * pq4_code_bytes(_n_chunks)];
+        pack_pq4_codes(this->data, _num_points, _n_chunks, packed_data);
+#ifndef EXEC_ENV_OLS
+        delete[] this->data;
+#endif
+        this->data = packed_data;
+    }
+#ifndef EXEC_ENV_OLS
+    _max_node_labels = get_disk_index_max_node_labels(_disk_index_file);
+#endif
     if (file_exists(labels_file))
     {
-        parse_label_file(labels_file, num_pts_in_label_file);
+        // with labels in the sectors, only their signatures are kept in memory
+        if (_max_node_labels > 0)
+            parse_label_signatures(labels_file, num_pts_in_label_file);
+        else
+            parse_label_file(labels_file, num_pts_in_label_file);
         assert(num_pts_in_label_file == this->_num_points);
         _label_map = load_label_map(labels_map_file);
         if (file_exists(labels_to_medoids))
@@ -938,6 +1230,8 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
     READ_U64(index_metadata, _max_node_len);
     READ_U64(index_metadata, _nnodes_per_sector);
     _max_degree = ((_max_node_len - _disk_bytes_per_point) / sizeof(uint32_t)) - 1;
+    if (_max_node_labels > 0)
+        _max_degree -= (uint32_t)(1 + _max_node_labels);
 
     if (_max_degree > defaults::MAX_GRAPH_DEGREE)
     {
@@ -977,7 +1271,11 @@ int PQFlashIndex<T, LabelT>::load_from_separate_paths(uint32_t num_threads, cons
     diskann::cout << "Disk-Index File Meta-data: ";
     diskann::cout << "# nodes per sector: " << _nnodes_per_sector;
     diskann::cout << ", max node len (bytes): " << _max_node_len;
-    diskann::cout << ", max node degree: " << _max_degree << std::endl;
+    diskann::cout << ", max node degree: " << _max_degree;
+    if (_max_node_labels > 0)
+        diskann::cout << ", label slots per node: " << _max_node_labels
+                      << ", points with spilled labels: " << _spilled_labels.size();
+    diskann::cout << std::endl;
 
 #ifdef EXEC_ENV_OLS
     delete[] bytes;
@@ -1143,6 +1441,51 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                                                  const uint32_t io_limit, const bool use_reorder_data,
                                                  QueryStats *stats)
 {
+    std::vector<LabelT> filter_labels;
+    if (use_filter)
+        filter_labels.push_back(filter_label);
+    cached_beam_search_multi_filters(query1, k_search, l_search, indices, distances, beam_width, filter_labels,
+                                     io_limit, use_reorder_data, stats);
+}
+
+template <typename T, typename LabelT>
+void PQFlashIndex<T, LabelT>::cached_beam_search_multi_filters(const T *query1, const uint64_t k_search,
+                                                               const uint64_t l_search, uint64_t *indices,
+                                                               float *distances, const uint64_t beam_width,
+                                                               const std::vector<LabelT> &filter_labels,
+                                                               const uint32_t io_limit, const bool use_reorder_data,
+                                                               QueryStats *stats)
+{
+    // Two queues as in Index::iterate_to_fixed_point_v2: retset follows points
+    // with any query label, match_all_retset keeps the ones with all of them.
+    const bool use_filter = !filter_labels.empty();
+    std::vector<LabelT> query_labels(filter_labels);
+    std::sort(query_labels.begin(), query_labels.end());
+    query_labels.erase(std::unique(query_labels.begin(), query_labels.end()), query_labels.end());
+    const uint32_t num_query_labels = (uint32_t)query_labels.size();
+    // with one label every traversed point matches all labels
+    const bool check_match_all = num_query_labels > 1;
+
+    // With labels in the sectors only label signatures are in memory. They
+    // admit candidates, possibly falsely, so an expanded node is checked
+    // against the exact labels read with it before it becomes a result.
+    LabelSignaturePredicate label_pred;
+    if (use_filter && _max_node_labels > 0)
+        label_pred.add_labels(query_labels);
+    const bool verify_expanded = check_match_all || (use_filter && _max_node_labels > 0);
+    auto candidate_size = [&](const uint32_t id) {
+        return _max_node_labels > 0 ? candidate_filter_size(id, query_labels, label_pred.masks)
+                                    : common_filter_size(id, query_labels);
+    };
+    // label_block is the node's label block in the sector scratch, or
+    // nullptr for a cached node
+    auto expanded_size = [&](const uint32_t id, const uint32_t *label_block) {
+        if (_max_node_labels == 0)
+            return common_filter_size(id, query_labels);
+        if (label_block == nullptr)
+            label_block = _label_cache.find(id)->second;
+        return sector_filter_size(id, label_block, query_labels);
+    };
 
     uint64_t num_sector_per_nodes = DIV_ROUND_UP(_max_node_len, defaults::SECTOR_LEN);
     if (beam_width > num_sector_per_nodes * defaults::MAX_N_SECTOR_READS)
@@ -1213,9 +1556,22 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     float *dist_scratch = pq_query_scratch->aligned_dist_scratch;
     uint8_t *pq_coord_scratch = pq_query_scratch->aligned_pq_coord_scratch;
 
+    // 4-bit PQ looks distances up in a byte table quantized once per query
+    uint8_t *fast_scan_lut = pq_query_scratch->aligned_fast_scan_lut;
+    float fast_scan_scale = 1.0f, fast_scan_bias = 0;
+    if (_pq_fast_scan)
+        quantize_fast_scan_lut(pq_dists, _n_chunks, fast_scan_lut, fast_scan_scale, fast_scan_bias);
+
     // lambda to batch compute query<-> node distances in PQ space
-    auto compute_dists = [this, pq_coord_scratch, pq_dists](const uint32_t *ids, const uint64_t n_ids,
-                                                            float *dists_out) {
+    auto compute_dists = [this, pq_coord_scratch, pq_dists, fast_scan_lut, fast_scan_scale,
+                          fast_scan_bias](const uint32_t *ids, const uint64_t n_ids, float *dists_out) {
+        if (_pq_fast_scan)
+        {
+            diskann::aggregate_fast_scan_codes(ids, n_ids, this->data, this->_n_chunks, pq_coord_scratch);
+            diskann::fast_scan_dist_lookup(pq_coord_scratch, n_ids, this->_n_chunks, fast_scan_lut, fast_scan_scale,
+                                           fast_scan_bias, dists_out);
+            return;
+        }
         diskann::aggregate_coords(ids, n_ids, this->data, this->_n_chunks, pq_coord_scratch);
         diskann::pq_dist_lookup(pq_coord_scratch, n_ids, this->_n_chunks, pq_dists, dists_out);
     };
@@ -1225,6 +1581,9 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     NeighborPriorityQueue &retset = query_scratch->retset;
     retset.reserve(l_search);
     std::vector<Neighbor> &full_retset = query_scratch->full_retset;
+    NeighborPriorityQueue &match_all_retset = query_scratch->match_all_retset;
+    if (check_match_all)
+        match_all_retset.reserve(l_search);
 
     uint32_t best_medoid = 0;
     float best_dist = (std::numeric_limits<float>::max)();
@@ -1243,36 +1602,104 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     }
     else
     {
-        if (_filter_to_medoid_ids.find(filter_label) != _filter_to_medoid_ids.end())
+        // seed from the medoids of the rarest query label that has any
+        const std::vector<uint32_t> *medoid_ids = nullptr;
+        uint32_t seed_label_num_pts = std::numeric_limits<uint32_t>::max();
+        for (const auto &label : query_labels)
         {
-            const auto &medoid_ids = _filter_to_medoid_ids[filter_label];
-            for (uint64_t cur_m = 0; cur_m < medoid_ids.size(); cur_m++)
+            auto medoid_iter = _filter_to_medoid_ids.find(label);
+            if (medoid_iter == _filter_to_medoid_ids.end())
+                continue;
+            auto count_iter = _label_num_pts.find(label);
+            uint32_t label_num_pts = count_iter == _label_num_pts.end() ? 0 : count_iter->second;
+            if (medoid_ids == nullptr || label_num_pts < seed_label_num_pts)
             {
-                // for filtered index, we dont store global centroid data as for unfiltered index, so we use PQ distance
-                // as approximation to decide closest medoid matching the query filter.
-                compute_dists(&medoid_ids[cur_m], 1, dist_scratch);
-                float cur_expanded_dist = dist_scratch[0];
-                if (cur_expanded_dist < best_dist)
-                {
-                    best_medoid = medoid_ids[cur_m];
-                    best_dist = cur_expanded_dist;
-                }
+                medoid_ids = &medoid_iter->second;
+                seed_label_num_pts = label_num_pts;
             }
         }
-        else
+        if (medoid_ids == nullptr)
         {
             throw ANNException("Cannot find medoid for specified filter.", -1, __FUNCSIG__, __FILE__, __LINE__);
         }
+
+        // prefer medoids that carry every query label, if any do
+        bool any_match_all = false;
+        if (check_match_all)
+        {
+            for (auto medoid : *medoid_ids)
+                any_match_all = any_match_all || candidate_size(medoid) == num_query_labels;
+        }
+        for (uint64_t cur_m = 0; cur_m < medoid_ids->size(); cur_m++)
+        {
+            if (any_match_all && candidate_size((*medoid_ids)[cur_m]) != num_query_labels)
+                continue;
+            // for filtered index, we dont store global centroid data as for unfiltered index, so we use PQ distance
+            // as approximation to decide closest medoid matching the query filter.
+            compute_dists(&(*medoid_ids)[cur_m], 1, dist_scratch);
+            float cur_expanded_dist = dist_scratch[0];
+            if (cur_expanded_dist < best_dist)
+            {
+                best_medoid = (*medoid_ids)[cur_m];
+                best_dist = cur_expanded_dist;
+            }
+        }
     }
 
     compute_dists(&best_medoid, 1, dist_scratch);
     retset.insert(Neighbor(best_medoid, dist_scratch[0]));
     visited.insert(best_medoid);
+    if (check_match_all && candidate_size(best_medoid) == num_query_labels)
+        match_all_retset.insert(Neighbor(best_medoid, dist_scratch[0]));
 
     uint32_t cmps = 0;
     uint32_t hops = 0;
     uint32_t num_ios = 0;
 
+    // I/O budget of this query. Only points with a query label are read, so
+    // a selective filter needs fewer reads than a broad one.
+    uint32_t query_io_limit = io_limit;
+    if (_io_budget_factor > 0)
+    {
+        uint64_t io_budget = (uint64_t)std::ceil(_io_budget_factor * l_search);
+        if (use_filter)
+        {
+            uint64_t num_eligible = 0;
+            for (const auto &label : query_labels)
+            {
+                auto count_iter = _label_num_pts.find(label);
+                if (count_iter != _label_num_pts.end())
+                    num_eligible += count_iter->second;
+            }
+            if (_use_universal_label && !std::binary_search(query_labels.begin(), query_labels.end(),
+                                                            _universal_filter_label))
+            {
+                auto count_iter = _label_num_pts.find(_universal_filter_label);
+                if (count_iter != _label_num_pts.end())
+                    num_eligible += count_iter->second;
+            }
+            io_budget = std::min(io_budget, std::max<uint64_t>(num_eligible, 1));
+        }
+        query_io_limit = (uint32_t)std::min<uint64_t>(io_limit, io_budget);
+    }
+
+    // Beam width of the next hop. Wide while the search is still finding
+    // closer candidates, narrower once the k_search best are all expanded
+    // and further reads mostly confirm them.
+    uint64_t cur_beam_width = beam_width;
+    const uint64_t min_beam_width = _adaptive_beam_width ? std::max<uint64_t>(1, beam_width / 4) : beam_width;
+    uint64_t beam_width_sum = 0;
+    auto adapt_beam_width = [&]() {
+        beam_width_sum += cur_beam_width;
+        if (!_adaptive_beam_width)
+            return;
+        const bool stable = retset.size() >= k_search &&
+                            (!retset.has_unexpanded_node() ||
+                             retset[k_search - 1].distance <= retset.peek_closest_unexpanded().distance);
+        cur_beam_width =
+            stable ? std::max(min_beam_width, cur_beam_width / 2) : std::min<uint64_t>(beam_width, cur_beam_width * 2);
+    };
+
     // cleared every iteration
     std::vector<uint32_t> frontier;
     frontier.reserve(2 * beam_width);
@@ -1283,7 +1710,135 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     std::vector<std::pair<uint32_t, std::pair<uint32_t, uint32_t *>>> cached_nhoods;
     cached_nhoods.reserve(2 * beam_width);
 
-    while (retset.has_unexpanded_node() && num_ios < io_limit)
+    const bool pipelined = _pipelined_search && reader->supports_async();
+    if (pipelined)
+    {
+        // expands one node whose coords and neighbors are in memory
+        auto expand_node = [&](const uint32_t node_id, T *node_coords, const uint64_t nnbrs, uint32_t *node_nbrs,
+                               const uint32_t *label_block) {
+            float cur_expanded_dist;
+            if (!_use_disk_index_pq)
+                cur_expanded_dist = _dist_cmp->compare(aligned_query_T, node_coords, (uint32_t)_aligned_dim);
+            else if (metric == diskann::Metric::INNER_PRODUCT)
+                cur_expanded_dist = _disk_pq_table.inner_product(query_float, (uint8_t *)node_coords);
+            else
+                cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)node_coords);
+            if (!verify_expanded || expanded_size(node_id, label_block) == num_query_labels)
+                full_retset.push_back(Neighbor(node_id, cur_expanded_dist));
+
+            cpu_timer.reset();
+            compute_dists(node_nbrs, nnbrs, dist_scratch);
+            for (uint64_t m = 0; m < nnbrs; ++m)
+            {
+                uint32_t id = node_nbrs[m];
+                if (visited.insert(id).second)
+                {
+                    if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
+                        continue;
+
+                    uint32_t common_size = 0;
+                    if (use_filter && (common_size = candidate_size(id)) == 0)
+                        continue;
+                    cmps++;
+                    Neighbor nn(id, dist_scratch[m]);
+                    retset.insert(nn);
+                    if (check_match_all && common_size == num_query_labels)
+                        match_all_retset.insert(nn);
+                }
+            }
+            if (stats != nullptr)
+            {
+                stats->n_cmps += (uint32_t)nnbrs;
+                stats->cpu_us += (float)cpu_timer.elapsed();
+            }
+        };
+
+        // Sector scratch is split into one slot per in-flight read. Whenever
+        // a read completes its node is expanded and the slot is refilled with
+        // the closest unexpanded node, so the next reads are issued while
+        // earlier ones are still being served. Nodes are chosen before all
+        // reads of the previous round returned, so some reads are speculative.
+        const uint64_t slot_len = num_sectors_per_node * defaults::SECTOR_LEN;
+        const uint64_t max_in_flight =
+            std::min<uint64_t>(beam_width, defaults::MAX_N_SECTOR_READS / num_sectors_per_node);
+        std::vector<uint32_t> slot_nodes(max_in_flight);
+        std::vector<uint32_t> free_slots;
+        free_slots.reserve(max_in_flight);
+        for (uint32_t slot = 0; slot < max_in_flight; slot++)
+            free_slots.push_back(slot);
+        std::vector<void *> done_bufs;
+        done_bufs.reserve(max_in_flight);
+        uint64_t n_in_flight = 0;
+
+        while (true)
+        {
+            frontier_read_reqs.clear();
+            while (retset.has_unexpanded_node() && !free_slots.empty() &&
+                   n_in_flight + frontier_read_reqs.size() < cur_beam_width && num_ios < query_io_limit)
+            {
+                auto nbr = retset.closest_unexpanded();
+                if (this->_count_visited_nodes)
+                {
+                    reinterpret_cast<std::atomic<uint32_t> &>(this->_node_visit_counter[nbr.id].second).fetch_add(1);
+                }
+                auto iter = _nhood_cache.find(nbr.id);
+                if (iter != _nhood_cache.end())
+                {
+                    if (stats != nullptr)
+                        stats->n_cache_hits++;
+                    expand_node(nbr.id, _coord_cache.find(nbr.id)->second, iter->second.first, iter->second.second,
+                                nullptr);
+                    continue;
+                }
+
+                uint32_t slot = free_slots.back();
+                free_slots.pop_back();
+                slot_nodes[slot] = nbr.id;
+                frontier_read_reqs.emplace_back(get_node_sector((size_t)nbr.id) * defaults::SECTOR_LEN, slot_len,
+                                                sector_scratch + slot * slot_len);
+                if (stats != nullptr)
+                {
+                    stats->n_4k++;
+                    stats->n_ios++;
+                }
+                num_ios++;
+            }
+            if (!frontier_read_reqs.empty())
+            {
+                reader->submit_reqs(frontier_read_reqs, ctx);
+                n_in_flight += frontier_read_reqs.size();
+                if (stats != nullptr)
+                    stats->n_hops++;
+            }
+            if (n_in_flight == 0)
+                break;
+
+            done_bufs.clear();
+            io_timer.reset();
+            reader->poll_reqs(ctx, 1, done_bufs);
+            if (stats != nullptr)
+            {
+                stats->io_us += (float)io_timer.elapsed();
+            }
+
+            for (auto buf : done_bufs)
+            {
+                uint32_t slot = (uint32_t)(((char *)buf - sector_scratch) / slot_len);
+                uint32_t node_id = slot_nodes[slot];
+                char *node_disk_buf = offset_to_node((char *)buf, node_id);
+                uint32_t *node_buf = offset_to_node_nhood(node_disk_buf);
+                memcpy(data_buf, offset_to_node_coords(node_disk_buf), _disk_bytes_per_point);
+                expand_node(node_id, data_buf, (uint64_t)(*node_buf), node_buf + 1,
+                            _max_node_labels > 0 ? offset_to_node_labels(node_disk_buf) : nullptr);
+                free_slots.push_back(slot);
+                n_in_flight--;
+            }
+            adapt_beam_width();
+            hops++;
+        }
+    }
+
+    while (!pipelined && retset.has_unexpanded_node() && num_ios < query_io_limit)
     {
         // clear iteration state
         frontier.clear();
@@ -1293,7 +1848,7 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
         sector_scratch_idx = 0;
         // find new beam
         uint32_t num_seen = 0;
-        while (retset.has_unexpanded_node() && frontier.size() < beam_width && num_seen < beam_width)
+        while (retset.has_unexpanded_node() && frontier.size() < cur_beam_width && num_seen < cur_beam_width)
         {
             auto nbr = retset.closest_unexpanded();
             num_seen++;
@@ -1369,7 +1924,8 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                     cur_expanded_dist = _disk_pq_table.l2_distance( // disk_pq does not support OPQ yet
                         query_float, (uint8_t *)node_fp_coords_copy);
             }
-            full_retset.push_back(Neighbor((uint32_t)cached_nhood.first, cur_expanded_dist));
+            if (!verify_expanded || expanded_size(cached_nhood.first, nullptr) == num_query_labels)
+                full_retset.push_back(Neighbor((uint32_t)cached_nhood.first, cur_expanded_dist));
 
             uint64_t nnbrs = cached_nhood.second.first;
             uint32_t *node_nbrs = cached_nhood.second.second;
@@ -1392,13 +1948,15 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                     if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
                         continue;
 
-                    if (use_filter && !(point_has_label(id, filter_label)) &&
-                        (!_use_universal_label || !point_has_label(id, _universal_filter_label)))
+                    uint32_t common_size = 0;
+                    if (use_filter && (common_size = candidate_size(id)) == 0)
                         continue;
                     cmps++;
                     float dist = dist_scratch[m];
                     Neighbor nn(id, dist);
                     retset.insert(nn);
+                    if (check_match_all && common_size == num_query_labels)
+                        match_all_retset.insert(nn);
                 }
             }
         }
@@ -1434,7 +1992,11 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                 else
                     cur_expanded_dist = _disk_pq_table.l2_distance(query_float, (uint8_t *)data_buf);
             }
-            full_retset.push_back(Neighbor(frontier_nhood.first, cur_expanded_dist));
+            if (!verify_expanded ||
+                expanded_size(frontier_nhood.first,
+                              _max_node_labels > 0 ? offset_to_node_labels(node_disk_buf) : nullptr) ==
+                    num_query_labels)
+                full_retset.push_back(Neighbor(frontier_nhood.first, cur_expanded_dist));
             uint32_t *node_nbrs = (node_buf + 1);
             // compute node_nbrs <-> query dist in PQ space
             cpu_timer.reset();
@@ -1455,8 +2017,8 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
                     if (!use_filter && _dummy_pts.find(id) != _dummy_pts.end())
                         continue;
 
-                    if (use_filter && !(point_has_label(id, filter_label)) &&
-                        (!_use_universal_label || !point_has_label(id, _universal_filter_label)))
+                    uint32_t common_size = 0;
+                    if (use_filter && (common_size = candidate_size(id)) == 0)
                         continue;
                     cmps++;
                     float dist = dist_scratch[m];
@@ -1467,6 +2029,8 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
 
                     Neighbor nn(id, dist);
                     retset.insert(nn);
+                    if (check_match_all && common_size == num_query_labels)
+                        match_all_retset.insert(nn);
                 }
             }
 
@@ -1476,12 +2040,23 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
             }
         }
 
+        adapt_beam_width();
         hops++;
     }
 
     // re-sort by distance
     std::sort(full_retset.begin(), full_retset.end());
 
+    if (check_match_all && _max_node_labels == 0 && full_retset.size() < k_search)
+    {
+        // Too few all-match points were expanded: append the closest
+        // unexpanded ones, ranked by PQ distance after the exact results.
+        // Reordering, if requested, recomputes their distances. Without
+        // exact labels in memory these could be false matches, so the
+        // padding is skipped then.
+        append_unexpanded_results(full_retset, match_all_retset, k_search);
+    }
+
     if (use_reorder_data)
     {
         if (!(this->_reorder_data_exists))
@@ -1532,8 +2107,9 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
         std::sort(full_retset.begin(), full_retset.end());
     }
 
-    // copy k_search values
-    for (uint64_t i = 0; i < k_search; i++)
+    // copy k_search values, fewer if fewer points satisfy the filter
+    const uint64_t num_found = std::min<uint64_t>(k_search, full_retset.size());
+    for (uint64_t i = 0; i < num_found; i++)
     {
         indices[i] = full_retset[i].id;
         auto key = (uint32_t)indices[i];
@@ -1556,6 +2132,7 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
             }
         }
     }
+    pad_search_results(indices, distances, num_found, k_search);
 
 #ifdef USE_BING_INFRA
     ctx.m_completeCount = 0;
@@ -1564,6 +2141,8 @@ void PQFlashIndex<T, LabelT>::cached_beam_search(const T *query1, const uint64_t
     if (stats != nullptr)
     {
         stats->total_us = (float)query_timer.elapsed();
+        stats->io_limit = query_io_limit;
+        stats->mean_beam_width = hops > 0 ? (float)beam_width_sum / hops : (float)cur_beam_width;
     }
 }
 
@@ -1642,6 +2221,14 @@ template <typename T, typename LabelT> char *PQFlashIndex<T, LabelT>::getHeaderB
 template <typename T, typename LabelT>
 std::vector<std::uint8_t> PQFlashIndex<T, LabelT>::get_pq_vector(std::uint64_t vid)
 {
+    if (_pq_fast_scan)
+    {
+        std::uint8_t *packed = &this->data[vid * pq4_code_bytes(this->_n_chunks)];
+        std::vector<std::uint8_t> pqVec(this->_n_chunks);
+        for (uint64_t c = 0; c < this->_n_chunks; c++)
+            pqVec[c] = (packed[c / 2] >> (4 * (c % 2))) & 0x0f;
+        return pqVec;
+    }
     std::uint8_t *pqVec = &this->data[vid * this->_n_chunks];
     return std::vector<std::uint8_t>(pqVec, pqVec + this->_n_chunks);
 }
@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <omp.h>
+
+#include <restapi/search_batcher.h>
+
+namespace diskann
+{
+SearchBatcher::SearchBatcher(const uint32_t num_threads, const uint32_t max_batch_size, const uint32_t max_wait_us)
+    : _num_threads(std::max(num_threads, 1u)), _max_batch_size(std::max(max_batch_size, 1u)),
+      _max_wait_us(max_wait_us)
+{
+    _dispatcher = std::thread(&SearchBatcher::dispatch_loop, this);
+}
+
+SearchBatcher::~SearchBatcher()
+{
+    {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        _stop = true;
+    }
+    _queue_cv.notify_all();
+    _dispatcher.join();
+}
+
+pplx::task<std::vector<SearchResult>> SearchBatcher::submit(SearchFunction search)
+{
+    pplx::task_completion_event<std::vector<SearchResult>> done;
+    {
+        std::lock_guard<std::mutex> lock(_queue_mutex);
+        _queue.push_back(PendingSearch{std::move(search), done, std::chrono::steady_clock::now()});
+    }
+    _queue_cv.notify_all();
+    return pplx::create_task(done);
+}
+
+void SearchBatcher::dispatch_loop()
+{
+    std::vector<PendingSearch> batch;
+    batch.reserve(_max_batch_size);
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_queue_mutex);
+            _queue_cv.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_queue.empty())
+                return;
+
+            // give concurrent requests until max_wait_us after the oldest
+            // arrived to join the batch; time it spent queued behind the
+            // previous batch counts
+            const auto deadline = _queue.front().arrival + std::chrono::microseconds(_max_wait_us);
+            _queue_cv.wait_until(lock, deadline, [this] { return _stop || _queue.size() >= _max_batch_size; });
+
+            const size_t batch_size = std::min(_queue.size(), (size_t)_max_batch_size);
+            std::move(_queue.begin(), _queue.begin() + batch_size, std::back_inserter(batch));
+            _queue.erase(_queue.begin(), _queue.begin() + batch_size);
+        }
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(_num_threads)
+        for (int64_t i = 0; i < (int64_t)batch.size(); i++)
+        {
+            try
+            {
+                batch[i].done.set(batch[i].search());
+            }
+            catch (...)
+            {
+                batch[i].done.set_exception(std::current_exception());
+            }
+        }
+        batch.clear();
+    }
+}
+} // namespace diskann
@@ -1,8 +1,10 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT license.
 
+#include <algorithm>
 #include <ctime>
 #include <iomanip>
+#include <limits>
 #include <omp.h>
 
 #include "utils.h"
@@ -101,7 +103,8 @@ InMemorySearch<T>::InMemorySearch(const std::string &baseFile, const std::string
     size_t dimensions, total_points = 0;
     diskann::get_bin_metadata(baseFile, total_points, dimensions);
     _index = std::unique_ptr<diskann::Index<T>>(
-        new diskann::Index<T>(m, dimensions, total_points, nullptr, search_l, 0, false));
+        new diskann::Index<T>(m, dimensions, total_points, nullptr,
+                              std::make_shared<diskann::IndexSearchParams>(search_l, num_threads), 0, false));
 
     _index->load(indexFile.c_str(), num_threads, search_l);
 }
@@ -133,25 +136,66 @@ SearchResult InMemorySearch<T>::search(const T *query, const unsigned int dimens
     return result;
 }
 
+template <typename T>
+SearchResult InMemorySearch<T>::search_with_filters(const T *query, const unsigned int dimensions, const unsigned int K,
+                                                    const unsigned int Ls, const std::vector<std::string> &labels)
+{
+    unsigned int *indices = new unsigned int[K];
+    float *distances = new float[K];
+    std::fill(indices, indices + K, std::numeric_limits<unsigned int>::max());
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    // a label without points in the index matches nothing; any other error
+    // reaches the caller
+    if (std::all_of(labels.begin(), labels.end(),
+                    [this](const std::string &label) { return _index->is_searchable_label(label); }))
+        _index->search_with_multi_filters(query, labels, K, Ls, indices, distances);
+    auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - startTime)
+            .count();
+
+    // few points may carry all labels
+    unsigned int num_found = 0;
+    while (num_found < K && indices[num_found] != std::numeric_limits<unsigned int>::max())
+        num_found++;
+
+    std::string *tags = nullptr;
+    if (_tags_enabled)
+    {
+        tags = new std::string[num_found];
+        lookup_tags(num_found, indices, tags);
+    }
+
+    SearchResult result(num_found, (unsigned int)duration, indices, distances, tags);
+
+    delete[] indices;
+    delete[] distances;
+    delete[] tags;
+    return result;
+}
+
 template <typename T> InMemorySearch<T>::~InMemorySearch()
 {
 }
 
 template <typename T>
 PQFlashSearch<T>::PQFlashSearch(const std::string &indexPrefix, const unsigned num_nodes_to_cache,
-                                const unsigned num_threads, const std::string &tagsFile, Metric m)
-    : BaseSearch(tagsFile)
+                                const unsigned num_threads, const std::string &tagsFile, Metric m,
+                                std::shared_ptr<AlignedFileReader> shared_reader)
+    : BaseSearch(tagsFile), reader(shared_reader)
 {
+    if (reader == nullptr)
+    {
 #ifdef _WINDOWS
 #ifndef USE_BING_INFRA
-    reader.reset(new WindowsAlignedFileReader());
+        reader.reset(new WindowsAlignedFileReader());
 #else
-    reader.reset(new diskann::BingAlignedFileReader());
+        reader.reset(new diskann::BingAlignedFileReader());
 #endif
 #else
-    auto ptr = new LinuxAlignedFileReader();
-    reader.reset(ptr);
+        reader = create_linux_aligned_file_reader();
 #endif
+    }
 
     std::string index_prefix_path(indexPrefix);
     std::string disk_index_file = index_prefix_path + "_disk.index";
@@ -8,15 +8,38 @@
 #include <cstdlib>
 #include <codecvt>
 #include <limits>
+#include <sstream>
+#include <stdexcept>
 
 #include <restapi/server.h>
 
 namespace diskann
 {
+namespace
+{
+// Malformed JSON, a missing field and a number out of range are errors of
+// the request, rethrown as invalid_argument so that they are answered with
+// 400 Bad Request rather than 500.
+template <typename ParseFn> void parseAsClientRequest(ParseFn parse)
+{
+    try
+    {
+        parse();
+    }
+    catch (const web::json::json_exception &ex)
+    {
+        throw std::invalid_argument(std::string("Malformed request: ") + ex.what());
+    }
+    catch (const std::out_of_range &ex)
+    {
+        throw std::invalid_argument(std::string("Malformed request: ") + ex.what());
+    }
+}
+} // namespace
 
 Server::Server(web::uri &uri, std::vector<std::unique_ptr<diskann::BaseSearch>> &multi_searcher,
-               const std::string &typestring)
-    : _multi_search(multi_searcher.size() > 1 ? true : false)
+               const std::string &typestring, std::unique_ptr<SearchBatcher> batcher)
+    : _multi_search(multi_searcher.size() > 1 ? true : false), _batcher(std::move(batcher))
 {
     for (auto &searcher : multi_searcher)
         _multi_searcher.push_back(std::move(searcher));
@@ -68,19 +91,26 @@ diskann::SearchResult Server::aggregate_results(const unsigned K, const std::vec
         auto numsearchers = _multi_searcher.size();
         std::vector<size_t> pos(numsearchers, 0);
 
+        // filtered searches may return fewer than K results per searcher
+        unsigned num_found = 0;
         for (size_t k = 0; k < K; ++k)
         {
             float best_distance = std::numeric_limits<float>::max();
             unsigned best_partition = 0;
+            bool found = false;
 
             for (size_t i = 0; i < numsearchers; ++i)
             {
-                if (results[i].get_distances()[pos[i]] < best_distance)
+                if (pos[i] < results[i].get_distances().size() && results[i].get_distances()[pos[i]] <= best_distance)
                 {
                     best_distance = results[i].get_distances()[pos[i]];
                     best_partition = i;
+                    found = true;
                 }
             }
+            if (!found)
+                break;
+            num_found++;
             best_distances[k] = best_distance;
             best_indices[k] = results[best_partition].get_indices()[pos[best_partition]];
             best_partitions[k] = best_partition;
@@ -94,7 +124,7 @@ diskann::SearchResult Server::aggregate_results(const unsigned K, const std::vec
         for (size_t i = 0; i < numsearchers; ++i)
             total_time += results[i].get_time();
         diskann::SearchResult result =
-            SearchResult(K, total_time, best_indices, best_distances, best_tags, best_partitions);
+            SearchResult(num_found, total_time, best_indices, best_distances, best_tags, best_partitions);
 
         delete[] best_indices;
         delete[] best_distances;
@@ -111,25 +141,34 @@ diskann::SearchResult Server::aggregate_results(const unsigned K, const std::vec
 
 template <class T> void Server::handle_post(web::http::http_request message)
 {
-    message.extract_string(true)
-        .then([=](utility::string_t body) {
-            int64_t queryId = -1;
-            unsigned int K = 0;
+    auto request = std::make_shared<SearchRequest<T>>();
+    const auto path = web::uri::split_path(web::uri::decode(message.relative_uri().path()));
+    const bool filtered = !path.empty() && utility::conversions::to_utf8string(path[0]) == FILTERED_SEARCH_PATH;
+    const bool raw =
+        utility::conversions::to_utf8string(message.headers().content_type()).rfind(RAW_VECTOR_CONTENT_TYPE, 0) == 0;
+
+    pplx::task<void> parsed;
+    if (raw)
+        parsed = message.extract_vector().then([=](std::vector<unsigned char> body) {
+            parseAsClientRequest([&] { parseRaw(message.relative_uri(), body, *request); });
+        });
+    else
+        parsed = message.extract_string(true).then(
+            [=](utility::string_t body) { parseAsClientRequest([&] { parseJson(body, *request); }); });
+
+    parsed
+        .then([=]() {
+            if (filtered && request->labels.empty())
+                throw std::invalid_argument("Filtered search needs at least one label.");
+            request->startTime = std::chrono::high_resolution_clock::now();
+            return runSearch(request, filtered);
+        })
+        .then([=](pplx::task<std::vector<diskann::SearchResult>> searched) {
             try
             {
-                T *queryVector = nullptr;
-                unsigned int dimensions = 0;
-                unsigned int Ls;
-                parseJson(body, K, queryId, queryVector, dimensions, Ls);
-
-                auto startTime = std::chrono::high_resolution_clock::now();
-                std::vector<diskann::SearchResult> results;
-
-                for (auto &searcher : _multi_searcher)
-                    results.push_back(searcher->search(queryVector, dimensions, (unsigned int)K, Ls));
-                diskann::SearchResult result = aggregate_results(K, results);
-                diskann::aligned_free(queryVector);
-                web::json::value response = prepareResponse(queryId, K);
+                std::vector<diskann::SearchResult> results = searched.get();
+                diskann::SearchResult result = aggregate_results(request->K, results);
+                web::json::value response = prepareResponse(request->queryId, request->K);
                 response[INDICES_KEY] = idsToJsonArray(result);
                 response[DISTANCES_KEY] = distancesToJsonArray(result);
                 if (result.tags_enabled())
@@ -138,23 +177,31 @@ template <class T> void Server::handle_post(web::http::http_request message)
                     response[PARTITION_KEY] = partitionsToJsonArray(result);
 
                 response[TIME_TAKEN_KEY] = std::chrono::duration_cast<std::chrono::microseconds>(
-                                               std::chrono::high_resolution_clock::now() - startTime)
+                                               std::chrono::high_resolution_clock::now() - request->startTime)
                                                .count();
 
-                std::cout << "Responding to: " << queryId << std::endl;
+                std::cout << "Responding to: " << request->queryId << std::endl;
                 return std::make_pair(web::http::status_codes::OK, response);
             }
+            catch (const std::invalid_argument &ex)
+            {
+                std::cerr << "Invalid query: " << request->queryId << ":" << ex.what() << std::endl;
+                web::json::value response = prepareResponse(request->queryId, request->K);
+                response[ERROR_MESSAGE_KEY] = web::json::value::string(ex.what());
+                return std::make_pair(web::http::status_codes::BadRequest, response);
+            }
             catch (const std::exception &ex)
             {
-                std::cerr << "Exception while processing query: " << queryId << ":" << ex.what() << std::endl;
-                web::json::value response = prepareResponse(queryId, K);
+                std::cerr << "Exception while processing query: " << request->queryId << ":" << ex.what()
+                          << std::endl;
+                web::json::value response = prepareResponse(request->queryId, request->K);
                 response[ERROR_MESSAGE_KEY] = web::json::value::string(ex.what());
                 return std::make_pair(web::http::status_codes::InternalError, response);
             }
             catch (...)
             {
-                std::cerr << "Uncaught exception while processing query: " << queryId;
-                web::json::value response = prepareResponse(queryId, K);
+                std::cerr << "Uncaught exception while processing query: " << request->queryId;
+                web::json::value response = prepareResponse(request->queryId, request->K);
                 response[ERROR_MESSAGE_KEY] = web::json::value::string(UNKNOWN_ERROR);
                 return std::make_pair(web::http::status_codes::InternalError, response);
             }
@@ -171,6 +218,28 @@ template <class T> void Server::handle_post(web::http::http_request message)
         });
 }
 
+template <class T>
+pplx::task<std::vector<diskann::SearchResult>> Server::runSearch(std::shared_ptr<SearchRequest<T>> request,
+                                                                 const bool filtered)
+{
+    SearchBatcher::SearchFunction search = [this, request, filtered]() {
+        std::vector<diskann::SearchResult> results;
+        for (auto &searcher : _multi_searcher)
+        {
+            if (filtered)
+                results.push_back(searcher->search_with_filters(request->queryVector, request->dimensions,
+                                                                request->K, request->Ls, request->labels));
+            else
+                results.push_back(searcher->search(request->queryVector, request->dimensions, request->K,
+                                                   request->Ls));
+        }
+        return results;
+    };
+    if (_batcher != nullptr)
+        return _batcher->submit(std::move(search));
+    return pplx::task_from_result(search());
+}
+
 web::json::value Server::prepareResponse(const int64_t &queryId, const int k)
 {
     web::json::value response = web::json::value::object();
@@ -180,35 +249,98 @@ web::json::value Server::prepareResponse(const int64_t &queryId, const int k)
     return response;
 }
 
-template <class T>
-void Server::parseJson(const utility::string_t &body, unsigned int &k, int64_t &queryId, T *&queryVector,
-                       unsigned int &dimensions, unsigned &Ls)
+template <class T> void Server::parseJson(const utility::string_t &body, SearchRequest<T> &request)
 {
-    std::cout << body << std::endl;
     web::json::value val = web::json::value::parse(body);
-    web::json::array queryArr = val.at(VECTOR_KEY).as_array();
-    queryId = val.has_field(QUERY_ID_KEY) ? val.at(QUERY_ID_KEY).as_number().to_int64() : -1;
-    Ls = val.has_field(L_KEY) ? val.at(L_KEY).as_number().to_uint32() : DEFAULT_L;
-    k = val.at(K_KEY).as_integer();
+    request.queryId = val.has_field(QUERY_ID_KEY) ? val.at(QUERY_ID_KEY).as_number().to_int64() : -1;
+    request.Ls = val.has_field(L_KEY) ? val.at(L_KEY).as_number().to_uint32() : DEFAULT_L;
+    request.K = val.at(K_KEY).as_integer();
+
+    if (request.K <= 0 || request.K > request.Ls)
+    {
+        throw std::invalid_argument("Num of expected NN (k) must be greater than zero and less than or "
+                                    "equal to Ls.");
+    }
+
+    if (val.has_field(VECTOR_BASE64_KEY))
+    {
+        copyQueryVector(utility::conversions::from_base64(val.at(VECTOR_BASE64_KEY).as_string()), request);
+    }
+    else
+    {
+        web::json::array queryArr = val.at(VECTOR_KEY).as_array();
+        allocQueryVector(queryArr.size(), request);
+        for (size_t i = 0; i < queryArr.size(); i++)
+        {
+            request.queryVector[i] = (T)queryArr[i].as_double();
+        }
+    }
+
+    if (val.has_field(LABELS_KEY))
+    {
+        for (const auto &label : val.at(LABELS_KEY).as_array())
+        {
+            request.labels.push_back(utility::conversions::to_utf8string(label.is_string() ? label.as_string()
+                                                                                           : label.serialize()));
+        }
+    }
+}
+
+template <class T>
+void Server::parseRaw(const web::uri &uri, const std::vector<unsigned char> &body, SearchRequest<T> &request)
+{
+    auto params = web::uri::split_query(web::uri::decode(uri.query()));
+    auto param = [&params](const std::string &key) -> std::string {
+        auto iter = params.find(utility::conversions::to_string_t(key));
+        return iter == params.end() ? std::string() : utility::conversions::to_utf8string(iter->second);
+    };
+
+    const std::string queryId = param(QUERY_ID_KEY), Ls = param(L_KEY), k = param(K_KEY);
+    request.queryId = queryId.empty() ? -1 : std::stoll(queryId);
+    request.Ls = Ls.empty() ? DEFAULT_L : (unsigned int)std::stoul(Ls);
+    request.K = k.empty() ? 0 : (unsigned int)std::stoul(k);
+
+    if (request.K <= 0 || request.K > request.Ls)
+    {
+        throw std::invalid_argument("Num of expected NN (k) must be greater than zero and less than or "
+                                    "equal to Ls.");
+    }
+
+    copyQueryVector(body, request);
 
-    if (k <= 0 || k > Ls)
+    std::istringstream labels(param(LABELS_KEY));
+    std::string label;
+    while (std::getline(labels, label, ','))
     {
-        throw new std::invalid_argument("Num of expected NN (k) must be greater than zero and less than or "
-                                        "equal to Ls.");
+        if (!label.empty())
+            request.labels.push_back(label);
     }
-    if (queryArr.size() == 0)
+}
+
+template <class T> void Server::allocQueryVector(const size_t dimensions, SearchRequest<T> &request)
+{
+    if (dimensions == 0)
     {
-        throw new std::invalid_argument("Query vector has zero elements.");
+        throw std::invalid_argument("Query vector has zero elements.");
     }
 
-    dimensions = static_cast<unsigned int>(queryArr.size());
-    unsigned new_dim = ROUND_UP(dimensions, 8);
-    diskann::alloc_aligned((void **)&queryVector, new_dim * sizeof(T), 8 * sizeof(T));
-    memset(queryVector, 0, new_dim * sizeof(float));
-    for (size_t i = 0; i < queryArr.size(); i++)
+    request.dimensions = static_cast<unsigned int>(dimensions);
+    unsigned new_dim = ROUND_UP(request.dimensions, 8);
+    diskann::alloc_aligned((void **)&request.queryVector, new_dim * sizeof(T), 8 * sizeof(T));
+    memset(request.queryVector, 0, new_dim * sizeof(T));
+}
+
+// Binary queries are the vector's elements in the server's data type, in
+// host byte order.
+template <class T> void Server::copyQueryVector(const std::vector<unsigned char> &bytes, SearchRequest<T> &request)
+{
+    if (bytes.size() % sizeof(T) != 0)
     {
-        queryVector[i] = (float)queryArr[i].as_double();
+        throw std::invalid_argument("Binary query vector size is not a multiple of the element size.");
     }
+
+    allocQueryVector(bytes.size() / sizeof(T), request);
+    memcpy(request.queryVector, bytes.data(), bytes.size());
 }
 
 template <typename T>
@@ -28,9 +28,15 @@ InMemQueryScratch<T>::InMemQueryScratch(uint32_t search_l, uint32_t indexing_l,
     memset(_aligned_query, 0, aligned_dim * sizeof(T));
 
     if (init_pq_scratch)
+    {
         _pq_scratch = new PQScratch<T>(defaults::MAX_GRAPH_DEGREE, aligned_dim);
+        alloc_aligned(((void **)&_rerank_vector), aligned_dim * sizeof(T), alignment_factor * sizeof(T));
+        memset(_rerank_vector, 0, aligned_dim * sizeof(T));
+    }
     else
+    {
         _pq_scratch = nullptr;
+    }
 
     _occlude_factor.reserve(maxc);
     _inserted_into_pool_bs = new boost::dynamic_bitset<>();
@@ -75,6 +81,10 @@ template <typename T> InMemQueryScratch<T>::~InMemQueryScratch()
     {
         aligned_free(_aligned_query);
     }
+    if (_rerank_vector != nullptr)
+    {
+        aligned_free(_rerank_vector);
+    }
 
     delete _pq_scratch;
     delete _inserted_into_pool_bs;
@@ -89,6 +99,7 @@ template <typename T> void SSDQueryScratch<T>::reset()
     visited.clear();
     retset.clear();
     full_retset.clear();
+    match_all_retset.clear();
 }
 
 template <typename T> SSDQueryScratch<T>::SSDQueryScratch(size_t aligned_dim, size_t visited_reserve)
@@ -0,0 +1,239 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <omp.h>
+
+#ifndef _WINDOWS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#ifdef USE_GPERFTOOLS_PROFILER
+#include <gperftools/heap-profiler.h>
+#include <gperftools/profiler.h>
+#endif
+
+#include "ann_exception.h"
+#include "logger.h"
+#include "search_profiler.h"
+
+namespace diskann
+{
+namespace
+{
+struct HwCounter
+{
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+#ifndef _WINDOWS
+const HwCounter HW_COUNTERS[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"dtlb_load_misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)}};
+#else
+const HwCounter HW_COUNTERS[] = {{"cycles", 0, 0}};
+#endif
+constexpr size_t NUM_HW_COUNTERS = sizeof(HW_COUNTERS) / sizeof(HW_COUNTERS[0]);
+
+#ifndef _WINDOWS
+// Counts the calling thread only, on any CPU, in user mode, which the default
+// perf_event_paranoid of 2 allows.
+int open_hw_counter(const HwCounter &counter)
+{
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = counter.type;
+    attr.config = counter.config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // scale the counts if the PMU multiplexes the events
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+// Returns -1 if the counter could not be read.
+double read_hw_counter(const int fd)
+{
+    uint64_t values[3] = {0, 0, 0};
+    if (fd < 0 || read(fd, values, sizeof(values)) != (ssize_t)sizeof(values))
+        return -1;
+    if (values[2] == 0)
+        return 0;
+    return (double)values[0] * ((double)values[1] / (double)values[2]);
+}
+#endif
+} // namespace
+
+SearchProfiler::SearchProfiler(const std::string &profile_prefix, const uint32_t num_threads, const bool cpu_profile,
+                               const bool heap_profile, const bool hw_counters, SearchThreadPool *search_pool)
+    : _profile_prefix(profile_prefix), _num_threads(std::max(num_threads, 1u)), _cpu_profile(cpu_profile),
+      _heap_profile(heap_profile), _hw_counters(hw_counters), _search_pool(search_pool)
+{
+#ifndef USE_GPERFTOOLS_PROFILER
+    if (_cpu_profile || _heap_profile)
+    {
+        diskann::cerr << "CPU and heap profiles need a build with -DDISKANN_PROFILER=ON, skipping them" << std::endl;
+        // without the profilers, the hardware counters are all a profile run
+        // can still report
+        _hw_counters = _hw_counters || _cpu_profile;
+        _cpu_profile = _heap_profile = false;
+    }
+#endif
+#ifdef _WINDOWS
+    if (_hw_counters)
+    {
+        diskann::cerr << "Hardware counters are only available on Linux, skipping them" << std::endl;
+        _hw_counters = false;
+    }
+#endif
+}
+
+SearchProfiler::~SearchProfiler()
+{
+    if (_running)
+        stop(0);
+}
+
+void SearchProfiler::start(const std::string &label)
+{
+    if (_running)
+        throw ANNException("SearchProfiler::start called twice without stop", -1, __FUNCSIG__, __FILE__, __LINE__);
+    _label = label;
+    _running = true;
+
+    // open the counters first so that their setup is not in the profiles
+    if (_hw_counters)
+        open_hw_counters();
+#ifdef USE_GPERFTOOLS_PROFILER
+    if (_heap_profile)
+        HeapProfilerStart((_profile_prefix + "_" + _label).c_str());
+    if (_cpu_profile && !ProfilerStart((_profile_prefix + "_" + _label + ".prof").c_str()))
+        diskann::cerr << "Could not start the CPU profiler for " << _label << std::endl;
+#endif
+#ifndef _WINDOWS
+    for (const auto &thread_fds : _hw_counter_fds)
+        for (const auto fd : thread_fds)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+void SearchProfiler::stop(const uint64_t num_queries)
+{
+    if (!_running)
+        return;
+    _running = false;
+
+#ifndef _WINDOWS
+    for (const auto &thread_fds : _hw_counter_fds)
+        for (const auto fd : thread_fds)
+            if (fd >= 0)
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+#ifdef USE_GPERFTOOLS_PROFILER
+    if (_cpu_profile)
+        ProfilerStop();
+    if (_heap_profile)
+    {
+        HeapProfilerDump(_label.c_str());
+        HeapProfilerStop();
+    }
+#endif
+    if (!_hw_counters)
+        return;
+
+    std::vector<double> totals(NUM_HW_COUNTERS, 0);
+#ifndef _WINDOWS
+    for (const auto &thread_fds : _hw_counter_fds)
+    {
+        for (size_t c = 0; c < NUM_HW_COUNTERS; c++)
+        {
+            const double count = read_hw_counter(thread_fds[c]);
+            totals[c] = (count < 0 || totals[c] < 0) ? -1 : totals[c] + count;
+        }
+    }
+#endif
+    close_hw_counters();
+
+    const std::string csv_path = _profile_prefix + "_hw_counters.csv";
+    const bool new_csv = !std::ifstream(csv_path).good();
+    std::ofstream csv(csv_path, std::ios_base::app);
+    if (new_csv)
+    {
+        csv << "label,queries";
+        for (const auto &counter : HW_COUNTERS)
+            csv << "," << counter.name;
+        csv << std::endl;
+    }
+    csv << _label << "," << num_queries;
+
+    diskann::cout << "Hardware counters for " << _label << " (per query):";
+    for (size_t c = 0; c < NUM_HW_COUNTERS; c++)
+    {
+        csv << "," << std::fixed << std::setprecision(0) << totals[c];
+        diskann::cout << " " << HW_COUNTERS[c].name << "=";
+        if (totals[c] < 0)
+            diskann::cout << "n/a";
+        else
+            diskann::cout << (uint64_t)(num_queries > 0 ? totals[c] / num_queries : totals[c]);
+    }
+    if (totals[0] > 0 && totals[1] >= 0)
+        diskann::cout << " ipc=" << std::fixed << std::setprecision(2) << totals[1] / totals[0];
+    diskann::cout << std::endl;
+    csv << std::endl;
+}
+
+void SearchProfiler::open_hw_counters()
+{
+#ifndef _WINDOWS
+    const uint32_t threads = _search_pool != nullptr ? _search_pool->num_threads() : _num_threads;
+    _hw_counter_fds.assign(threads, std::vector<int>(NUM_HW_COUNTERS, -1));
+    std::atomic<bool> failed{false};
+    auto open_thread_counters = [&](const uint32_t thread_id) {
+        auto &thread_fds = _hw_counter_fds[thread_id];
+        for (size_t c = 0; c < NUM_HW_COUNTERS; c++)
+        {
+            thread_fds[c] = open_hw_counter(HW_COUNTERS[c]);
+            if (thread_fds[c] < 0)
+                failed = true;
+        }
+    };
+    if (_search_pool != nullptr)
+    {
+        _search_pool->run_on_each_thread(open_thread_counters);
+    }
+    else
+    {
+#pragma omp parallel num_threads(threads)
+        open_thread_counters((uint32_t)omp_get_thread_num());
+    }
+    if (failed)
+        diskann::cerr << "Some hardware counters could not be opened, check /proc/sys/kernel/perf_event_paranoid"
+                      << std::endl;
+#endif
+}
+
+void SearchProfiler::close_hw_counters()
+{
+#ifndef _WINDOWS
+    for (const auto &thread_fds : _hw_counter_fds)
+        for (const auto fd : thread_fds)
+            if (fd >= 0)
+                close(fd);
+#endif
+    _hw_counter_fds.clear();
+}
+} // namespace diskann
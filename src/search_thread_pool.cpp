@@ -0,0 +1,198 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <algorithm>
+
+#ifndef _WINDOWS
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "logger.h"
+#include "numa_utils.h"
+#include "search_thread_pool.h"
+
+namespace diskann
+{
+SearchThreadPool::SearchThreadPool(const uint32_t num_threads, const bool pin_threads, const bool numa_aware)
+    : _pin_threads(pin_threads)
+{
+    const uint32_t threads = std::max(num_threads, 1u);
+    _slices.reset(new Slice[threads]);
+
+    // threads t with the same t * nodes / threads share a node, so that the
+    // slices a thread steals from first belong to threads of its own node
+    _nodes = numa_aware ? get_numa_nodes() : std::vector<uint32_t>{0};
+    if (_nodes.size() > threads)
+        _nodes.resize(threads);
+    _thread_nodes.resize(threads);
+    for (uint32_t t = 0; t < threads; t++)
+        _thread_nodes[t] = (uint32_t)((uint64_t)t * _nodes.size() / threads);
+
+    _threads.reserve(threads);
+    for (uint32_t t = 0; t < threads; t++)
+        _threads.emplace_back(&SearchThreadPool::worker_loop, this, t);
+
+#ifndef _WINDOWS
+    if (numa_aware)
+    {
+        // one CPU of the node per thread with pin_threads, else the whole node
+        uint32_t node_thread = 0;
+        for (uint32_t t = 0; t < threads; t++)
+        {
+            node_thread = (t > 0 && _thread_nodes[t] == _thread_nodes[t - 1]) ? node_thread + 1 : 0;
+            const std::vector<int> cpus = get_numa_node_cpus(_nodes[_thread_nodes[t]]);
+            if (cpus.empty())
+                continue;
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            if (_pin_threads)
+                CPU_SET(cpus[node_thread % cpus.size()], &mask);
+            else
+                for (const int cpu : cpus)
+                    CPU_SET(cpu, &mask);
+            pthread_setaffinity_np(_threads[t].native_handle(), sizeof(mask), &mask);
+        }
+        diskann::cout << "Search pool spread " << threads << " threads over " << _nodes.size() << " NUMA node(s)"
+                      << std::endl;
+    }
+    else if (_pin_threads)
+    {
+        const std::vector<int> cpus = get_allowed_cpus();
+        if (cpus.size() < threads)
+            diskann::cout << "Search pool has " << threads << " threads for " << cpus.size()
+                          << " CPUs, some threads share a CPU" << std::endl;
+        for (uint32_t t = 0; t < threads && !cpus.empty(); t++)
+        {
+            cpu_set_t mask;
+            CPU_ZERO(&mask);
+            CPU_SET(cpus[t % cpus.size()], &mask);
+            pthread_setaffinity_np(_threads[t].native_handle(), sizeof(mask), &mask);
+        }
+    }
+#endif
+}
+
+SearchThreadPool::~SearchThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _start_cv.notify_all();
+    for (auto &thread : _threads)
+        thread.join();
+}
+
+void SearchThreadPool::parallel_for(const size_t n, const size_t chunk_size,
+                                    const std::function<void(size_t, uint32_t)> &fn)
+{
+    if (n == 0)
+        return;
+    std::lock_guard<std::mutex> run_lock(_run_mutex);
+
+    const size_t num_slices = _threads.size();
+    for (size_t t = 0; t < num_slices; t++)
+    {
+        _slices[t].next.store(n * t / num_slices, std::memory_order_relaxed);
+        _slices[t].end = n * (t + 1) / num_slices;
+    }
+    const size_t chunk = std::max<size_t>(chunk_size, 1);
+
+    run([&](const uint32_t thread_id) {
+        // own slice first, then the neighbouring ones
+        for (size_t k = 0; k < num_slices; k++)
+        {
+            Slice &slice = _slices[(thread_id + k) % num_slices];
+            while (!_failed.load(std::memory_order_relaxed))
+            {
+                const size_t begin = slice.next.fetch_add(chunk, std::memory_order_relaxed);
+                if (begin >= slice.end)
+                    break;
+                const size_t end = std::min(begin + chunk, slice.end);
+                try
+                {
+                    for (size_t i = begin; i < end; i++)
+                        fn(i, thread_id);
+                }
+                catch (...)
+                {
+                    record_exception();
+                }
+            }
+        }
+    });
+}
+
+void SearchThreadPool::run_on_each_thread(const std::function<void(uint32_t)> &fn)
+{
+    std::lock_guard<std::mutex> run_lock(_run_mutex);
+    run([&](const uint32_t thread_id) {
+        try
+        {
+            fn(thread_id);
+        }
+        catch (...)
+        {
+            record_exception();
+        }
+    });
+}
+
+void SearchThreadPool::run(const std::function<void(uint32_t)> &body)
+{
+    _failed.store(false);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _body = &body;
+        _running = (uint32_t)_threads.size();
+        _generation++;
+    }
+    _start_cv.notify_all();
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _done_cv.wait(lock, [this] { return _running == 0; });
+        _body = nullptr;
+    }
+
+    if (_exception)
+    {
+        std::exception_ptr exception = _exception;
+        _exception = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void SearchThreadPool::worker_loop(const uint32_t thread_id)
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        const std::function<void(uint32_t)> *body;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _start_cv.wait(lock, [&] { return _stop || _generation != generation; });
+            if (_stop)
+                return;
+            generation = _generation;
+            body = _body;
+        }
+
+        (*body)(thread_id);
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (--_running == 0)
+                _done_cv.notify_one();
+        }
+    }
+}
+
+void SearchThreadPool::record_exception()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_exception)
+        _exception = std::current_exception();
+    _failed.store(true);
+}
+} // namespace diskann
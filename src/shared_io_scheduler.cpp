@@ -0,0 +1,247 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef _WINDOWS
+
+#include "shared_io_scheduler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include "ann_exception.h"
+#include "defaults.h"
+#include "utils.h"
+
+SharedIOScheduler::SharedIOScheduler(const uint32_t num_io_threads, const uint32_t queue_depth)
+    : _queue_depth(queue_depth)
+{
+    if (num_io_threads == 0)
+        throw diskann::ANNException("SharedIOScheduler needs at least one I/O thread", -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    for (uint32_t i = 0; i < num_io_threads; i++)
+        _io_threads.emplace_back(&SharedIOScheduler::io_thread_main, this);
+}
+
+SharedIOScheduler::~SharedIOScheduler()
+{
+    {
+        std::unique_lock<std::mutex> lk(_mut);
+        _stop = true;
+    }
+    _queue_cv.notify_all();
+    for (auto &io_thread : _io_threads)
+        io_thread.join();
+}
+
+uint32_t SharedIOScheduler::add_tenant(const uint32_t weight)
+{
+    std::unique_lock<std::mutex> lk(_mut);
+    return _queue.add_tenant(weight);
+}
+
+void SharedIOScheduler::remove_tenant(const uint32_t tenant_id)
+{
+    std::unique_lock<std::mutex> lk(_mut);
+    _queue.remove_tenant(tenant_id);
+}
+
+void SharedIOScheduler::read(const uint32_t tenant_id, const int fd, std::vector<AlignedRead> &read_reqs)
+{
+    if (read_reqs.empty())
+        return;
+
+    Batch batch;
+    batch.fd = fd;
+    batch.reqs = &read_reqs;
+    uint64_t num_bytes = 0;
+    for (auto &req : read_reqs)
+        num_bytes += req.len;
+    batch.cost = std::max<uint64_t>(DIV_ROUND_UP(num_bytes, diskann::defaults::SECTOR_LEN), 1);
+
+    {
+        std::unique_lock<std::mutex> lk(_mut);
+        if (!_queue.push(tenant_id, &batch))
+            throw diskann::ANNException("Unknown I/O scheduler tenant " + std::to_string(tenant_id), -1,
+                                        __FUNCSIG__, __FILE__, __LINE__);
+    }
+    _queue_cv.notify_one();
+
+    std::unique_lock<std::mutex> lk(batch.mut);
+    batch.cv.wait(lk, [&batch] { return batch.done; });
+    if (batch.error != 0)
+        throw diskann::ANNException(std::string("Scheduled read failed: ") + ::strerror(-batch.error), -1,
+                                    __FUNCSIG__, __FILE__, __LINE__);
+}
+
+std::vector<SharedIOScheduler::Batch *> SharedIOScheduler::next_batches()
+{
+    std::unique_lock<std::mutex> lk(_mut);
+    _queue_cv.wait(lk, [this] { return _stop || !_queue.empty(); });
+    return _queue.pop();
+}
+
+void SharedIOScheduler::io_thread_main()
+{
+    io_context_t ctx = 0;
+    int ret = io_setup(_queue_depth, &ctx);
+    if (ret != 0)
+    {
+        std::cerr << "io_setup() failed; returned " << ret << ": " << ::strerror(-ret) << std::endl;
+        exit(-1);
+    }
+
+    std::vector<Batch *> batches;
+    while (!(batches = next_batches()).empty())
+    {
+        int error = execute_batches(ctx, batches);
+        for (Batch *batch : batches)
+        {
+            // notify under the lock: the batch lives on the stack of its
+            // reader, which may return as soon as it sees done
+            std::unique_lock<std::mutex> lk(batch->mut);
+            batch->error = error;
+            batch->done = true;
+            batch->cv.notify_one();
+        }
+    }
+    io_destroy(ctx);
+}
+
+int SharedIOScheduler::execute_batches(io_context_t ctx, const std::vector<Batch *> &batches)
+{
+    const int fd = batches.front()->fd;
+    std::vector<const AlignedRead *> reqs;
+    for (const Batch *batch : batches)
+        for (const AlignedRead &req : *batch->reqs)
+            reqs.push_back(&req);
+    std::vector<CoalescedRead> runs = coalesce_reads(std::move(reqs));
+
+    for (size_t base = 0; base < runs.size(); base += _queue_depth)
+    {
+        const size_t n_ops = std::min<size_t>(runs.size() - base, _queue_depth);
+        std::vector<struct iocb> cb(n_ops);
+        std::vector<struct iocb *> cbs(n_ops);
+        std::vector<struct io_event> evts(n_ops);
+        for (size_t j = 0; j < n_ops; j++)
+        {
+            io_prep_preadv(&cb[j], fd, runs[base + j].iovecs.data(), (int)runs[base + j].iovecs.size(),
+                           (long long)runs[base + j].offset);
+            cbs[j] = &cb[j];
+        }
+
+        int ret = io_submit(ctx, (long)n_ops, cbs.data());
+        if (ret != (int)n_ops)
+            return ret < 0 ? ret : -EIO;
+        ret = io_getevents(ctx, (long)n_ops, (long)n_ops, evts.data(), nullptr);
+        if (ret != (int)n_ops)
+            return ret < 0 ? ret : -EIO;
+        for (auto &evt : evts)
+        {
+            if ((int64_t)evt.res < 0)
+                return (int)(int64_t)evt.res;
+            // a short read, e.g. past the end of the file, would leave stale
+            // bytes in the caller's buffers
+            const size_t j = (size_t)(evt.obj - cb.data());
+            if ((uint64_t)evt.res != runs[base + j].len)
+                return -EIO;
+        }
+    }
+    return 0;
+}
+
+std::vector<CoalescedRead> coalesce_reads(std::vector<const AlignedRead *> reqs)
+{
+    std::sort(reqs.begin(), reqs.end(),
+              [](const AlignedRead *a, const AlignedRead *b) { return a->offset < b->offset; });
+
+    std::vector<CoalescedRead> runs;
+    uint64_t run_end = 0;
+    for (const AlignedRead *req : reqs)
+    {
+        if (runs.empty() || req->offset != run_end || runs.back().iovecs.size() >= MAX_COALESCED_IOVECS)
+            runs.push_back({req->offset, 0, {}});
+        runs.back().iovecs.push_back({req->buf, req->len});
+        runs.back().len += req->len;
+        run_end = req->offset + req->len;
+    }
+    return runs;
+}
+
+ScheduledAlignedFileReader::ScheduledAlignedFileReader(std::shared_ptr<SharedIOScheduler> scheduler,
+                                                       const uint32_t weight)
+    : scheduler(scheduler)
+{
+    this->file_desc = -1;
+    this->tenant_id = this->scheduler->add_tenant(weight);
+}
+
+ScheduledAlignedFileReader::~ScheduledAlignedFileReader()
+{
+    if (this->file_desc != -1)
+    {
+        std::cerr << "close() not called" << std::endl;
+        ::close(this->file_desc);
+    }
+    this->scheduler->remove_tenant(this->tenant_id);
+}
+
+IOContext &ScheduledAlignedFileReader::get_ctx()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    if (ctx_map.find(std::this_thread::get_id()) == ctx_map.end())
+    {
+        std::cerr << "bad thread access; returning -1 as io_context_t" << std::endl;
+        return this->bad_ctx;
+    }
+    return ctx_map[std::this_thread::get_id()];
+}
+
+void ScheduledAlignedFileReader::register_thread()
+{
+    // The reads run on the scheduler's threads, which own the kernel
+    // contexts. Search threads only get a token that marks them registered.
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    ctx_map[std::this_thread::get_id()] = reinterpret_cast<io_context_t>(this);
+}
+
+void ScheduledAlignedFileReader::deregister_thread()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    ctx_map.erase(std::this_thread::get_id());
+}
+
+void ScheduledAlignedFileReader::deregister_all_threads()
+{
+    std::unique_lock<std::mutex> lk(ctx_mut);
+    ctx_map.clear();
+}
+
+void ScheduledAlignedFileReader::open(const std::string &fname)
+{
+    int flags = O_DIRECT | O_RDONLY | O_LARGEFILE;
+    this->file_desc = ::open(fname.c_str(), flags);
+    if (this->file_desc == -1)
+        throw diskann::ANNException("Failed to open " + fname + ": " + ::strerror(errno), -1, __FUNCSIG__, __FILE__,
+                                    __LINE__);
+    std::cerr << "Opened file : " << fname << std::endl;
+}
+
+void ScheduledAlignedFileReader::close()
+{
+    ::close(this->file_desc);
+    this->file_desc = -1;
+}
+
+void ScheduledAlignedFileReader::read(std::vector<AlignedRead> &read_reqs, IOContext & /*ctx*/, bool async)
+{
+    if (async == true)
+    {
+        diskann::cout << "Async currently not supported in linux." << std::endl;
+    }
+    assert(this->file_desc != -1);
+    this->scheduler->read(this->tenant_id, this->file_desc, read_reqs);
+}
+
+#endif
@@ -0,0 +1,106 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "distance.h"
+#include "in_mem_sq_data_store.h"
+#include "sq_distance.h"
+
+BOOST_AUTO_TEST_SUITE(InMemSQDataStore_tests)
+
+// Populates a store with random vectors, reads them back and checks every
+// dimension is within half a quantization step of the original.
+static void check_round_trip(const uint32_t num_bits)
+{
+    const size_t n_pts = 100, dim = 37;
+    const float range = 8.0f;
+    std::mt19937 rng(num_bits);
+    std::uniform_real_distribution<float> value(-range / 2, range / 2);
+    std::vector<float> data(n_pts * dim);
+    for (auto &x : data)
+        x = value(rng);
+
+    diskann::InMemSQDataStore<float> store(
+        (diskann::location_t)n_pts, dim,
+        std::unique_ptr<diskann::Distance<float>>(diskann::get_distance_function<float>(diskann::Metric::L2)),
+        num_bits);
+    store.populate_data(data.data(), (diskann::location_t)n_pts);
+
+    // The trained range of a dimension is at most the sampled range.
+    const float tolerance = range / (float)((1u << num_bits) - 1) / 2 + 1e-4f;
+    std::vector<float> decoded(dim);
+    for (size_t i = 0; i < n_pts; i++)
+    {
+        store.get_vector((diskann::location_t)i, decoded.data());
+        for (size_t d = 0; d < dim; d++)
+            BOOST_CHECK_SMALL(decoded[d] - data[i * dim + d], tolerance);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_8bit_round_trip)
+{
+    check_round_trip(8);
+}
+
+BOOST_AUTO_TEST_CASE(test_4bit_round_trip)
+{
+    check_round_trip(4);
+}
+
+BOOST_AUTO_TEST_CASE(test_unsupported_bits_rejected)
+{
+    BOOST_CHECK_THROW(diskann::InMemSQDataStore<float>(
+                          10, 16,
+                          std::unique_ptr<diskann::Distance<float>>(
+                              diskann::get_distance_function<float>(diskann::Metric::L2)),
+                          6),
+                      diskann::ANNException);
+}
+
+#ifdef USE_AVX2
+// Compares the AVX2 kernels against the scalar reference on random codes.
+template <bool IP> static void check_kernels(const uint32_t num_bits, const size_t aligned_dim)
+{
+    std::mt19937 rng(aligned_dim * num_bits + IP);
+    std::uniform_real_distribution<float> value(-2.0f, 2.0f);
+    std::vector<float> query(aligned_dim), vmin(aligned_dim), delta(aligned_dim);
+    for (size_t d = 0; d < aligned_dim; d++)
+    {
+        query[d] = value(rng);
+        vmin[d] = value(rng);
+        delta[d] = std::abs(value(rng)) / (float)((1u << num_bits) - 1);
+    }
+    std::vector<uint8_t> code(aligned_dim * num_bits / 8);
+    for (int trial = 0; trial < 20; trial++)
+    {
+        for (auto &c : code)
+            c = (uint8_t)(rng() & 0xFF);
+        const float expected =
+            diskann::sq_distance_scalar<IP>(query.data(), code.data(), num_bits, vmin.data(), delta.data(), aligned_dim);
+        const float actual =
+            num_bits == 8
+                ? diskann::sq8_distance_avx2<IP>(query.data(), code.data(), vmin.data(), delta.data(), aligned_dim)
+                : diskann::sq4_distance_avx2<IP>(query.data(), code.data(), vmin.data(), delta.data(), aligned_dim);
+        // the kernels only differ in summation order
+        BOOST_CHECK_SMALL(actual - expected, 1e-5f * (float)aligned_dim * 64);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_avx2_kernels_match_scalar)
+{
+    for (size_t aligned_dim : {16, 32, 128, 400})
+    {
+        check_kernels<false>(8, aligned_dim);
+        check_kernels<true>(8, aligned_dim);
+        check_kernels<false>(4, aligned_dim);
+        check_kernels<true>(4, aligned_dim);
+    }
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
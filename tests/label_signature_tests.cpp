@@ -0,0 +1,156 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#include "label_signature.h"
+
+BOOST_AUTO_TEST_SUITE(LabelSignature_tests)
+
+const uint32_t universal_label = 0;
+
+// Same decision as Index::detect_common_filters, over sorted label lists.
+static bool reference_common_filters(const std::vector<uint32_t> &point_labels, const bool search_invocation,
+                                     const bool use_universal_label, const std::vector<uint32_t> &filters)
+{
+    std::vector<uint32_t> common;
+    std::set_intersection(filters.begin(), filters.end(), point_labels.begin(), point_labels.end(),
+                          std::back_inserter(common));
+    if (!common.empty())
+        return true;
+    if (!use_universal_label)
+        return false;
+    const bool point_universal =
+        std::find(point_labels.begin(), point_labels.end(), universal_label) != point_labels.end();
+    const bool filter_universal = std::find(filters.begin(), filters.end(), universal_label) != filters.end();
+    return point_universal || (!search_invocation && filter_universal);
+}
+
+static std::vector<uint32_t> random_labels(std::mt19937 &rng, const uint32_t max_labels, const uint32_t num_labels)
+{
+    std::vector<uint32_t> labels;
+    const uint32_t count = rng() % (max_labels + 1);
+    for (uint32_t i = 0; i < count; i++)
+        labels.push_back(rng() % num_labels);
+    std::sort(labels.begin(), labels.end());
+    labels.erase(std::unique(labels.begin(), labels.end()), labels.end());
+    return labels;
+}
+
+// Random ids into signatures; num_ids need not be a multiple of 4.
+static std::vector<uint32_t> random_ids(std::mt19937 &rng, const size_t num_ids, const size_t num_pts)
+{
+    std::vector<uint32_t> ids(num_ids);
+    for (auto &id : ids)
+        id = (uint32_t)(rng() % num_pts);
+    return ids;
+}
+
+// Hits of one id at a time, which never enters the vectorized loop.
+static std::vector<uint8_t> one_by_one_hits(const std::vector<uint64_t> &signatures, const std::vector<uint32_t> &ids,
+                                            const diskann::LabelSignaturePredicate &predicate)
+{
+    std::vector<uint8_t> hits(ids.size());
+    for (size_t i = 0; i < ids.size(); i++)
+        diskann::label_signature_hits(signatures.data(), ids.data() + i, 1, predicate, hits.data() + i);
+    return hits;
+}
+
+BOOST_AUTO_TEST_CASE(test_batched_hits_match_one_by_one)
+{
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<uint64_t> bits;
+    std::vector<uint64_t> signatures(257);
+    for (auto &sig : signatures)
+        sig = bits(rng) & bits(rng); // sparse enough for some misses
+    signatures[3] = 0;
+    signatures[4] = ~0ULL;
+
+    for (size_t num_ids : {0, 1, 3, 5, 6, 7, 13, 101})
+    {
+        const std::vector<uint32_t> ids = random_ids(rng, num_ids, signatures.size());
+        for (uint32_t num_masks = 0; num_masks < 4; num_masks++)
+        {
+            diskann::LabelSignaturePredicate predicate;
+            for (uint32_t m = 0; m < num_masks; m++)
+                predicate.masks.push_back(bits(rng) & bits(rng) & bits(rng));
+            std::vector<uint8_t> hits(num_ids);
+            diskann::label_signature_hits(signatures.data(), ids.data(), num_ids, predicate, hits.data());
+            BOOST_TEST(hits == one_by_one_hits(signatures, ids, predicate), boost::test_tools::per_element());
+
+            // the zero mask lets every point through
+            predicate.add_all();
+            diskann::label_signature_hits(signatures.data(), ids.data(), num_ids, predicate, hits.data());
+            BOOST_CHECK(std::all_of(hits.begin(), hits.end(), [](uint8_t hit) { return hit == 1; }));
+        }
+    }
+}
+
+// Candidates filtered by signature hits then exact verification, as in
+// Index::filter_candidates_by_labels, keep exactly the points that
+// detect_common_filters accepts.
+static void check_filtering(const bool search_invocation, const bool use_universal_label)
+{
+    const uint32_t num_labels = 50;
+    const size_t num_pts = 500;
+    std::mt19937 rng(search_invocation * 2 + use_universal_label);
+
+    std::vector<std::vector<uint32_t>> pts_to_labels(num_pts);
+    std::vector<uint64_t> signatures(num_pts);
+    for (size_t i = 0; i < num_pts; i++)
+    {
+        pts_to_labels[i] = random_labels(rng, 4, num_labels);
+        signatures[i] = diskann::label_signature(pts_to_labels[i]);
+    }
+
+    for (int trial = 0; trial < 50; trial++)
+    {
+        std::vector<uint32_t> filters = random_labels(rng, 3, num_labels);
+        if (trial % 10 == 0 && std::find(filters.begin(), filters.end(), universal_label) == filters.end())
+        {
+            filters.push_back(universal_label);
+            std::sort(filters.begin(), filters.end());
+        }
+        const diskann::LabelSignaturePredicate predicate =
+            diskann::make_label_predicate(filters, search_invocation, use_universal_label, universal_label);
+        const std::vector<uint32_t> ids = random_ids(rng, 4 * trial + 1 + trial % 3, num_pts);
+        std::vector<uint8_t> hits(ids.size());
+        diskann::label_signature_hits(signatures.data(), ids.data(), ids.size(), predicate, hits.data());
+
+        for (size_t i = 0; i < ids.size(); i++)
+        {
+            const bool expected =
+                reference_common_filters(pts_to_labels[ids[i]], search_invocation, use_universal_label, filters);
+            // signatures may only let false positives through
+            if (expected)
+                BOOST_CHECK_EQUAL(hits[i], 1);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_no_false_negatives_at_search)
+{
+    check_filtering(true, true);
+    check_filtering(true, false);
+}
+
+BOOST_AUTO_TEST_CASE(test_no_false_negatives_at_build)
+{
+    check_filtering(false, true);
+    check_filtering(false, false);
+}
+
+BOOST_AUTO_TEST_CASE(test_universal_filter_passes_all_at_build)
+{
+    const std::vector<uint32_t> filters = {universal_label, 7};
+    BOOST_CHECK(diskann::make_label_predicate(filters, false, true, universal_label).masks ==
+                std::vector<uint64_t>{0});
+    BOOST_CHECK_EQUAL(diskann::make_label_predicate(filters, true, true, universal_label).masks.size(), 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
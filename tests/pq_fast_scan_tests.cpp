@@ -0,0 +1,75 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+#include <vector>
+
+#include "pq_fast_scan.h"
+
+BOOST_AUTO_TEST_SUITE(PQFastScan_tests)
+
+// Sums the lut entries of every point straight from its unpacked codes.
+static std::vector<float> reference_dists(const std::vector<uint8_t> &codes, const size_t n_pts,
+                                          const size_t n_chunks, const std::vector<uint8_t> &lut)
+{
+    std::vector<float> dists(n_pts);
+    for (size_t i = 0; i < n_pts; i++)
+    {
+        uint32_t sum = 0;
+        for (size_t c = 0; c < n_chunks; c++)
+            sum += lut[c * NUM_PQ4_CENTROIDS + codes[i * n_chunks + c]];
+        dists[i] = (float)sum;
+    }
+    return dists;
+}
+
+static void check_lookup(const size_t n_pts, const size_t n_chunks, const uint8_t max_lut_entry)
+{
+    std::mt19937 rng(n_chunks);
+    std::vector<uint8_t> codes(n_pts * n_chunks);
+    for (auto &code : codes)
+        code = (uint8_t)(rng() % NUM_PQ4_CENTROIDS);
+    std::vector<uint8_t> lut(2 * NUM_PQ4_CENTROIDS * diskann::pq4_code_bytes(n_chunks), 0);
+    for (size_t c = 0; c < n_chunks; c++)
+        for (size_t k = 0; k < NUM_PQ4_CENTROIDS; k++)
+            lut[c * NUM_PQ4_CENTROIDS + k] = (uint8_t)(max_lut_entry - rng() % 4);
+
+    std::vector<uint8_t> packed(n_pts * diskann::pq4_code_bytes(n_chunks));
+    diskann::pack_pq4_codes(codes.data(), n_pts, n_chunks, packed.data());
+    std::vector<uint32_t> ids(n_pts);
+    for (size_t i = 0; i < n_pts; i++)
+        ids[i] = (uint32_t)i;
+    std::vector<uint8_t> blocked(diskann::fast_scan_codes_bytes(n_pts, n_chunks));
+    diskann::aggregate_fast_scan_codes(ids.data(), n_pts, packed.data(), n_chunks, blocked.data());
+
+    std::vector<float> simd(n_pts), scalar(n_pts);
+    diskann::fast_scan_dist_lookup(blocked.data(), n_pts, n_chunks, lut.data(), 1.0f, 0.0f, simd.data());
+    diskann::fast_scan_dist_lookup_scalar(blocked.data(), n_pts, n_chunks, lut.data(), 1.0f, 0.0f, scalar.data());
+    const std::vector<float> expected = reference_dists(codes, n_pts, n_chunks, lut);
+
+    for (size_t i = 0; i < n_pts; i++)
+    {
+        BOOST_TEST(simd[i] == expected[i]);
+        BOOST_TEST(scalar[i] == expected[i]);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_few_chunks)
+{
+    check_lookup(45, 16, 255);
+}
+
+// 384 chunks of entries near 255 sum to about 98000, past 16 bits
+BOOST_AUTO_TEST_CASE(test_many_chunks_no_overflow)
+{
+    check_lookup(70, 384, 255);
+}
+
+BOOST_AUTO_TEST_CASE(test_odd_chunk_count)
+{
+    check_lookup(33, 513, 255);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <restapi/search_batcher.h>
+
+BOOST_AUTO_TEST_SUITE(SearchBatcher_tests)
+
+// A search that sleeps for sleep_ms and returns id as its only result.
+static diskann::SearchBatcher::SearchFunction make_search(const unsigned id, const uint32_t sleep_ms = 0)
+{
+    return [id, sleep_ms]() {
+        if (sleep_ms > 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(sleep_ms));
+        const float distance = (float)id;
+        return std::vector<diskann::SearchResult>{diskann::SearchResult(1, 0, &id, &distance)};
+    };
+}
+
+BOOST_AUTO_TEST_CASE(test_results_and_exceptions)
+{
+    diskann::SearchBatcher batcher(4, 8, 1000);
+    std::vector<pplx::task<std::vector<diskann::SearchResult>>> tasks;
+    for (unsigned i = 0; i < 20; i++)
+        tasks.push_back(batcher.submit(make_search(i)));
+    auto failing = batcher.submit([]() -> std::vector<diskann::SearchResult> {
+        throw std::runtime_error("search failed");
+    });
+
+    for (unsigned i = 0; i < 20; i++)
+    {
+        std::vector<diskann::SearchResult> results = tasks[i].get();
+        BOOST_TEST_REQUIRE(results.size() == 1u);
+        BOOST_TEST(results[0].get_indices()[0] == i);
+    }
+    BOOST_CHECK_THROW(failing.get(), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_full_batch_does_not_wait)
+{
+    // a full batch is dispatched at once, long before max_wait
+    diskann::SearchBatcher batcher(2, 4, 10 * 1000 * 1000);
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<pplx::task<std::vector<diskann::SearchResult>>> tasks;
+    for (unsigned i = 0; i < 4; i++)
+        tasks.push_back(batcher.submit(make_search(i)));
+    for (auto &task : tasks)
+        task.wait();
+    const auto elapsed_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    BOOST_TEST(elapsed_ms < 5000);
+}
+
+BOOST_AUTO_TEST_CASE(test_deadline_from_oldest_arrival)
+{
+    // A search that arrives while a full batch runs is dispatched max_wait
+    // after its arrival, not max_wait after the dispatcher gets to it.
+    const uint32_t batch_ms = 500, max_wait_ms = 1000;
+    diskann::SearchBatcher batcher(2, 2, max_wait_ms * 1000);
+    const auto start = std::chrono::steady_clock::now();
+    auto first = batcher.submit(make_search(0, batch_ms));
+    auto second = batcher.submit(make_search(1, batch_ms));
+    std::this_thread::sleep_for(std::chrono::milliseconds(batch_ms / 5));
+    auto late = batcher.submit(make_search(2));
+    late.wait();
+    const auto elapsed_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    BOOST_TEST(first.get()[0].get_indices()[0] == 0u);
+    BOOST_TEST(second.get()[0].get_indices()[0] == 1u);
+    BOOST_TEST(late.get()[0].get_indices()[0] == 2u);
+    BOOST_TEST(elapsed_ms >= max_wait_ms * 3 / 4);
+    BOOST_TEST(elapsed_ms < batch_ms + max_wait_ms);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
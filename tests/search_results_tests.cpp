@@ -0,0 +1,65 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <cfloat>
+#include <vector>
+
+#include "search_results.h"
+
+BOOST_AUTO_TEST_SUITE(SearchResults_tests)
+
+static std::vector<uint32_t> ids_of(const std::vector<diskann::Neighbor> &results)
+{
+    std::vector<uint32_t> ids;
+    for (auto &nn : results)
+        ids.push_back(nn.id);
+    return ids;
+}
+
+BOOST_AUTO_TEST_CASE(test_append_unexpanded_results)
+{
+    diskann::NeighborPriorityQueue candidates(8);
+    candidates.insert(diskann::Neighbor(9, 4.0f));
+    candidates.insert(diskann::Neighbor(2, 1.5f));
+    candidates.insert(diskann::Neighbor(7, 3.0f));
+    candidates.insert(diskann::Neighbor(5, 2.0f));
+
+    // already found points are not repeated, the rest follow closest first
+    std::vector<diskann::Neighbor> results = {diskann::Neighbor(1, 1.0f), diskann::Neighbor(2, 1.5f)};
+    diskann::append_unexpanded_results(results, candidates, 4);
+    BOOST_TEST(ids_of(results) == std::vector<uint32_t>({1, 2, 5, 7}), boost::test_tools::per_element());
+
+    // never more than k, and full results are left alone
+    diskann::append_unexpanded_results(results, candidates, 3);
+    BOOST_CHECK_EQUAL(results.size(), 4);
+
+    // fewer candidates than k
+    results.clear();
+    diskann::append_unexpanded_results(results, candidates, 10);
+    BOOST_TEST(ids_of(results) == std::vector<uint32_t>({2, 5, 7, 9}), boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_CASE(test_pad_search_results)
+{
+    const size_t k = 5;
+    std::vector<uint64_t> indices = {3, 8, 0, 0, 0};
+    std::vector<float> distances = {0.5f, 0.7f, 0, 0, 0};
+    diskann::pad_search_results(indices.data(), distances.data(), 2, k);
+    BOOST_TEST(indices == std::vector<uint64_t>({3, 8, UINT32_MAX, UINT32_MAX, UINT32_MAX}),
+               boost::test_tools::per_element());
+    BOOST_TEST(distances == std::vector<float>({0.5f, 0.7f, FLT_MAX, FLT_MAX, FLT_MAX}),
+               boost::test_tools::per_element());
+
+    // without distances, and with nothing found
+    diskann::pad_search_results(indices.data(), nullptr, 0, k);
+    BOOST_TEST(indices == std::vector<uint64_t>(k, UINT32_MAX), boost::test_tools::per_element());
+
+    // nothing to pad when k points were found
+    std::vector<uint64_t> full = {1, 2, 3};
+    diskann::pad_search_results(full.data(), nullptr, 3, 3);
+    BOOST_TEST(full == std::vector<uint64_t>({1, 2, 3}), boost::test_tools::per_element());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "search_thread_pool.h"
+
+BOOST_AUTO_TEST_SUITE(SearchThreadPool_tests)
+
+// Runs parallel_for and checks that every item is visited exactly once, by
+// a valid thread id.
+static void check_coverage(diskann::SearchThreadPool &pool, const size_t n, const size_t chunk_size)
+{
+    std::vector<std::atomic<uint32_t>> visits(n);
+    std::atomic<bool> bad_thread_id{false};
+    pool.parallel_for(n, chunk_size, [&](size_t i, uint32_t thread_id) {
+        visits[i]++;
+        if (thread_id >= pool.num_threads())
+            bad_thread_id = true;
+    });
+    BOOST_TEST(!bad_thread_id);
+    for (size_t i = 0; i < n; i++)
+        BOOST_TEST_REQUIRE(visits[i].load() == 1u, "item " << i << " of " << n << ", chunk " << chunk_size);
+}
+
+BOOST_AUTO_TEST_CASE(test_coverage)
+{
+    diskann::SearchThreadPool pool(4, false);
+    check_coverage(pool, 0, 8);
+    check_coverage(pool, 1, 8);
+    check_coverage(pool, 1000, 8);
+    check_coverage(pool, 1000, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_uneven_chunks)
+{
+    // batches that do not split evenly over the threads or into chunks
+    diskann::SearchThreadPool pool(3, false);
+    check_coverage(pool, 2, 8);
+    check_coverage(pool, 7, 2);
+    check_coverage(pool, 1001, 8);
+    check_coverage(pool, 1001, 64);
+    check_coverage(pool, 10, 1000);
+}
+
+BOOST_AUTO_TEST_CASE(test_more_threads_than_items)
+{
+    diskann::SearchThreadPool pool(8, false);
+    check_coverage(pool, 3, 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_exception_propagation)
+{
+    diskann::SearchThreadPool pool(4, false);
+    BOOST_CHECK_THROW(pool.parallel_for(1000, 8,
+                                        [](size_t i, uint32_t) {
+                                            if (i == 517)
+                                                throw std::runtime_error("query failed");
+                                        }),
+                      std::runtime_error);
+
+    // the pool stays usable after a failed batch
+    check_coverage(pool, 1000, 8);
+}
+
+BOOST_AUTO_TEST_CASE(test_run_on_each_thread)
+{
+    diskann::SearchThreadPool pool(4, false);
+    std::vector<std::atomic<uint32_t>> calls(pool.num_threads());
+    pool.run_on_each_thread([&](uint32_t thread_id) { calls[thread_id]++; });
+    for (auto &count : calls)
+        BOOST_TEST(count.load() == 1u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,89 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "sector_labels.h"
+
+BOOST_AUTO_TEST_SUITE(SectorLabels_tests)
+
+// The filter check of the in-memory label lists, which sector labels have
+// to reproduce.
+static uint32_t label_file_filter_size(const std::vector<uint32_t> &labels, const std::vector<uint32_t> &filter_labels,
+                                       const bool use_universal_label, const uint32_t universal_label)
+{
+    uint32_t common_size = 0;
+    for (const uint32_t label : labels)
+    {
+        if (use_universal_label && label == universal_label)
+            return (uint32_t)filter_labels.size();
+        if (std::binary_search(filter_labels.begin(), filter_labels.end(), label))
+            common_size++;
+    }
+    return common_size;
+}
+
+static std::string to_label_line(const std::vector<uint32_t> &labels)
+{
+    std::string line;
+    for (size_t i = 0; i < labels.size(); i++)
+        line += (i > 0 ? "," : "") + std::to_string(labels[i]);
+    return line;
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_label_line)
+{
+    BOOST_TEST((diskann::parse_label_line<uint32_t>("3,1,,7\r") == std::vector<uint32_t>{3, 1, 7}));
+    BOOST_TEST((diskann::parse_label_line<uint32_t>("5,6\tignored,8") == std::vector<uint32_t>{5, 6}));
+    BOOST_TEST(diskann::parse_label_line<uint32_t>("").empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_sector_and_spilled_labels_match_label_file)
+{
+    const uint64_t max_node_labels = 4;
+    const uint32_t num_labels = 20, universal_label = 0;
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<uint32_t> label_dist(0, num_labels - 1), count_dist(1, 2 * max_node_labels);
+    std::vector<uint32_t> label_block(1 + max_node_labels);
+
+    size_t num_spilled = 0;
+    for (size_t point = 0; point < 2000; point++)
+    {
+        std::vector<uint32_t> labels(count_dist(gen));
+        for (auto &label : labels)
+            label = label_dist(gen);
+        labels = diskann::parse_label_line<uint32_t>(to_label_line(labels));
+
+        // what create_disk_layout writes and what the index keeps in memory
+        diskann::write_label_block(labels, label_block.data(), max_node_labels);
+        const bool spilled = diskann::label_block_spilled(label_block.data(), max_node_labels);
+        BOOST_TEST_REQUIRE(spilled == (labels.size() > max_node_labels));
+        num_spilled += spilled;
+
+        std::vector<uint32_t> filter_labels(1 + point % 3);
+        for (auto &label : filter_labels)
+            label = label_dist(gen);
+        std::sort(filter_labels.begin(), filter_labels.end());
+        filter_labels.erase(std::unique(filter_labels.begin(), filter_labels.end()), filter_labels.end());
+
+        for (const bool use_universal_label : {false, true})
+        {
+            const uint32_t expected =
+                label_file_filter_size(labels, filter_labels, use_universal_label, universal_label);
+            const uint32_t actual =
+                diskann::label_block_filter_size(label_block.data(), max_node_labels, spilled ? &labels : nullptr,
+                                                 filter_labels, use_universal_label, universal_label);
+            BOOST_TEST_REQUIRE(actual == expected, "point " << point << " labels " << to_label_line(labels));
+        }
+    }
+    // both kinds of nodes were checked
+    BOOST_TEST(num_spilled > 0u);
+    BOOST_TEST(num_spilled < 2000u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,177 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT license.
+
+#ifndef _WINDOWS
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "shared_io_scheduler.h"
+
+BOOST_AUTO_TEST_SUITE(SharedIOScheduler_tests)
+
+struct TestBatch
+{
+    int fd;
+    uint64_t cost;
+    uint32_t tenant;
+};
+
+// Pops until the queue is empty and returns the sectors served per tenant
+// up to the moment the first tenant ran out of batches.
+static std::vector<uint64_t> drain_while_backlogged(DeficitRoundRobinQueue<TestBatch> &queue,
+                                                    std::vector<uint64_t> queued)
+{
+    std::vector<uint64_t> served(queued.size(), 0);
+    bool backlogged = true;
+    while (!queue.empty())
+    {
+        std::vector<TestBatch *> batches = queue.pop();
+        BOOST_TEST_REQUIRE(!batches.empty());
+        BOOST_TEST(batches.size() <= (size_t)MAX_GROUPED_BATCHES);
+        for (const TestBatch *batch : batches)
+        {
+            BOOST_TEST(batch->tenant == batches.front()->tenant);
+            if (backlogged)
+                served[batch->tenant] += batch->cost;
+            queued[batch->tenant]--;
+        }
+        for (const uint64_t left : queued)
+            backlogged = backlogged && left > 0;
+    }
+    return served;
+}
+
+BOOST_AUTO_TEST_CASE(test_drr_shares_follow_weights)
+{
+    DeficitRoundRobinQueue<TestBatch> queue;
+    const uint32_t light = queue.add_tenant(1);
+    const uint32_t heavy = queue.add_tenant(3);
+
+    const size_t num_batches = 240;
+    std::vector<TestBatch> batches;
+    batches.reserve(2 * num_batches);
+    for (size_t i = 0; i < num_batches; i++)
+    {
+        batches.push_back({3, 1, light});
+        batches.push_back({4, 1, heavy});
+    }
+    for (auto &batch : batches)
+        BOOST_TEST_REQUIRE(queue.push(batch.tenant, &batch));
+
+    const std::vector<uint64_t> served = drain_while_backlogged(queue, {num_batches, num_batches});
+    // while both are backlogged the heavy tenant gets three times the
+    // sectors, up to one quantum of the turn in progress
+    BOOST_TEST(served[heavy] == num_batches);
+    BOOST_TEST(served[heavy] + 3 * DRR_QUANTUM_SECTORS >= 3 * served[light]);
+    BOOST_TEST(served[heavy] <= 3 * served[light] + 3 * DRR_QUANTUM_SECTORS);
+}
+
+BOOST_AUTO_TEST_CASE(test_drr_large_batches_and_idle_credit)
+{
+    DeficitRoundRobinQueue<TestBatch> queue;
+    const uint32_t big = queue.add_tenant(1);
+    const uint32_t small = queue.add_tenant(1);
+    BOOST_TEST(!queue.push(small + 1, nullptr));
+
+    // a batch larger than one quantum is served once enough turns add up
+    TestBatch large{3, 3 * DRR_QUANTUM_SECTORS, big};
+    std::vector<TestBatch> smalls(8, TestBatch{4, DRR_QUANTUM_SECTORS, small});
+    BOOST_TEST_REQUIRE(queue.push(big, &large));
+    for (auto &batch : smalls)
+        BOOST_TEST_REQUIRE(queue.push(small, &batch));
+
+    size_t smalls_before_large = 0;
+    while (true)
+    {
+        std::vector<TestBatch *> batches = queue.pop();
+        BOOST_TEST_REQUIRE(batches.size() == 1u);
+        if (batches.front() == &large)
+            break;
+        smalls_before_large++;
+    }
+    BOOST_TEST(smalls_before_large == 2u);
+
+    // a tenant whose queue ran dry does not bank the turns it skipped, so it
+    // waits for a full turn of the other tenant again
+    while (!queue.empty())
+        queue.pop();
+    for (auto &batch : smalls)
+        BOOST_TEST_REQUIRE(queue.push(small, &batch));
+    for (size_t i = 0; i < smalls.size(); i++)
+        BOOST_TEST_REQUIRE(queue.pop().size() == 1u);
+    TestBatch again{3, 2 * DRR_QUANTUM_SECTORS, big};
+    BOOST_TEST_REQUIRE(queue.push(big, &again));
+    for (auto &batch : smalls)
+        BOOST_TEST_REQUIRE(queue.push(small, &batch));
+    BOOST_TEST(queue.pop().front() == &smalls[0]);
+    BOOST_TEST(queue.pop().front() == &again);
+}
+
+BOOST_AUTO_TEST_CASE(test_drr_groups_only_same_file)
+{
+    DeficitRoundRobinQueue<TestBatch> queue;
+    const uint32_t tenant = queue.add_tenant(1);
+    std::vector<TestBatch> batches = {{3, 1, tenant}, {3, 1, tenant}, {5, 1, tenant}, {3, 1, tenant}};
+    for (auto &batch : batches)
+        BOOST_TEST_REQUIRE(queue.push(tenant, &batch));
+
+    std::vector<TestBatch *> first = queue.pop();
+    BOOST_TEST_REQUIRE(first.size() == 2u);
+    BOOST_TEST(first[0] == &batches[0]);
+    BOOST_TEST(first[1] == &batches[1]);
+    std::vector<TestBatch *> second = queue.pop();
+    BOOST_TEST_REQUIRE(second.size() == 1u);
+    BOOST_TEST(second[0] == &batches[2]);
+    BOOST_TEST(queue.pop().size() == 1u);
+    BOOST_TEST(queue.empty());
+    BOOST_TEST(queue.pop().empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_coalesce_adjacent_reads)
+{
+    alignas(4096) static char buf[16 * 4096];
+    auto read_at = [](const uint64_t sector, const uint64_t num_sectors) {
+        return AlignedRead(sector * 4096, num_sectors * 4096, buf + sector * 4096);
+    };
+    // out of order, a gap after sector 2, and a two sector request
+    std::vector<AlignedRead> reqs = {read_at(1, 1), read_at(5, 2), read_at(0, 1), read_at(2, 1), read_at(7, 1)};
+    std::vector<const AlignedRead *> ptrs;
+    for (const auto &req : reqs)
+        ptrs.push_back(&req);
+
+    std::vector<CoalescedRead> runs = coalesce_reads(ptrs);
+    BOOST_TEST_REQUIRE(runs.size() == 2u);
+    BOOST_TEST(runs[0].offset == 0u);
+    BOOST_TEST(runs[0].len == 3u * 4096);
+    BOOST_TEST_REQUIRE(runs[0].iovecs.size() == 3u);
+    for (size_t i = 0; i < 3; i++)
+        BOOST_TEST(runs[0].iovecs[i].iov_base == (void *)(buf + i * 4096));
+    BOOST_TEST(runs[1].offset == 5u * 4096);
+    BOOST_TEST(runs[1].len == 3u * 4096);
+    BOOST_TEST(runs[1].iovecs.size() == 2u);
+}
+
+BOOST_AUTO_TEST_CASE(test_coalesce_limits_iovecs)
+{
+    const size_t num_reqs = MAX_COALESCED_IOVECS + 1;
+    alignas(512) static char buf[num_reqs * 512];
+    std::vector<AlignedRead> reqs;
+    for (size_t i = 0; i < num_reqs; i++)
+        reqs.emplace_back(i * 512, 512, buf + i * 512);
+    std::vector<const AlignedRead *> ptrs;
+    for (const auto &req : reqs)
+        ptrs.push_back(&req);
+
+    std::vector<CoalescedRead> runs = coalesce_reads(ptrs);
+    BOOST_TEST_REQUIRE(runs.size() == 2u);
+    BOOST_TEST(runs[0].iovecs.size() == (size_t)MAX_COALESCED_IOVECS);
+    BOOST_TEST(runs[1].offset == (uint64_t)MAX_COALESCED_IOVECS * 512);
+    BOOST_TEST(runs[1].len == 512u);
+    BOOST_TEST(coalesce_reads({}).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif